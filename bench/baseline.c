@@ -0,0 +1,482 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "baseline.h"
+
+/*
+    Just enough of a JSON reader for baselines. Values the baseline doesn't need are skipped
+    whatever they hold, but \u escapes in strings are only read for ASCII characters.
+*/
+typedef struct
+{
+    const char* p;
+} Reader;
+
+static void SkipSpace(Reader* r)
+{
+    while(*r->p == ' ' || *r->p == '\t' || *r->p == '\r' || *r->p == '\n')
+    {
+        r->p++;
+    }
+}
+
+/* Moves past the given character, if it's next. */
+static evo_bool Accept(Reader* r, char c)
+{
+    SkipSpace(r);
+    if(*r->p != c)
+    {
+        return EVO_FALSE;
+    }
+    r->p++;
+    return EVO_TRUE;
+}
+
+/* Moves past the given word, if it's next. */
+static evo_bool AcceptLiteral(Reader* r, const char* word)
+{
+    size_t n = strlen(word);
+
+    if(strncmp(r->p, word, n))
+    {
+        return EVO_FALSE;
+    }
+    r->p += n;
+    return EVO_TRUE;
+}
+
+/* Reads the character an escape stands for, after its backslash. Returns -1 if it isn't one this reads. */
+static int ReadEscape(Reader* r)
+{
+    /* Each escape, followed by the character it stands for. */
+    static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+    const char* e;
+    char digits[5];
+    long code;
+    int i;
+
+    if(*r->p == 'u')
+    {
+        /* The end of the text isn't a hex digit, so this stops there. */
+        for(i = 1; i <= 4; i++)
+        {
+            if(!isxdigit((unsigned char) r->p[i]))
+            {
+                return -1;
+            }
+        }
+        memcpy(digits, r->p + 1, 4);
+        digits[4] = 0;
+        code = strtol(digits, NULL, 16);
+        if(code <= 0 || code > 0x7F)
+        {
+            return -1;
+        }
+        r->p += 5;
+        return (int) code;
+    }
+    for(e = escapes; *e; e += 2)
+    {
+        if(*r->p == *e)
+        {
+            r->p++;
+            return e[1];
+        }
+    }
+    return -1;
+}
+
+/* Returns a copy of the next string, or NULL if there isn't one. */
+static char* ReadString(Reader* r)
+{
+    char* s;
+    int c;
+    evo_uint n = 0;
+    evo_uint capacity = 16;
+
+    if(!Accept(r, '"'))
+    {
+        return NULL;
+    }
+    s = malloc(capacity);
+    while(*r->p != '"')
+    {
+        if(!*r->p)
+        {
+            free(s);
+            return NULL;
+        }
+        c = (unsigned char) *r->p++;
+        if(c == '\\' && (c = ReadEscape(r)) < 0)
+        {
+            free(s);
+            return NULL;
+        }
+        if(n + 1 == capacity)
+        {
+            capacity *= 2;
+            s = realloc(s, capacity);
+        }
+        s[n++] = (char) c;
+    }
+    s[n] = 0;
+    r->p++;
+    return s;
+}
+
+static evo_bool ReadNumber(Reader* r, double* value)
+{
+    char* end;
+
+    SkipSpace(r);
+    *value = strtod(r->p, &end);
+    if(end == r->p)
+    {
+        return EVO_FALSE;
+    }
+    r->p = end;
+    return EVO_TRUE;
+}
+
+static evo_bool ReadUint(Reader* r, evo_uint* value)
+{
+    double d;
+
+    if(!ReadNumber(r, &d) || d < 0)
+    {
+        return EVO_FALSE;
+    }
+    *value = (evo_uint) d;
+    return EVO_TRUE;
+}
+
+/*
+    Reads the key of the next member of an object, after its opening brace or a comma.
+    Returns NULL at the end of the object, or if it's malformed, with *ok set to say which.
+*/
+static char* NextKey(Reader* r, evo_bool first, evo_bool* ok)
+{
+    char* key;
+
+    *ok = EVO_TRUE;
+    if(first ? Accept(r, '}') : !Accept(r, ','))
+    {
+        *ok = first || Accept(r, '}');
+        return NULL;
+    }
+    key = ReadString(r);
+    if(!key || !Accept(r, ':'))
+    {
+        free(key);
+        *ok = EVO_FALSE;
+        return NULL;
+    }
+    return key;
+}
+
+static evo_bool SkipValue(Reader* r)
+{
+    char* s;
+    char* key;
+    double d;
+    evo_bool ok;
+    evo_bool first = EVO_TRUE;
+
+    SkipSpace(r);
+    switch(*r->p)
+    {
+        case '"':
+            s = ReadString(r);
+            free(s);
+            return s != NULL;
+        case '[':
+            r->p++;
+            if(Accept(r, ']'))
+            {
+                return EVO_TRUE;
+            }
+            do
+            {
+                if(!SkipValue(r))
+                {
+                    return EVO_FALSE;
+                }
+            } while(Accept(r, ','));
+            return Accept(r, ']');
+        case '{':
+            r->p++;
+            while((key = NextKey(r, first, &ok)) != NULL)
+            {
+                first = EVO_FALSE;
+                free(key);
+                if(!SkipValue(r))
+                {
+                    return EVO_FALSE;
+                }
+            }
+            return ok;
+        case 't':
+            return AcceptLiteral(r, "true");
+        case 'f':
+            return AcceptLiteral(r, "false");
+        case 'n':
+            return AcceptLiteral(r, "null");
+        default:
+            return ReadNumber(r, &d);
+    }
+}
+
+/* Reads an array of numbers, into a newly allocated array. */
+static evo_bool ReadSamples(Reader* r, double** samples, evo_uint* count)
+{
+    evo_uint capacity = 8;
+    double* values;
+
+    if(!Accept(r, '['))
+    {
+        return EVO_FALSE;
+    }
+    values = malloc(sizeof(double) * capacity);
+    *count = 0;
+    if(!Accept(r, ']'))
+    {
+        do
+        {
+            if(*count == capacity)
+            {
+                capacity *= 2;
+                values = realloc(values, sizeof(double) * capacity);
+            }
+            if(!ReadNumber(r, &values[*count]))
+            {
+                free(values);
+                return EVO_FALSE;
+            }
+            (*count)++;
+        } while(Accept(r, ','));
+        if(!Accept(r, ']'))
+        {
+            free(values);
+            return EVO_FALSE;
+        }
+    }
+    free(*samples);
+    *samples = values;
+    return EVO_TRUE;
+}
+
+/* Reads the wall time summary, which only needs its samples. */
+static evo_bool ReadWall(Reader* r, BaselineResult* result)
+{
+    char* key;
+    evo_bool ok;
+    evo_bool first = EVO_TRUE;
+
+    if(!Accept(r, '{'))
+    {
+        return EVO_FALSE;
+    }
+    while((key = NextKey(r, first, &ok)) != NULL)
+    {
+        first = EVO_FALSE;
+        ok = !strcmp(key, "samples") ? ReadSamples(r, &result->wall, &result->sampleCount) : SkipValue(r);
+        free(key);
+        if(!ok)
+        {
+            return EVO_FALSE;
+        }
+    }
+    return ok;
+}
+
+static evo_bool ReadResult(Reader* r, BaselineResult* result)
+{
+    char* key;
+    evo_bool ok;
+    evo_bool first = EVO_TRUE;
+
+    if(!Accept(r, '{'))
+    {
+        return EVO_FALSE;
+    }
+    while((key = NextKey(r, first, &ok)) != NULL)
+    {
+        first = EVO_FALSE;
+        if(!strcmp(key, "units"))
+        {
+            ok = ReadUint(r, &result->units);
+        }
+        else if(!strcmp(key, "wall"))
+        {
+            ok = ReadWall(r, result);
+        }
+        else
+        {
+            ok = SkipValue(r);
+        }
+        free(key);
+        if(!ok)
+        {
+            return EVO_FALSE;
+        }
+    }
+    return ok && result->units && result->sampleCount;
+}
+
+static evo_bool ReadResults(Reader* r, Baseline* baseline)
+{
+    evo_uint capacity = 0;
+
+    if(!Accept(r, '['))
+    {
+        return EVO_FALSE;
+    }
+    if(Accept(r, ']'))
+    {
+        return EVO_TRUE;
+    }
+    do
+    {
+        if(baseline->resultCount == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 8;
+            baseline->results = realloc(baseline->results, sizeof(BaselineResult) * capacity);
+        }
+        memset(&baseline->results[baseline->resultCount], 0, sizeof(BaselineResult));
+        baseline->resultCount++;
+        if(!ReadResult(r, &baseline->results[baseline->resultCount - 1]))
+        {
+            return EVO_FALSE;
+        }
+    } while(Accept(r, ','));
+    return Accept(r, ']');
+}
+
+static evo_bool ReadArgs(Reader* r, Baseline* baseline)
+{
+    char* arg;
+
+    if(!Accept(r, '['))
+    {
+        return EVO_FALSE;
+    }
+    if(Accept(r, ']'))
+    {
+        return EVO_TRUE;
+    }
+    do
+    {
+        arg = ReadString(r);
+        if(!arg)
+        {
+            return EVO_FALSE;
+        }
+        baseline->args = realloc(baseline->args, sizeof(char*) * (baseline->argCount + 1));
+        baseline->args[baseline->argCount++] = arg;
+    } while(Accept(r, ','));
+    return Accept(r, ']');
+}
+
+static evo_bool ReadBaseline(Reader* r, Baseline* baseline)
+{
+    char* key;
+    evo_bool ok;
+    evo_bool first = EVO_TRUE;
+
+    if(!Accept(r, '{'))
+    {
+        return EVO_FALSE;
+    }
+    while((key = NextKey(r, first, &ok)) != NULL)
+    {
+        first = EVO_FALSE;
+        if(!strcmp(key, "test"))
+        {
+            free(baseline->test);
+            baseline->test = ReadString(r);
+            ok = baseline->test != NULL;
+        }
+        else if(!strcmp(key, "args"))
+        {
+            ok = ReadArgs(r, baseline);
+        }
+        else if(!strcmp(key, "runs"))
+        {
+            ok = ReadUint(r, &baseline->runs);
+        }
+        else if(!strcmp(key, "warmups"))
+        {
+            ok = ReadUint(r, &baseline->warmups);
+        }
+        else if(!strcmp(key, "results"))
+        {
+            ok = ReadResults(r, baseline);
+        }
+        else
+        {
+            ok = SkipValue(r);
+        }
+        free(key);
+        if(!ok)
+        {
+            return EVO_FALSE;
+        }
+    }
+    return ok && baseline->test && baseline->resultCount;
+}
+
+Baseline* Baseline_Load(const char* filename)
+{
+    FILE* f;
+    char* text;
+    long size;
+    Reader r;
+    Baseline* baseline;
+
+    f = fopen(filename, "rb");
+    if(!f)
+    {
+        fprintf(stderr, "evo-bench: could not open baseline '%s'.\n", filename);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    text = malloc(size + 1);
+    size = (long) fread(text, 1, size, f);
+    text[size] = 0;
+    fclose(f);
+
+    baseline = calloc(1, sizeof(Baseline));
+    baseline->runs = 5;
+    baseline->warmups = 1;
+    r.p = text;
+    if(!ReadBaseline(&r, baseline))
+    {
+        fprintf(stderr, "evo-bench: could not read baseline '%s', near byte %ld.\n", filename, (long) (r.p - text));
+        Baseline_Free(baseline);
+        baseline = NULL;
+    }
+    free(text);
+    return baseline;
+}
+
+void Baseline_Free(Baseline* baseline)
+{
+    evo_uint i;
+    int a;
+
+    for(i = 0; i < baseline->resultCount; i++)
+    {
+        free(baseline->results[i].wall);
+    }
+    for(a = 0; a < baseline->argCount; a++)
+    {
+        free(baseline->args[a]);
+    }
+    free(baseline->results);
+    free(baseline->args);
+    free(baseline->test);
+    free(baseline);
+}
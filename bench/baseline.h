@@ -0,0 +1,48 @@
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <evo_api.h>
+
+/*
+    A baseline is the JSON file evo-bench writes with -f json, kept from an earlier build:
+
+        {
+            "test": "saw",
+            "args": ["6", "6"],
+            "runs": 5,
+            "warmups": 1,
+            "results": [
+                {"units": 1, "wall": {"mean": ..., "samples": [...]}, "cpu": {...}, ...},
+                ...
+            ]
+        }
+
+    "args" are the test's arguments after the thread count. Only the fields needed to
+    run the benchmark again and compare its wall times are read, and the rest are skipped,
+    so baselines can have fields added to them without breaking older copies of evo-bench.
+*/
+
+/* The wall times of one unit count. */
+typedef struct
+{
+    evo_uint units;
+    evo_uint sampleCount;
+    double* wall;
+} BaselineResult;
+
+typedef struct
+{
+    char* test;
+    int argCount;
+    char** args;
+    evo_uint runs;
+    evo_uint warmups;
+    evo_uint resultCount;
+    BaselineResult* results;
+} Baseline;
+
+/* Reads a baseline. Returns NULL, after printing why, if it couldn't be read. */
+Baseline* Baseline_Load(const char* filename);
+void Baseline_Free(Baseline* baseline);
+
+#endif
@@ -0,0 +1,910 @@
+/* dup, dup2 and fdopen are POSIX, and not declared in strict C89 without this. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../tests/tests.h"
+#include "baseline.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fdopen _fdopen
+#define fileno _fileno
+#define close _close
+#else
+#include <unistd.h>
+#endif
+
+/*
+    evo-bench: runs one of the tests several times for each unit count, and reports
+    the wall time and CPU time of the runs, with how well they scale.
+
+    Every test takes its thread count as its first argument, so that's the one filled in
+    for each unit count. Times are the ones the test measures itself (from StartTime to EndTime),
+    so setting up the problem isn't counted.
+
+    With --compare, it instead reruns the benchmark kept in a baseline (JSON written by an earlier
+    evo-bench), with the same arguments and unit counts, and tests each unit count's wall times
+    against the baseline's with a one-sided Mann-Whitney U test. It exits with 1 if any of them
+    got significantly slower, by more than the threshold, so it can be used to gate engine changes.
+    Several baselines can be compared in one go, to cover a whole suite.
+*/
+
+#define MAX_UNIT_COUNTS 64
+#define MAX_BASELINES 64
+
+/* Where results go when there's no output file: the standard output evo-bench started with. */
+static FILE* resultStream = NULL;
+
+typedef enum
+{
+    FORMAT_CSV,
+    FORMAT_JSON
+} Format;
+
+/* Mean, standard deviation and 95% confidence interval of the mean, of some samples. */
+typedef struct
+{
+    double mean;
+    double stddev;
+    double low;
+    double high;
+} Summary;
+
+/* The timed runs of one unit count. */
+typedef struct
+{
+    evo_uint units;
+    double* wall;
+    double* cpu;
+    Summary wallSummary;
+    Summary cpuSummary;
+    double speedup;
+    double efficiency;
+    /* Means over the runs, when the library times its phases (and counts their hardware events). */
+    double phaseTime[EVO_TIMER_COUNT];
+    double phaseCounters[EVO_TIMER_COUNT][EVO_COUNTER_COUNT];
+    evo_uint perfUnits;
+} UnitResult;
+
+/* JSON names of the hardware counters. */
+static const char* counterKeys[EVO_COUNTER_COUNT] = {
+    "cycles", "instructions", "cacheMisses", "branchMisses"
+};
+
+/* Two-sided 95% quantiles of Student's t distribution, for 1 to 30 degrees of freedom. */
+static const double tQuantiles[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static void Summarize(const double* samples, evo_uint n, Summary* summary)
+{
+    evo_uint i;
+    double sum = 0;
+    double t;
+
+    for(i = 0; i < n; i++)
+    {
+        sum += samples[i];
+    }
+    summary->mean = sum / n;
+    sum = 0;
+    for(i = 0; i < n; i++)
+    {
+        sum += (samples[i] - summary->mean) * (samples[i] - summary->mean);
+    }
+    summary->stddev = n > 1 ? sqrt(sum / (n - 1)) : 0;
+    t = n - 1 <= 30 ? tQuantiles[n > 1 ? n - 2 : 0] : 1.960;
+    summary->low = summary->mean - t * summary->stddev / sqrt((double) n);
+    summary->high = summary->mean + t * summary->stddev / sqrt((double) n);
+}
+
+/* The complementary error function, to within 1.2e-7 (from Numerical Recipes' erfcc). */
+static double Erfc(double x)
+{
+    double z = fabs(x);
+    double t = 1 / (1 + 0.5 * z);
+    double r = t * exp(-z * z - 1.26551223 + t * (1.00002368 + t * (0.37409196 + t * (0.09678418
+        + t * (-0.18628806 + t * (0.27886807 + t * (-1.13520398 + t * (1.48851587
+        + t * (-0.82215223 + t * 0.17087277)))))))));
+    return x >= 0 ? r : 2 - r;
+}
+
+static int CompareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+    A one-sided Mann-Whitney U test, of whether the samples in b tend to be bigger than the ones in a.
+    Returns the p-value: the chance of a U at least this big, if both came from the same distribution.
+
+    Without ties, and with up to MAX_EXACT_SAMPLES in each, the p-value is exact, since there are
+    usually only a handful of runs. Otherwise it uses the normal approximation, corrected for ties.
+*/
+#define MAX_EXACT_SAMPLES 20
+static double MannWhitney(const double* a, evo_uint n1, const double* b, evo_uint n2)
+{
+    evo_uint i, j, k, n, u, maxU;
+    double U = 0;
+    double ties = 0;
+    double p, total, mean, variance, z;
+    double* all;
+    double* counts;
+
+    for(i = 0; i < n1; i++)
+    {
+        for(j = 0; j < n2; j++)
+        {
+            U += b[j] > a[i] ? 1 : b[j] == a[i] ? 0.5 : 0;
+        }
+    }
+
+    /* Sum t^3 - t over each group of t tied samples. */
+    n = n1 + n2;
+    all = malloc(sizeof(double) * n);
+    memcpy(all, a, sizeof(double) * n1);
+    memcpy(all + n1, b, sizeof(double) * n2);
+    qsort(all, n, sizeof(double), CompareDoubles);
+    for(i = 0; i < n; i = j)
+    {
+        for(j = i + 1; j < n && all[j] == all[i]; j++)
+        {
+        }
+        ties += (double) (j - i) * (j - i) * (j - i) - (j - i);
+    }
+    free(all);
+
+    if(ties == 0 && n1 <= MAX_EXACT_SAMPLES && n2 <= MAX_EXACT_SAMPLES)
+    {
+        /*
+            counts[(i * (n2 + 1) + j) * (maxU + 1) + u] is how many orderings of i samples from a
+            and j from b have U = u. The biggest sample either comes from b, and is bigger than all i
+            from a, or comes from a, and is bigger than none from b.
+        */
+        maxU = n1 * n2;
+        counts = calloc((n1 + 1) * (n2 + 1) * (maxU + 1), sizeof(double));
+        #define COUNT(i, j, u) counts[((i) * (n2 + 1) + (j)) * (maxU + 1) + (u)]
+        for(i = 0; i <= n1; i++)
+        {
+            for(j = 0; j <= n2; j++)
+            {
+                if(!i || !j)
+                {
+                    COUNT(i, j, 0) = 1;
+                    continue;
+                }
+                for(u = 0; u <= i * j; u++)
+                {
+                    COUNT(i, j, u) = COUNT(i - 1, j, u) + (u >= i ? COUNT(i, j - 1, u - i) : 0);
+                }
+            }
+        }
+        p = 0;
+        total = 0;
+        for(k = 0; k <= maxU; k++)
+        {
+            total += COUNT(n1, n2, k);
+            if(k >= U)
+            {
+                p += COUNT(n1, n2, k);
+            }
+        }
+        #undef COUNT
+        free(counts);
+        return p / total;
+    }
+
+    mean = n1 * (double) n2 / 2;
+    variance = n1 * (double) n2 / 12 * ((n + 1) - ties / ((double) n * (n - 1)));
+    if(variance <= 0)
+    {
+        return 1;
+    }
+    /* With a continuity correction. */
+    z = (U - mean - 0.5) / sqrt(variance);
+    return 0.5 * Erfc(z / sqrt(2.0));
+}
+
+/* Reads a list of unit counts, like "1,2,4,8" or "1-16" or "1-4,8,16". Returns how many were read. */
+static evo_uint ParseUnits(const char* text, evo_uint* units)
+{
+    evo_uint count = 0;
+    unsigned long first, last;
+    char* end;
+
+    while(*text)
+    {
+        first = strtoul(text, &end, 10);
+        if(end == text || !first)
+        {
+            return 0;
+        }
+        last = first;
+        text = end;
+        if(*text == '-')
+        {
+            last = strtoul(text + 1, &end, 10);
+            if(end == text + 1 || last < first)
+            {
+                return 0;
+            }
+            text = end;
+        }
+        for(; first <= last; first++)
+        {
+            if(count == MAX_UNIT_COUNTS)
+            {
+                return 0;
+            }
+            units[count++] = (evo_uint) first;
+        }
+        if(*text == ',')
+        {
+            text++;
+        }
+        else if(*text)
+        {
+            return 0;
+        }
+    }
+    return count;
+}
+
+/* Runs the test once with the given unit count. Returns false if it failed, or didn't time itself. */
+static evo_bool RunOnce(const TestData* test, int argc, char** argv, evo_uint units)
+{
+    char unitText[16];
+
+    sprintf(unitText, "%u", units);
+    argv[2] = unitText;
+    memset(&lastRun, 0, sizeof(RunRecord));
+    lastRun.wallTime = -1;
+    if(test->cb(argc, argv) || lastRun.wallTime < 0)
+    {
+        fprintf(stderr, "evo-bench: '%s' failed with %u units.\n", argv[1], units);
+        return EVO_FALSE;
+    }
+    return EVO_TRUE;
+}
+
+static void WriteSamples(FILE* f, const double* samples, evo_uint n)
+{
+    evo_uint i;
+    fprintf(f, "[");
+    for(i = 0; i < n; i++)
+    {
+        fprintf(f, "%s%.6f", i ? ", " : "", samples[i]);
+    }
+    fprintf(f, "]");
+}
+
+static void WriteSummary(FILE* f, const char* name, const Summary* summary, const double* samples, evo_uint n)
+{
+    fprintf(f, "\"%s\": {\"mean\": %.6f, \"stddev\": %.6f, \"ci95\": [%.6f, %.6f], \"samples\": ",
+        name, summary->mean, summary->stddev, summary->low, summary->high);
+    WriteSamples(f, samples, n);
+    fprintf(f, "}");
+}
+
+/* Returns whether the library timed the phases of the runs. */
+static evo_bool HasPhases(const UnitResult* result)
+{
+    evo_uint i;
+    for(i = 0; i < EVO_TIMER_COUNT; i++)
+    {
+        if(result->phaseTime[i] > 0)
+        {
+            return EVO_TRUE;
+        }
+    }
+    return EVO_FALSE;
+}
+
+static void WritePhasesJson(FILE* f, const UnitResult* result)
+{
+    evo_uint i, j;
+
+    fprintf(f, ", \"phases\": {");
+    for(i = 0; i < EVO_TIMER_COUNT; i++)
+    {
+        fprintf(f, "%s\"%s\": {\"seconds\": %.6f", i ? ", " : "",
+            evo_PhaseTimerName((evo_PhaseTimer) i), result->phaseTime[i]);
+        if(result->perfUnits)
+        {
+            for(j = 0; j < EVO_COUNTER_COUNT; j++)
+            {
+                fprintf(f, ", \"%s\": %.0f", counterKeys[j], result->phaseCounters[i][j]);
+            }
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "}");
+}
+
+/* Writes a string as a JSON string, escaping quotes, backslashes and control characters. */
+static void WriteJsonString(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for(; *s; s++)
+    {
+        if(*s == '"' || *s == '\\')
+        {
+            fprintf(f, "\\%c", *s);
+        }
+        else if((unsigned char) *s < 0x20)
+        {
+            fprintf(f, "\\u%04x", (unsigned char) *s);
+        }
+        else
+        {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void WriteJson(FILE* f, int argc, char** argv, const UnitResult* results, evo_uint unitCount,
+    evo_uint runs, evo_uint warmups)
+{
+    evo_uint i;
+    int a;
+
+    fprintf(f, "{\n");
+    fprintf(f, "    \"test\": ");
+    WriteJsonString(f, argv[1]);
+    fprintf(f, ",\n");
+    fprintf(f, "    \"args\": [");
+    for(a = 3; a < argc; a++)
+    {
+        fprintf(f, "%s", a > 3 ? ", " : "");
+        WriteJsonString(f, argv[a]);
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "    \"runs\": %u,\n", runs);
+    fprintf(f, "    \"warmups\": %u,\n", warmups);
+    fprintf(f, "    \"results\": [\n");
+    for(i = 0; i < unitCount; i++)
+    {
+        fprintf(f, "        {\"units\": %u, ", results[i].units);
+        WriteSummary(f, "wall", &results[i].wallSummary, results[i].wall, runs);
+        fprintf(f, ", ");
+        WriteSummary(f, "cpu", &results[i].cpuSummary, results[i].cpu, runs);
+        fprintf(f, ", \"speedup\": %.4f, \"efficiency\": %.4f", results[i].speedup, results[i].efficiency);
+        if(HasPhases(&results[i]))
+        {
+            WritePhasesJson(f, &results[i]);
+        }
+        fprintf(f, "}%s\n", i + 1 < unitCount ? "," : "");
+    }
+    fprintf(f, "    ]\n");
+    fprintf(f, "}\n");
+}
+
+static void WriteCsv(FILE* f, char** argv, const UnitResult* results, evo_uint unitCount, evo_uint runs)
+{
+    evo_uint i;
+
+    fprintf(f, "test,units,runs,wall_mean,wall_stddev,wall_ci95_low,wall_ci95_high,"
+        "cpu_mean,cpu_stddev,cpu_ci95_low,cpu_ci95_high,speedup,efficiency\n");
+    for(i = 0; i < unitCount; i++)
+    {
+        fprintf(f, "%s,%u,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f\n",
+            argv[1], results[i].units, runs,
+            results[i].wallSummary.mean, results[i].wallSummary.stddev,
+            results[i].wallSummary.low, results[i].wallSummary.high,
+            results[i].cpuSummary.mean, results[i].cpuSummary.stddev,
+            results[i].cpuSummary.low, results[i].cpuSummary.high,
+            results[i].speedup, results[i].efficiency);
+    }
+}
+
+/*
+    Where a run's time went, with the instructions per cycle and misses per thousand instructions
+    of each phase, if they were counted.
+*/
+static void WritePhaseTable(FILE* f, const UnitResult* result)
+{
+    evo_uint i;
+    double instructions;
+
+    fprintf(f, "\n%u units, per run%s\n", result->units, result->perfUnits ? "" : " (no hardware counters)");
+    fprintf(f, "%-12s %12s", "phase", "seconds");
+    if(result->perfUnits)
+    {
+        fprintf(f, " %8s %16s %16s", "IPC", "cache misses/k", "branch misses/k");
+    }
+    fprintf(f, "\n");
+    for(i = 0; i < EVO_TIMER_COUNT; i++)
+    {
+        fprintf(f, "%-12s %12.4f", evo_PhaseTimerName((evo_PhaseTimer) i), result->phaseTime[i]);
+        if(result->perfUnits)
+        {
+            instructions = result->phaseCounters[i][EVO_COUNTER_INSTRUCTIONS];
+            fprintf(f, " %8.2f %16.3f %16.3f",
+                result->phaseCounters[i][EVO_COUNTER_CYCLES] > 0
+                    ? instructions / result->phaseCounters[i][EVO_COUNTER_CYCLES] : 0.0,
+                instructions > 0 ? result->phaseCounters[i][EVO_COUNTER_CACHE_MISSES] * 1000 / instructions : 0.0,
+                instructions > 0 ? result->phaseCounters[i][EVO_COUNTER_BRANCH_MISSES] * 1000 / instructions : 0.0);
+        }
+        fprintf(f, "\n");
+    }
+}
+
+/* The speedup and efficiency table, for reading. */
+static void WriteTable(FILE* f, char** argv, const UnitResult* results, evo_uint unitCount)
+{
+    evo_uint i;
+
+    fprintf(f, "\n%s\n", argv[1]);
+    fprintf(f, "%6s %12s %12s %12s %9s %11s\n", "units", "wall (s)", "+/- 95%", "cpu (s)", "speedup", "efficiency");
+    for(i = 0; i < unitCount; i++)
+    {
+        fprintf(f, "%6u %12.4f %12.4f %12.4f %9.2f %10.1f%%\n",
+            results[i].units, results[i].wallSummary.mean,
+            results[i].wallSummary.high - results[i].wallSummary.mean,
+            results[i].cpuSummary.mean, results[i].speedup, results[i].efficiency * 100);
+    }
+    for(i = 0; i < unitCount; i++)
+    {
+        if(HasPhases(&results[i]))
+        {
+            WritePhaseTable(f, &results[i]);
+        }
+    }
+}
+
+/* Runs the test for each unit count, filling in the results. Returns false if a run failed. */
+static evo_bool RunUnits(const TestData* test, int argc, char** argv, UnitResult* results,
+    const evo_uint* units, evo_uint unitCount, evo_uint runs, evo_uint warmups)
+{
+    evo_uint i, r, p, c;
+
+    for(i = 0; i < unitCount; i++)
+    {
+        results[i].units = units[i];
+        results[i].wall = malloc(sizeof(double) * runs);
+        results[i].cpu = malloc(sizeof(double) * runs);
+        for(r = 0; r < warmups + runs; r++)
+        {
+            fprintf(stderr, "evo-bench: %s, %u units, %s %u/%u\n", argv[1], units[i],
+                r < warmups ? "warmup" : "run", r < warmups ? r + 1 : r - warmups + 1, r < warmups ? warmups : runs);
+            if(!RunOnce(test, argc, argv, units[i]))
+            {
+                return EVO_FALSE;
+            }
+            if(r >= warmups)
+            {
+                results[i].wall[r - warmups] = lastRun.wallTime;
+                results[i].cpu[r - warmups] = lastRun.cpuTime;
+                results[i].perfUnits = lastRun.perfUnits;
+                for(p = 0; p < EVO_TIMER_COUNT; p++)
+                {
+                    results[i].phaseTime[p] += lastRun.phaseTime[p] / runs;
+                    for(c = 0; c < EVO_COUNTER_COUNT; c++)
+                    {
+                        results[i].phaseCounters[p][c] += lastRun.phaseCounters[p][c] / runs;
+                    }
+                }
+            }
+        }
+        Summarize(results[i].wall, runs, &results[i].wallSummary);
+        Summarize(results[i].cpu, runs, &results[i].cpuSummary);
+        /* Scaling is measured against the first unit count. */
+        results[i].speedup = results[0].wallSummary.mean / results[i].wallSummary.mean;
+        results[i].efficiency = results[i].speedup * results[0].units / results[i].units;
+    }
+    return EVO_TRUE;
+}
+
+static void FreeResults(UnitResult* results, evo_uint unitCount)
+{
+    evo_uint i;
+    for(i = 0; i < unitCount; i++)
+    {
+        free(results[i].wall);
+        free(results[i].cpu);
+    }
+    free(results);
+}
+
+/* Writes the results to the output file, or standard output if there isn't one. Returns false if it couldn't. */
+static evo_bool WriteResults(const char* outputName, Format format, int argc, char** argv,
+    const UnitResult* results, evo_uint unitCount, evo_uint runs, evo_uint warmups)
+{
+    FILE* f = outputName ? fopen(outputName, "w") : resultStream;
+    if(!f)
+    {
+        fprintf(stderr, "evo-bench: could not write '%s'.\n", outputName);
+        return EVO_FALSE;
+    }
+    if(format == FORMAT_JSON)
+    {
+        WriteJson(f, argc, argv, results, unitCount, runs, warmups);
+    }
+    else
+    {
+        WriteCsv(f, argv, results, unitCount, runs);
+    }
+    if(outputName)
+    {
+        fclose(f);
+    }
+    return EVO_TRUE;
+}
+
+/* The smallest p-value MannWhitney can give with these sample counts, without ties: 1 / C(n1 + n2, n1). */
+static double MinimumPValue(evo_uint n1, evo_uint n2)
+{
+    evo_uint i;
+    double p = 1;
+
+    for(i = 1; i <= n1; i++)
+    {
+        p = p * i / (n2 + i);
+    }
+    return p;
+}
+
+/*
+    Reruns the benchmark a baseline was made from, and compares each unit count's wall times.
+    The unit counts are the baseline's, and so are the runs and warmups unless they're given
+    (as a positive runs, or a warmups that isn't negative). If an output file is given, the new
+    results are written to it, so they can be used as the next baseline.
+    Returns 1 if anything got slower, 0 if not, and -1 if the benchmark couldn't be run.
+*/
+static int Compare(const char* program, const char* filename, evo_uint runs, int warmups,
+    double alpha, double threshold, const char* outputName, Format format)
+{
+    evo_uint i;
+    int a;
+    int status = 0;
+    int testArgc;
+    char** testArgv;
+    const TestData* test;
+    Baseline* baseline;
+    UnitResult* results;
+    evo_uint* units;
+    const BaselineResult* old;
+    Summary oldSummary;
+    double change, pSlower, pFaster;
+    const char* verdict;
+
+    baseline = Baseline_Load(filename);
+    if(!baseline)
+    {
+        return -1;
+    }
+    test = FindTest(baseline->test);
+    if(!test)
+    {
+        fprintf(stderr, "evo-bench: failed to find test '%s', from '%s'.\n", baseline->test, filename);
+        Baseline_Free(baseline);
+        return -1;
+    }
+    runs = runs ? runs : baseline->runs;
+    warmups = warmups >= 0 ? warmups : (int) baseline->warmups;
+
+    /* With too few runs, no slowdown could ever be significant, and the comparison would always pass. */
+    for(i = 0; i < baseline->resultCount; i++)
+    {
+        if(MinimumPValue(baseline->results[i].sampleCount, runs) >= alpha)
+        {
+            fprintf(stderr, "evo-bench: with %u runs in %s and %u new runs, no p-value can be below %g,"
+                " so nothing could be found slower than alpha %g. Use more runs (-r).\n",
+                baseline->results[i].sampleCount, filename, runs,
+                MinimumPValue(baseline->results[i].sampleCount, runs), alpha);
+            Baseline_Free(baseline);
+            return -1;
+        }
+    }
+
+    testArgc = baseline->argCount + 3;
+    testArgv = malloc(sizeof(char*) * (testArgc + 1));
+    testArgv[0] = (char*) program;
+    testArgv[1] = baseline->test;
+    testArgv[2] = NULL;
+    for(a = 0; a < baseline->argCount; a++)
+    {
+        testArgv[a + 3] = baseline->args[a];
+    }
+    testArgv[testArgc] = NULL;
+
+    units = malloc(sizeof(evo_uint) * baseline->resultCount);
+    for(i = 0; i < baseline->resultCount; i++)
+    {
+        units[i] = baseline->results[i].units;
+    }
+    results = calloc(baseline->resultCount, sizeof(UnitResult));
+    if(!RunUnits(test, testArgc, testArgv, results, units, baseline->resultCount, runs, warmups))
+    {
+        status = -1;
+    }
+    else
+    {
+        fprintf(stderr, "\n%s", baseline->test);
+        for(a = 0; a < baseline->argCount; a++)
+        {
+            fprintf(stderr, " %s", baseline->args[a]);
+        }
+        fprintf(stderr, ", against %s\n", filename);
+        fprintf(stderr, "%6s %13s %13s %9s %9s %9s  %s\n", "units", "baseline (s)", "current (s)",
+            "change", "p slower", "p faster", "verdict");
+        for(i = 0; i < baseline->resultCount; i++)
+        {
+            old = &baseline->results[i];
+            Summarize(old->wall, old->sampleCount, &oldSummary);
+            change = results[i].wallSummary.mean / oldSummary.mean - 1;
+            pSlower = MannWhitney(old->wall, old->sampleCount, results[i].wall, runs);
+            pFaster = MannWhitney(results[i].wall, runs, old->wall, old->sampleCount);
+            verdict = "same";
+            if(pSlower < alpha && change > threshold)
+            {
+                verdict = "SLOWER";
+                status = 1;
+            }
+            else if(pFaster < alpha && change < -threshold)
+            {
+                verdict = "faster";
+            }
+            fprintf(stderr, "%6u %13.4f %13.4f %+8.1f%% %9.4f %9.4f  %s\n", old->units, oldSummary.mean,
+                results[i].wallSummary.mean, change * 100, pSlower, pFaster, verdict);
+        }
+        if(outputName && !WriteResults(outputName, format, testArgc, testArgv, results, baseline->resultCount, runs, warmups))
+        {
+            status = -1;
+        }
+    }
+
+    FreeResults(results, baseline->resultCount);
+    free(units);
+    free(testArgv);
+    Baseline_Free(baseline);
+    return status;
+}
+
+/*
+    Sends everything the tests print to standard error instead, so that standard output
+    only gets the results. Returns a stream for the original standard output,
+    or NULL if it couldn't be kept.
+*/
+static FILE* KeepStdout(void)
+{
+    int fd;
+    FILE* f;
+
+    fflush(stdout);
+    fd = dup(fileno(stdout));
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    f = fdopen(fd, "w");
+    if(!f)
+    {
+        close(fd);
+        return NULL;
+    }
+    if(dup2(fileno(stderr), fileno(stdout)) < 0)
+    {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+static void Usage(const char* program)
+{
+    int i = 0;
+    fprintf(stderr, "Usage:\n    %s [OPTIONS] TEST [ARGS...]\n", program);
+    fprintf(stderr, "    %s [OPTIONS] --compare BASELINE [--compare BASELINE...]\n", program);
+    fprintf(stderr, "\n    Runs TEST for each unit count, with ARGS after the thread count.\n");
+    fprintf(stderr, "    Or reruns the benchmark in each BASELINE (JSON written by -f json), and exits\n");
+    fprintf(stderr, "    with 1 if any unit count got significantly slower.\n");
+    fprintf(stderr, "\n    Options:\n");
+    fprintf(stderr, "        -u LIST    Unit counts to run, like 1,2,4,8 or 1-16. (default 1)\n");
+    fprintf(stderr, "        -r N       Timed runs for each unit count. (default 5, or the baseline's)\n");
+    fprintf(stderr, "        -w N       Untimed warmup runs for each unit count. (default 1, or the baseline's)\n");
+    fprintf(stderr, "        -f FORMAT  csv or json. (default: from the output file's extension, or csv)\n");
+    fprintf(stderr, "        -o FILE    Where to write the results. (default: standard output, with the\n");
+    fprintf(stderr, "                   test's own output moved to standard error, or nowhere when comparing)\n");
+    fprintf(stderr, "        -c FILE    The same as --compare FILE.\n");
+    fprintf(stderr, "        -a ALPHA   Significance level of the comparison. (default 0.05)\n");
+    fprintf(stderr, "        -t PERCENT Slowdowns smaller than this aren't counted. (default 3)\n");
+    fprintf(stderr, "\n    Where test is one of:\n");
+    while(testList[i].name && testList[i].cb)
+    {
+        fprintf(stderr, "        %s\n", testList[i].name);
+        i++;
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+    evo_uint i;
+    evo_uint units[MAX_UNIT_COUNTS];
+    evo_uint unitCount = 1;
+    evo_uint runs = 0;
+    int warmups = -1;
+    int formatSet = 0;
+    Format format = FORMAT_CSV;
+    const char* outputName = NULL;
+    const char* baselineNames[MAX_BASELINES];
+    evo_uint baselineCount = 0;
+    double alpha = 0.05;
+    double threshold = 3;
+    const TestData* test;
+    UnitResult* results;
+    char** testArgv;
+    int testArgc;
+    int a;
+    int status = 0;
+    int result;
+
+    units[0] = 1;
+    for(a = 1; a < argc && argv[a][0] == '-'; a++)
+    {
+        if(!strcmp(argv[a], "--compare"))
+        {
+            argv[a] = "-c";
+        }
+        if(!argv[a][1] || argv[a][2] || a + 1 >= argc)
+        {
+            Usage(argv[0]);
+            return -1;
+        }
+        switch(argv[a][1])
+        {
+            case 'u':
+                unitCount = ParseUnits(argv[++a], units);
+                if(!unitCount)
+                {
+                    fprintf(stderr, "evo-bench: bad unit counts '%s'.\n", argv[a]);
+                    return -1;
+                }
+                break;
+            case 'r':
+                runs = atoi(argv[++a]);
+                if(runs < 1)
+                {
+                    Usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'w':
+                warmups = atoi(argv[++a]);
+                break;
+            case 'f':
+                a++;
+                formatSet = 1;
+                if(!strcmp(argv[a], "json"))
+                {
+                    format = FORMAT_JSON;
+                }
+                else if(!strcmp(argv[a], "csv"))
+                {
+                    format = FORMAT_CSV;
+                }
+                else
+                {
+                    fprintf(stderr, "evo-bench: unknown format '%s'.\n", argv[a]);
+                    return -1;
+                }
+                break;
+            case 'o':
+                outputName = argv[++a];
+                break;
+            case 'c':
+                if(baselineCount == MAX_BASELINES)
+                {
+                    fprintf(stderr, "evo-bench: too many baselines.\n");
+                    return -1;
+                }
+                baselineNames[baselineCount++] = argv[++a];
+                break;
+            case 'a':
+                alpha = atof(argv[++a]);
+                break;
+            case 't':
+                threshold = atof(argv[++a]);
+                break;
+            default:
+                Usage(argv[0]);
+                return -1;
+        }
+    }
+    if(baselineCount ? a < argc : a >= argc)
+    {
+        Usage(argv[0]);
+        return -1;
+    }
+    if(!formatSet && outputName && strlen(outputName) >= 5 && !strcmp(outputName + strlen(outputName) - 5, ".json"))
+    {
+        format = FORMAT_JSON;
+    }
+
+    /* The tests' own progress records aren't wanted. Errors and warnings still go to standard error. */
+    logLevel = EVO_LOG_WARNING;
+    if(!outputName && !baselineCount)
+    {
+        resultStream = KeepStdout();
+        if(!resultStream)
+        {
+            fprintf(stderr, "evo-bench: could not keep standard output for the results.\n");
+            return -1;
+        }
+    }
+
+    if(baselineCount)
+    {
+        if(outputName && baselineCount > 1)
+        {
+            fprintf(stderr, "evo-bench: -o can only be used with one baseline.\n");
+            return -1;
+        }
+        /* Every baseline is run, even after one gets slower, so that the whole suite is reported. */
+        for(i = 0; i < baselineCount; i++)
+        {
+            result = Compare(argv[0], baselineNames[i], runs, warmups, alpha, threshold / 100, outputName, format);
+            if(result < 0)
+            {
+                return -1;
+            }
+            status |= result;
+        }
+        if(status > 0)
+        {
+            fprintf(stderr, "\nevo-bench: got slower than the baseline.\n");
+        }
+        return status;
+    }
+
+    test = FindTest(argv[a]);
+    if(!test)
+    {
+        fprintf(stderr, "evo-bench: failed to find test '%s'.\n", argv[a]);
+        return -1;
+    }
+    runs = runs ? runs : 5;
+    warmups = warmups >= 0 ? warmups : 1;
+
+    /* The test sees: program, test name, unit count, then the rest of the arguments. */
+    testArgc = argc - a + 2;
+    testArgv = malloc(sizeof(char*) * (testArgc + 1));
+    testArgv[0] = argv[0];
+    testArgv[1] = argv[a];
+    testArgv[2] = NULL;
+    for(i = 0; (int) i < argc - a - 1; i++)
+    {
+        testArgv[i + 3] = argv[a + 1 + i];
+    }
+    testArgv[testArgc] = NULL;
+
+    results = calloc(unitCount, sizeof(UnitResult));
+    if(!RunUnits(test, testArgc, testArgv, results, units, unitCount, runs, warmups))
+    {
+        status = -1;
+    }
+    else
+    {
+        WriteTable(stderr, testArgv, results, unitCount);
+        if(!WriteResults(outputName, format, testArgc, testArgv, results, unitCount, runs, warmups))
+        {
+            status = -1;
+        }
+    }
+
+    FreeResults(results, unitCount);
+    free(testArgv);
+    return status;
+}
@@ -0,0 +1,269 @@
+#ifndef EVO_HPP
+#define EVO_HPP
+
+#include <stdlib.h>
+#include <string.h>
+#include "evo_api.h"
+
+/*
+    A C++ front-end for the library.
+
+    evo::Engine compiles the generation loop for one problem, with its operators given as
+    functors, so the compiler can inline them into the loop instead of calling through
+    function pointers. Everything else is still done by the C library, through the evo_Config
+    the engine owns: threads, random streams, stats, and user callbacks all work as usual.
+    The population initializer and finalizer are still set on that config, since they
+    only run once per trial.
+
+    Operators are const functors, since one copy is shared by every unit:
+
+        Fitness:    double operator()(evo_Context* context, const Gene& gene) const;
+        Selection:  void operator()(evo_Context* context) const;
+                    (use evo_Context_AddBreedEvent, like a selection operator)
+        Crossover:  void operator()(evo_Context* context, const Gene& parentA, const Gene& parentB,
+                        Gene& childA, Gene& childB) const;
+        Mutation:   void operator()(evo_Context* context, Gene& gene) const;
+        Success:    bool operator()(evo_Context* context) const;
+
+    Every gene pointer in the context is treated as a Gene*.
+    Stages added to the config run too, though each phase runs after its whole loop,
+    instead of being fused into it.
+    Operators also need Start and End members, which are called like context start and
+    end callbacks, for any per-unit storage. Deriving from evo::Operator gives ones that do nothing.
+*/
+namespace evo
+{
+    /* A base for operators, with per-unit hooks that do nothing. */
+    struct Operator
+    {
+        void Start(evo_Context* context) const {}
+        void End(evo_Context* context) const {}
+    };
+
+    /*
+        Tournament selection, the same as evo_UseTournamentSelection.
+        The population is shuffled into tournaments of the given size, and the best two of each
+        breed to replace the worst two. The population size should be a multiple of the size.
+    */
+    class TournamentSelection : public Operator
+    {
+        public:
+            explicit TournamentSelection(evo_uint tournamentSize = 4)
+                : tournamentSize(tournamentSize)
+            {
+            }
+
+            void Start(evo_Context* context) const
+            {
+                context->selectionUserData = malloc(sizeof(evo_uint) * evo_Context_GetPopulationSize(context));
+            }
+
+            void End(evo_Context* context) const
+            {
+                free(context->selectionUserData);
+            }
+
+            void operator()(evo_Context* context) const
+            {
+                evo_uint i, j, k, t, minimum, size;
+                evo_uint populationSize = evo_Context_GetPopulationSize(context);
+                evo_uint* rank = static_cast<evo_uint*>(context->selectionUserData);
+                const double* fitnesses = context->fitnesses;
+
+                for(i = 0; i < populationSize; i++)
+                {
+                    rank[i] = i;
+                }
+                for(i = 0; i < populationSize; i++)
+                {
+                    j = evo_RandomInt(context, 0, populationSize);
+                    t = rank[i];
+                    rank[i] = rank[j];
+                    rank[j] = t;
+                }
+                for(i = 0; i < populationSize; i += tournamentSize)
+                {
+                    /* Sort the tournament by fitness, worst first. */
+                    size = i + tournamentSize < populationSize ? i + tournamentSize : populationSize;
+                    for(j = i; j + 1 < size; j++)
+                    {
+                        minimum = j;
+                        for(k = j + 1; k < size; k++)
+                        {
+                            if(fitnesses[rank[k]] < fitnesses[rank[minimum]])
+                            {
+                                minimum = k;
+                            }
+                        }
+                        t = rank[j];
+                        rank[j] = rank[minimum];
+                        rank[minimum] = t;
+                    }
+                    evo_Context_AddBreedEvent(context,
+                        rank[i + tournamentSize - 1], rank[i + tournamentSize - 2], rank[i], rank[i + 1]);
+                }
+            }
+
+        private:
+            evo_uint tournamentSize;
+    };
+
+    template<class Gene, class Fitness, class Selection, class Crossover, class Mutation, class Success>
+    class Engine
+    {
+        public:
+            Engine(const Fitness& fitness = Fitness(), const Selection& selection = Selection(),
+                const Crossover& crossover = Crossover(), const Mutation& mutation = Mutation(),
+                const Success& success = Success())
+                : config(evo_Config_New()), fitness(fitness), selection(selection),
+                crossover(crossover), mutation(mutation), success(success)
+            {
+                evo_Config_SetTrialRunner(config, RunTrial, this);
+                evo_Config_AddContextStartCallback(config, ContextStart, this);
+                evo_Config_AddContextEndCallback(config, ContextEnd, this);
+            }
+
+            ~Engine()
+            {
+                evo_Config_Free(config);
+            }
+
+            /*
+                The configuration that runs this engine. Attributes (unit count, trials, and so on),
+                the population initializer and finalizer, and any other callbacks are set on it.
+            */
+            evo_Config* GetConfig()
+            {
+                return config;
+            }
+
+            /* Runs every trial. Returns false if the configuration couldn't be used. */
+            bool Execute()
+            {
+                evo_Config_Execute(config);
+                return evo_Config_IsUsed(config) != 0;
+            }
+
+            evo_Stats* GetStats()
+            {
+                return evo_Config_GetStats(config);
+            }
+
+            evo_RunStats* GetRunStats()
+            {
+                return evo_Config_GetRunStats(config);
+            }
+
+        private:
+            /* The config holds a pointer to the engine, so it can't be copied. */
+            Engine(const Engine&);
+            Engine& operator=(const Engine&);
+
+            static void ContextStart(evo_Context* context, void* param)
+            {
+                const Engine* engine = static_cast<const Engine*>(param);
+                engine->fitness.Start(context);
+                engine->selection.Start(context);
+                engine->crossover.Start(context);
+                engine->mutation.Start(context);
+                engine->success.Start(context);
+            }
+
+            static void ContextEnd(evo_Context* context, void* param)
+            {
+                const Engine* engine = static_cast<const Engine*>(param);
+                engine->fitness.End(context);
+                engine->selection.End(context);
+                engine->crossover.End(context);
+                engine->mutation.End(context);
+                engine->success.End(context);
+            }
+
+            static Gene& GeneAt(evo_Context* context, evo_uint i)
+            {
+                return *static_cast<Gene*>(context->genes[i]);
+            }
+
+            /*
+                The same loop as the library's, with the fitness and best fitness scan done in one pass.
+                It calls the library's generation and phase hooks, so the phase timers, the trace
+                and the progress page see it like the library's own loop.
+            */
+            static evo_bool RunTrial(evo_Context* context, void* param)
+            {
+                const Engine* engine = static_cast<const Engine*>(param);
+                evo_uint i;
+                evo_uint populationSize = evo_Context_GetPopulationSize(context);
+                evo_uint maxIterations = evo_Context_GetMaxIterations(context);
+                const evo_uint* events;
+                double f;
+                bool success;
+
+                for(context->iteration = 0; context->iteration < maxIterations; context->iteration++)
+                {
+                    evo_Context_StartGeneration(context);
+                    context->bestFitness = 0;
+                    for(i = 0; i < populationSize; i++)
+                    {
+                        f = engine->fitness(context, GeneAt(context, i));
+                        context->fitnesses[i] = f;
+                        if(f > context->bestFitness)
+                        {
+                            context->bestFitness = f;
+                        }
+                    }
+                    context->runStats.evaluations += populationSize;
+                    evo_Context_EndPhase(context, EVO_TIMER_FITNESS);
+                    /* Stages may have changed the fitnesses, so the best has to be found again. */
+                    if(evo_Context_RunStages(context, EVO_PHASE_EVALUATED))
+                    {
+                        context->bestFitness = 0;
+                        for(i = 0; i < populationSize; i++)
+                        {
+                            if(context->fitnesses[i] > context->bestFitness)
+                            {
+                                context->bestFitness = context->fitnesses[i];
+                            }
+                        }
+                    }
+                    evo_Context_EndPhase(context, EVO_TIMER_EVALUATED);
+
+                    context->breedEventSize = 0;
+                    memset(context->markedGenes, 0, populationSize * sizeof(evo_bool));
+                    evo_Context_EndPhase(context, EVO_TIMER_CLEAR);
+                    engine->selection(context);
+                    evo_Context_RunStages(context, EVO_PHASE_SELECTED);
+                    evo_Context_EndPhase(context, EVO_TIMER_SELECTION);
+
+                    events = context->breedEvents;
+                    for(i = 0; i < context->breedEventSize; i += 4)
+                    {
+                        engine->crossover(context, GeneAt(context, events[i]), GeneAt(context, events[i + 1]),
+                            GeneAt(context, events[i + 2]), GeneAt(context, events[i + 3]));
+                        engine->mutation(context, GeneAt(context, events[i + 2]));
+                        engine->mutation(context, GeneAt(context, events[i + 3]));
+                    }
+                    evo_Context_RunStages(context, EVO_PHASE_BRED);
+                    evo_Context_EndPhase(context, EVO_TIMER_BREEDING);
+
+                    success = engine->success(context);
+                    evo_Context_EndPhase(context, EVO_TIMER_SUCCESS);
+                    evo_Context_EndGeneration(context);
+                    if(success)
+                    {
+                        return EVO_TRUE;
+                    }
+                }
+                return EVO_FALSE;
+            }
+
+            evo_Config* config;
+            Fitness fitness;
+            Selection selection;
+            Crossover crossover;
+            Mutation mutation;
+            Success success;
+    };
+}
+
+#endif
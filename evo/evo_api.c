@@ -2,10 +2,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 /* pthreads is used for multithreading. */
 #include <pthread.h>
 /* Library internals. */
 #include "evo_api.h"
+#include "evo_time.h"
+#include "evo_perf.h"
+#include "evo_trace.h"
+#include "evo_progress.h"
+#include "evo_log.h"
 #include <assert.h>
 
 
@@ -13,6 +19,68 @@
 
 static void* _evo_RunThread(void* arg);
 static evo_bool _evo_NextSeed(evo_Context* context);
+static void _evo_Context_PairwiseFitness(evo_Context* context);
+static void _evo_Context_RunLanes(evo_Context* context, evo_uint trialsPerUnit);
+
+#ifdef EVO_USE_PHASE_TIMERS
+/* Starts timing the context's next phase. */
+#define PHASE_START(context) _evo_Context_StartPhase(context)
+/* Adds the time since the phase started to its timer, and starts the next phase. */
+#define PHASE_END(context, timer) _evo_Context_EndPhase((context), (timer))
+
+static void _evo_Context_StartPhase(evo_Context* context)
+{
+#ifdef EVO_USE_PERF_COUNTERS
+    if(context->perfGroup)
+    {
+        evo_PerfGroup_Read(context->perfGroup, context->phaseCounterStart);
+    }
+#endif
+    context->phaseStart = evo_WallTime();
+}
+
+static void _evo_Context_EndPhase(evo_Context* context, evo_PhaseTimer timer)
+{
+    double now = evo_WallTime();
+#ifdef EVO_USE_PERF_COUNTERS
+    evo_uint i;
+    double counters[EVO_COUNTER_COUNT];
+
+    if(context->perfGroup && evo_PerfGroup_Read(context->perfGroup, counters))
+    {
+        for(i = 0; i < EVO_COUNTER_COUNT; i++)
+        {
+            context->runStats.phaseCounters[timer][i] += counters[i] - context->phaseCounterStart[i];
+            context->phaseCounterStart[i] = counters[i];
+        }
+    }
+#endif
+    context->runStats.phaseTime[timer] += now - context->phaseStart;
+    if(context->traceBuffer)
+    {
+        evo_TraceBuffer_Add(context->traceBuffer, evo_PhaseTimerName(timer), context->phaseStart, now, NULL, 0);
+    }
+    context->phaseStart = now;
+}
+#else
+#define PHASE_START(context)
+#define PHASE_END(context, timer)
+#endif
+
+/* The time now, if the context is being traced. Saves reading the clock when it isn't. */
+static double _evo_Context_TraceTime(evo_Context* context)
+{
+    return context->traceBuffer ? evo_WallTime() : 0;
+}
+
+/* Records a span from start until now, if the context is being traced. */
+static void _evo_Context_Trace(evo_Context* context, const char* name, double start, const char* argName, evo_uint arg)
+{
+    if(context->traceBuffer)
+    {
+        evo_TraceBuffer_Add(context->traceBuffer, name, start, evo_WallTime(), argName, arg);
+    }
+}
 
 typedef struct
 {
@@ -28,6 +96,21 @@ typedef struct
     void* param[MAX_CALLBACKS];
 } UserFinalizerInfo;
 
+typedef struct
+{
+    evo_StagePolicy policy;
+    evo_StageCallback cb;
+    void* param;
+} Stage;
+
+/* The stages of one phase, in the order they were added. Grows as needed. */
+typedef struct
+{
+    evo_uint count;
+    evo_uint capacity;
+    Stage* stages;
+} StageList;
+
 /* The configuration structure. Intended to be an opaque data-type to the calling code.  */
 struct evo_Config
 {
@@ -42,26 +125,46 @@ struct evo_Config
     evo_uint populationSize; /* The size of the population in the evolutionary algorithm. */
     evo_uint randomSeed; /* The seed to start all other offsets from. */
     evo_uint randomStreamCount; /* (optional) Number of PRNGs to use. */
+    evo_uint laneCount; /* (optional) Number of trials each unit runs in lockstep. */
+    const char* traceFile; /* (optional) Where to write a trace of the run. */
+    const char* progressName; /* (optional) The name of a shared memory page to publish progress to. */
+    evo_LogLevel logLevel; /* (optional) How much to log. */
 
     /* Callbacks - see their typedefs in evo_api.h for usage info. */
     evo_PopulationInitializer populationInitializer;
     evo_PopulationFinalizer populationFinalizer;
     evo_FitnessOperator fitnessOperator;
+    evo_PairwiseFitnessOperator pairwiseFitness;
+    evo_BatchFitnessOperator batchFitness;
     evo_SelectionOperator selectionOperator;
     evo_CrossoverOperator crossoverOperator;
     evo_MutationOperator mutationOperator;
     evo_SuccessPredicate successPredicate;
+    evo_TrialRunner trialRunner;
+    void* trialRunnerParam;
+    evo_LogSink logSink;
+    void* logSinkParam;
     
     /* Different user function hooks assigned to this configuration. */
     UserCallbackInfo contextStart;
     UserCallbackInfo contextEnd;
     UserFinalizerInfo configFinalizer;
+    StageList stages[EVO_PHASE_COUNT];
 
     /* Statistics. Filled after the algorithms are completely finished. */
     evo_Stats stats;
+    evo_RunStats runStats;
 
     /* A list of random seeds. Needs to cycle through them. */
     evo_uint* seeds;
+
+    /* A trace buffer for each unit, and each of its lanes, while tracing. */
+    evo_TraceBuffer** traceBuffers;
+    evo_uint traceBufferCount;
+    /* The progress page, while the run has one. */
+    evo_Progress* progress;
+    /* The units' log rings and their drain thread, while the run is logging. */
+    evo_Log* log;
 };
 
 #define RETURN_IF_INVALID(c) \
@@ -84,6 +187,8 @@ struct evo_Config
 evo_Config* evo_Config_New()
 {
     evo_Config* config = calloc(1, sizeof(evo_Config));
+    config->logLevel = EVO_LOG_INFO;
+    config->logSink = evo_Log_Print;
     return config;
 }
 
@@ -98,6 +203,10 @@ void evo_Config_Free(evo_Config* config)
             config->configFinalizer.cb[i](config->configFinalizer.param[i]);
         }
         /* Free the rest. */
+        for(i = 0; i < EVO_PHASE_COUNT; i++)
+        {
+            free(config->stages[i].stages);
+        }
         free(config);
     }
 }
@@ -112,6 +221,41 @@ evo_Stats* evo_Config_GetStats(evo_Config* config)
     return (config->running) ? ((evo_Stats*) NULL) : &config->stats;
 }
 
+evo_RunStats* evo_Config_GetRunStats(evo_Config* config)
+{
+    return (config->running) ? ((evo_RunStats*) NULL) : &config->runStats;
+}
+
+const char* evo_PhaseTimerName(evo_PhaseTimer timer)
+{
+    static const char* names[EVO_TIMER_COUNT] = {
+        "initialize", "clear", "fitness", "evaluated", "selection", "breeding", "success"
+    };
+    return (timer < EVO_TIMER_COUNT) ? names[timer] : "unknown";
+}
+
+const char* evo_LogLevelName(evo_LogLevel level)
+{
+    static const char* names[EVO_LOG_LEVEL_COUNT] = {
+        "silent", "error", "warning", "info", "debug"
+    };
+    return (level < EVO_LOG_LEVEL_COUNT) ? names[level] : "unknown";
+}
+
+/* Logs a message from the configuration itself. Only for the thread running Execute, while the log isn't draining. */
+static void _evo_Config_Log(evo_Config* config, evo_LogLevel level, const char* format, ...)
+{
+    va_list args;
+
+    if(level > config->logLevel)
+    {
+        return;
+    }
+    va_start(args, format);
+    evo_Log_Send(config->logSink, config->logSinkParam, level, format, args);
+    va_end(args);
+}
+
 /* Attributes. */
 EVO_ATTR_SETTER(evo_Config_SetUnitCount, unitCount, evo_uint)
 EVO_ATTR_SETTER(evo_Config_SetTrials, trials, evo_uint)
@@ -119,15 +263,36 @@ EVO_ATTR_SETTER(evo_Config_SetMaxIterations, maxIterations, evo_uint)
 EVO_ATTR_SETTER(evo_Config_SetPopulationSize, populationSize, evo_uint)
 EVO_ATTR_SETTER(evo_Config_SetRandomSeed, randomSeed, evo_uint)
 EVO_ATTR_SETTER(evo_Config_SetRandomStreamCount, randomStreamCount, evo_uint)
+EVO_ATTR_SETTER(evo_Config_SetLaneCount, laneCount, evo_uint)
+EVO_ATTR_SETTER(evo_Config_SetTraceFile, traceFile, const char*)
+EVO_ATTR_SETTER(evo_Config_SetProgressName, progressName, const char*)
+EVO_ATTR_SETTER(evo_Config_SetLogLevel, logLevel, evo_LogLevel)
 
 /* Callbacks. */
 EVO_ATTR_SETTER(evo_Config_SetPopulationInitializer, populationInitializer, evo_PopulationInitializer)
 EVO_ATTR_SETTER(evo_Config_SetPopulationFinalizer, populationFinalizer, evo_PopulationFinalizer)
 EVO_ATTR_SETTER(evo_Config_SetFitnessOperator, fitnessOperator, evo_FitnessOperator)
+EVO_ATTR_SETTER(evo_Config_SetPairwiseFitness, pairwiseFitness, evo_PairwiseFitnessOperator)
+EVO_ATTR_SETTER(evo_Config_SetBatchFitness, batchFitness, evo_BatchFitnessOperator)
 EVO_ATTR_SETTER(evo_Config_SetSelectionOperator, selectionOperator, evo_SelectionOperator)
 EVO_ATTR_SETTER(evo_Config_SetCrossoverOperator, crossoverOperator, evo_CrossoverOperator)
 EVO_ATTR_SETTER(evo_Config_SetMutationOperator, mutationOperator, evo_MutationOperator)
 EVO_ATTR_SETTER(evo_Config_SetSuccessPredicate, successPredicate, evo_SuccessPredicate)
+
+void evo_Config_SetTrialRunner(evo_Config* config, evo_TrialRunner trialRunner, void* param)
+{
+    RETURN_IF_INVALID(config);
+    config->trialRunner = trialRunner;
+    config->trialRunnerParam = param;
+}
+
+void evo_Config_SetLogSink(evo_Config* config, evo_LogSink logSink, void* param)
+{
+    RETURN_IF_INVALID(config);
+    config->logSink = logSink ? logSink : evo_Log_Print;
+    config->logSinkParam = param;
+}
+
 /* Optional callbacks. */
 #define EVO_CALLBACK_ADDER(func, attr, cbType) \
     void func(evo_Config* config, cbType cb, void* param) \
@@ -146,46 +311,134 @@ EVO_CALLBACK_ADDER(evo_Config_AddContextStartCallback, config->contextStart, evo
 EVO_CALLBACK_ADDER(evo_Config_AddContextEndCallback, config->contextEnd, evo_UserCallback)
 EVO_CALLBACK_ADDER(evo_Config_AddConfigFinalizer, config->configFinalizer, evo_UserFinalizer)
 
-/* Aggregates statistics after all trials are finished. */
-static void _evo_Config_PopulateStats(evo_Config* config, evo_Context** contexts)
+void evo_Config_AddStage(evo_Config* config, evo_StagePhase phase, evo_StagePolicy policy,
+    evo_StageCallback cb, void* param)
 {
-	evo_uint i;
-    evo_Stats* stats;
-    evo_Stats* overall;
-
-    overall = &config->stats;
-    memset(overall, 0, sizeof(evo_Stats));
+    Stage* stages;
+    StageList* list;
 
-    for(i = 0; i < config->unitCount; i++)
+    RETURN_IF_INVALID(config);
+    if(phase >= EVO_PHASE_COUNT || (phase == EVO_PHASE_EVALUATED && policy == EVO_STAGE_PER_EVENT))
     {
-        stats = &contexts[i]->stats;
-    
-        overall->trials += stats->trials;
-        overall->failures += stats->failures;
-        overall->sumIterations += stats->sumIterations;
-        overall->sumSquaredIterations += stats->sumSquaredIterations;
-        overall->sumSuccessIterations += stats->sumSuccessIterations;
-        overall->sumSquaredSuccessIterations += stats->sumSquaredSuccessIterations;
- 
-        if(stats->minIteration < overall->minIteration || i == 0)
-        {
-            overall->minIteration = stats->minIteration;
-        }
-        if(stats->maxSuccessIteration > overall->maxSuccessIteration)
-        {
-            overall->maxSuccessIteration = stats->maxSuccessIteration;
-        }
-        if(stats->maxIteration > overall->maxIteration)
+        return;
+    }
+    list = &config->stages[phase];
+    if(list->count == list->capacity)
+    {
+        stages = realloc(list->stages, (list->capacity ? list->capacity * 2 : 4) * sizeof(Stage));
+        if(!stages)
         {
-            overall->maxIteration = stats->maxIteration;
+            return;
         }
-        if(stats->bestFitness > overall->bestFitness)
+        list->stages = stages;
+        list->capacity = list->capacity ? list->capacity * 2 : 4;
+    }
+    list->stages[list->count].policy = policy;
+    list->stages[list->count].cb = cb;
+    list->stages[list->count].param = param;
+    list->count++;
+}
+
+/* Adds one set of statistics to another. */
+static void _evo_Stats_Add(evo_Stats* overall, const evo_Stats* stats)
+{
+    if(!stats->trials)
+    {
+        return;
+    }
+    if(stats->minIteration < overall->minIteration || !overall->trials)
+    {
+        overall->minIteration = stats->minIteration;
+    }
+    overall->trials += stats->trials;
+    overall->failures += stats->failures;
+    overall->sumIterations += stats->sumIterations;
+    overall->sumSquaredIterations += stats->sumSquaredIterations;
+    overall->sumSuccessIterations += stats->sumSuccessIterations;
+    overall->sumSquaredSuccessIterations += stats->sumSquaredSuccessIterations;
+
+    if(stats->maxSuccessIteration > overall->maxSuccessIteration)
+    {
+        overall->maxSuccessIteration = stats->maxSuccessIteration;
+    }
+    if(stats->maxIteration > overall->maxIteration)
+    {
+        overall->maxIteration = stats->maxIteration;
+    }
+    if(stats->bestFitness > overall->bestFitness)
+    {
+        overall->bestFitness = stats->bestFitness;
+    }
+}
+
+/* Adds one set of run stats to another. */
+static void _evo_RunStats_Add(evo_RunStats* overall, const evo_RunStats* stats)
+{
+    evo_uint i, j;
+
+    overall->cpuTime += stats->cpuTime;
+    overall->evaluations += stats->evaluations;
+    overall->perfUnits += stats->perfUnits;
+    for(i = 0; i < EVO_TIMER_COUNT; i++)
+    {
+        overall->phaseTime[i] += stats->phaseTime[i];
+        for(j = 0; j < EVO_COUNTER_COUNT; j++)
         {
-            overall->bestFitness = stats->bestFitness;
+            overall->phaseCounters[i][j] += stats->phaseCounters[i][j];
         }
     }
 }
 
+/* Aggregates statistics after all trials are finished. */
+static void _evo_Config_PopulateStats(evo_Config* config, evo_Context** contexts)
+{
+	evo_uint i;
+
+    memset(&config->stats, 0, sizeof(evo_Stats));
+    memset(&config->runStats, 0, sizeof(evo_RunStats));
+    for(i = 0; i < config->unitCount; i++)
+    {
+        _evo_Stats_Add(&config->stats, &contexts[i]->stats);
+        _evo_RunStats_Add(&config->runStats, &contexts[i]->runStats);
+    }
+}
+
+/* The bytes in a unit's payoff matrix, for pairwise fitness. 0 if that doesn't fit in a size_t. */
+static size_t _evo_Config_PayoffMatrixSize(const evo_Config* config)
+{
+    size_t n = config->populationSize;
+
+    if(n && n > ((size_t) -1) / sizeof(double) / n)
+    {
+        return 0;
+    }
+    return n * n * sizeof(double);
+}
+
+/*
+    Checks that there's room for a payoff matrix for every unit and lane at once,
+    so that a population too big for pairwise fitness is turned down before anything runs.
+*/
+static evo_bool _evo_Config_CanAllocatePayoffs(const evo_Config* config)
+{
+    size_t size, contextCount;
+    void* payoffs;
+
+    size = _evo_Config_PayoffMatrixSize(config);
+    contextCount = (size_t) config->unitCount * ((config->laneCount > 1) ? config->laneCount : 1);
+    if(!size || size > ((size_t) -1) / contextCount)
+    {
+        return EVO_FALSE;
+    }
+    payoffs = malloc(size * contextCount);
+    if(!payoffs)
+    {
+        return EVO_FALSE;
+    }
+    free(payoffs);
+    return EVO_TRUE;
+}
+
 /*
     Starts evolutionary algorithm execution across multiple threads.
     
@@ -198,12 +451,14 @@ static void _evo_Config_PopulateStats(evo_Config* config, evo_Context** contexts
     * population initializer
     * population finializer
     
-    * fitness operator
+    * fitness operator (or pairwise or batch fitness operator)
     * selection operator
     * crossover operator
     * mutation operator
     * success predicate
     
+    (or a trial runner, instead of the five operators above)
+    
     All required configuration details must be filled, or this will fail.
     The configuration must not already be running, and must not have been used previously,
     or this will fail.
@@ -217,6 +472,10 @@ void evo_Config_Execute(evo_Config* config)
     evo_uint seedsPerUnit, seedsLeftOver;
     pthread_t* threads;
     evo_Context** contexts;
+    double wallStart;
+    evo_uint tracksPerUnit;
+    char trackName[64];
+    evo_ProgressHeader progressHeader;
     
     RETURN_IF_INVALID(config);
     if(!config->unitCount
@@ -224,12 +483,21 @@ void evo_Config_Execute(evo_Config* config)
         || !config->maxIterations
         || !config->populationSize
         || !config->populationInitializer
-        || !config->populationFinalizer
-        || !config->fitnessOperator
-        || !config->selectionOperator
-        || !config->crossoverOperator
-        || !config->mutationOperator
-        || !config->successPredicate)
+        || !config->populationFinalizer)
+    {
+        return;
+    }
+    if(!config->trialRunner
+        && ((!config->fitnessOperator && !config->pairwiseFitness && !config->batchFitness)
+            || !config->selectionOperator
+            || !config->crossoverOperator
+            || !config->mutationOperator
+            || !config->successPredicate))
+    {
+        return;
+    }
+    /* Lanes need the library's own loop, to keep them in step. */
+    if(config->trialRunner && config->laneCount > 1)
     {
         return;
     }
@@ -254,6 +522,11 @@ void evo_Config_Execute(evo_Config* config)
     {
         return;
     }
+    if(config->pairwiseFitness && !_evo_Config_CanAllocatePayoffs(config))
+    {
+        _evo_Config_Log(config, EVO_LOG_ERROR, "There isn't room for the payoff matrices of a population of %u.", config->populationSize);
+        return;
+    }
 
     config->running = 1;
     config->used = 1;
@@ -279,6 +552,26 @@ void evo_Config_Execute(evo_Config* config)
                 - (seedsPerUnit * (config->unitCount - 1));
     }
 
+    /* Every unit gets a track in the trace, and so does each of its lanes. */
+    tracksPerUnit = (config->laneCount > 1) ? config->laneCount + 1 : 1;
+    if(config->traceFile)
+    {
+        config->traceBufferCount = config->unitCount * tracksPerUnit;
+        config->traceBuffers = malloc(sizeof(evo_TraceBuffer*) * config->traceBufferCount);
+        for(i = 0; i < config->traceBufferCount; i++)
+        {
+            if(i % tracksPerUnit == 0)
+            {
+                sprintf(trackName, "unit %u", i / tracksPerUnit);
+            }
+            else
+            {
+                sprintf(trackName, "unit %u lane %u", i / tracksPerUnit, i % tracksPerUnit - 1);
+            }
+            config->traceBuffers[i] = evo_TraceBuffer_New(i, trackName);
+        }
+    }
+
     /* Create the array of contexts */
     contexts = malloc(sizeof(evo_Context*) * config->unitCount);
     /* Allocate and initialize each context. */
@@ -296,6 +589,10 @@ void evo_Config_Execute(evo_Config* config)
         */
         contexts[i]->config = config;
         contexts[i]->id = i;
+        if(config->traceBuffers)
+        {
+            contexts[i]->traceBuffer = config->traceBuffers[i * tracksPerUnit];
+        }
         contexts[i]->trial = 0;
         contexts[i]->iteration = 0;
         contexts[i]->seedIndex = contexts[i]->seedIndexStart = i * seedsPerUnit;
@@ -310,6 +607,30 @@ void evo_Config_Execute(evo_Config* config)
     }
     
     /* Start up the threads. */
+    wallStart = evo_WallTime();
+    if(config->progressName)
+    {
+        memset(&progressHeader, 0, sizeof(progressHeader));
+        progressHeader.unitCount = config->unitCount;
+        progressHeader.trialsPerUnit = config->trials / config->unitCount;
+        progressHeader.maxIterations = config->maxIterations;
+        progressHeader.populationSize = config->populationSize;
+        progressHeader.laneCount = (config->laneCount > 1) ? config->laneCount : 0;
+        progressHeader.startTime = wallStart;
+        config->progress = evo_Progress_Create(config->progressName, &progressHeader);
+        if(!config->progress)
+        {
+            _evo_Config_Log(config, EVO_LOG_WARNING, "Could not create the progress page %s.", config->progressName);
+        }
+    }
+    if(config->logLevel > EVO_LOG_SILENT)
+    {
+        config->log = evo_Log_Start(config->unitCount, config->logSink, config->logSinkParam);
+        if(!config->log)
+        {
+            _evo_Config_Log(config, EVO_LOG_WARNING, "Could not start the log thread, so the units won't log.");
+        }
+    }
     for(i = 0; i < config->unitCount; i++)
     {
         /* Create the thread. */
@@ -321,11 +642,41 @@ void evo_Config_Execute(evo_Config* config)
     {
         pthread_join(threads[i], NULL);
     }
+    if(config->log)
+    {
+        evo_Log_Stop(config->log);
+        config->log = NULL;
+    }
     
     /* Aggregate all statistics. */
     _evo_Config_PopulateStats(config, contexts);
+    config->runStats.wallTime = evo_WallTime() - wallStart;
+    if(config->runStats.wallTime > 0)
+    {
+        config->runStats.evaluationsPerSecond = config->runStats.evaluations / config->runStats.wallTime;
+    }
+
+    if(config->traceBuffers)
+    {
+        if(!evo_Trace_Write(config->traceFile, config->traceBuffers, config->traceBufferCount, wallStart))
+        {
+            _evo_Config_Log(config, EVO_LOG_ERROR, "Could not write the trace to %s.", config->traceFile);
+        }
+        for(i = 0; i < config->traceBufferCount; i++)
+        {
+            evo_TraceBuffer_Free(config->traceBuffers[i]);
+        }
+        free(config->traceBuffers);
+        config->traceBuffers = NULL;
+    }
+    if(config->progress)
+    {
+        evo_Progress_Finish(config->progress);
+        evo_Progress_Close(config->progress);
+        config->progress = NULL;
+    }
 
-    printf("DING DING DING DING\n");
+    _evo_Config_Log(config, EVO_LOG_INFO, "DING DING DING DING");
     
     /* Configuration is no longer running. Rejoice! */
     config->running = 0;
@@ -339,17 +690,410 @@ void evo_Config_Execute(evo_Config* config)
     free(contexts);
 }
 
+/* Allocates the arrays a context needs, and invokes all user start-of-run callbacks. */
+static void _evo_Context_Start(evo_Context* context)
+{
+    evo_uint i;
+    evo_Config* config = context->config;
+    evo_uint populationSize = config->populationSize;
+
+    /* Create the neccessary arrays */
+    context->fitnesses = malloc(populationSize * sizeof(double));
+    context->breedEvents = malloc(populationSize * sizeof(evo_uint));
+    context->markedGenes = malloc(populationSize * sizeof(evo_bool));
+    if(config->pairwiseFitness)
+    {
+        context->payoffs = malloc(_evo_Config_PayoffMatrixSize(config));
+        context->payoffSums = malloc(populationSize * sizeof(double));
+        context->dirtyGenes = malloc(populationSize * sizeof(evo_bool));
+    }
+    
+    /* Invoke all user start-of-run callbacks */
+    for(i = 0; i < config->contextStart.count; i++)
+    {
+        config->contextStart.cb[i](context, config->contextStart.param[i]);
+    }
+}
+
+/* Invokes all user end-of-run callbacks, then frees the population and the context's arrays. */
+static void _evo_Context_End(evo_Context* context)
+{
+    evo_uint i;
+    evo_Config* config = context->config;
+
+    /* Invoke all user end-of-run callbacks */
+    for(i = 0; i < config->contextEnd.count; i++)
+    {
+        config->contextEnd.cb[i](context, config->contextEnd.param[i]);
+    }
+    
+    /* Free the population. A lane that never got a seed doesn't have one. */
+    if(context->genes)
+    {
+        config->populationFinalizer(context);
+    }
+
+    /* Free the previously necessary arrays */
+    free(context->fitnesses);
+    free(context->breedEvents);
+    free(context->markedGenes);
+    free(context->payoffs);
+    free(context->payoffSums);
+    free(context->dirtyGenes);
+}
+
+/* Initializes/rerandomizes the population, for the start of a trial. */
+static void _evo_Context_BeginTrial(evo_Context* context)
+{
+    evo_uint i;
+    evo_Config* config = context->config;
+    evo_uint populationSize = config->populationSize;
+
+    context->trialStart = _evo_Context_TraceTime(context);
+    PHASE_START(context);
+    config->populationInitializer(context);
+    if(config->pairwiseFitness)
+    {
+        /* Every gene is new, so every game needs to be played. */
+        memset(context->payoffs, 0, _evo_Config_PayoffMatrixSize(config));
+        memset(context->payoffSums, 0, populationSize * sizeof(double));
+        for(i = 0; i < populationSize; i++)
+        {
+            context->dirtyGenes[i] = 1;
+        }
+    }
+    context->iteration = 0;
+    PHASE_END(context, EVO_TIMER_INITIALIZE);
+}
+
+/* Evaluates all population members' fitnesses. */
+static void _evo_Context_Evaluate(evo_Context* context)
+{
+    evo_bool active = 1;
+    evo_Config* config = context->config;
+
+    PHASE_START(context);
+    if(config->batchFitness)
+    {
+        /* A lone context is a batch of one lane, and one lane's fitnesses are already in order. */
+        memset(context->fitnesses, 0, config->populationSize * sizeof(double));
+        PHASE_END(context, EVO_TIMER_CLEAR);
+        config->batchFitness(&context, 1, &active, context->fitnesses);
+    }
+    else if(config->pairwiseFitness)
+    {
+        /* Replay the games of changed genes. */
+        _evo_Context_PairwiseFitness(context);
+    }
+    else
+    {
+        /* Clear the fitnesses. */
+        memset(context->fitnesses, 0, config->populationSize * sizeof(double));
+        PHASE_END(context, EVO_TIMER_CLEAR);
+        config->fitnessOperator(context);
+    }
+    PHASE_END(context, EVO_TIMER_FITNESS);
+    context->runStats.evaluations += config->populationSize;
+}
+
+/* Returns the number of stages from first onward that share its policy, and so go in one pass. */
+static evo_uint _evo_StageRun(const StageList* list, evo_uint first)
+{
+    evo_uint end = first + 1;
+    while(end < list->count && list->stages[end].policy == list->stages[first].policy)
+    {
+        end++;
+    }
+    return end - first;
+}
+
+/* Returns where the last pass of a phase starts. */
+static evo_uint _evo_StageLastRun(const StageList* list)
+{
+    evo_uint i;
+    evo_uint last = 0;
+    for(i = 0; i < list->count; i += _evo_StageRun(list, i))
+    {
+        last = i;
+    }
+    return last;
+}
+
+#define RUN_STAGE(stage, context, index) (stage).cb((context), (index), (stage).param)
+
+/*
+    Runs stages that share a policy, in one pass.
+    With findBest, a per-gene pass also finds the best fitness as it goes.
+*/
+static void _evo_Context_RunStagePass(evo_Context* context, const Stage* stages, evo_uint count, evo_bool findBest)
+{
+    evo_uint i, s;
+    evo_uint populationSize = context->config->populationSize;
+
+    switch(stages[0].policy)
+    {
+        case EVO_STAGE_SERIAL:
+            for(s = 0; s < count; s++)
+            {
+                RUN_STAGE(stages[s], context, 0);
+            }
+            break;
+        case EVO_STAGE_PER_GENE:
+            for(i = 0; i < populationSize; i++)
+            {
+                for(s = 0; s < count; s++)
+                {
+                    RUN_STAGE(stages[s], context, i);
+                }
+                if(findBest && context->fitnesses[i] > context->bestFitness)
+                {
+                    context->bestFitness = context->fitnesses[i];
+                }
+            }
+            break;
+        case EVO_STAGE_PER_EVENT:
+            for(i = 0; i < context->breedEventSize; i += 4)
+            {
+                for(s = 0; s < count; s++)
+                {
+                    RUN_STAGE(stages[s], context, i);
+                }
+            }
+            break;
+    }
+}
+
+/* Runs the stages [first, end) of a phase, one pass per run of the same policy. */
+static void _evo_Context_RunStageList(evo_Context* context, const StageList* list, evo_uint first, evo_uint end)
+{
+    evo_uint run;
+    while(first < end)
+    {
+        run = _evo_StageRun(list, first);
+        _evo_Context_RunStagePass(context, list->stages + first, run, 0);
+        first += run;
+    }
+}
+
+evo_uint evo_Context_RunStages(evo_Context* context, evo_StagePhase phase)
+{
+    const StageList* list = &context->config->stages[phase];
+    _evo_Context_RunStageList(context, list, 0, list->count);
+    return list->count;
+}
+
+/* Clears the selection event data. */
+static void _evo_Context_ClearSelection(evo_Context* context)
+{
+    context->breedEventSize = 0;
+    memset(context->markedGenes, 0, context->config->populationSize * sizeof(evo_bool));
+}
+
+void evo_Context_Select(evo_Context* context)
+{
+    _evo_Context_ClearSelection(context);
+    /* Perform user-defined selection */
+    context->config->selectionOperator(context);
+}
+
+void evo_Context_Log(evo_Context* context, evo_LogLevel level, const char* format, ...)
+{
+    va_list args;
+    evo_Config* config = context->config;
+
+    /* Silent runs, and levels that aren't logged, stop here before anything is formatted. */
+    if(level > config->logLevel || !config->log)
+    {
+        return;
+    }
+    va_start(args, format);
+    evo_Log_Write(config->log, context->id, level, format, args);
+    va_end(args);
+}
+
+void evo_Context_FindBestFitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = context->config->populationSize;
+
+    context->bestFitness = 0;
+    for(i = 0; i < populationSize; i++)
+    {
+        if(context->fitnesses[i] > context->bestFitness)
+        {
+            context->bestFitness = context->fitnesses[i];
+        }
+    }
+}
+
+void evo_Context_StartGeneration(evo_Context* context)
+{
+    context->generationStart = _evo_Context_TraceTime(context);
+    PHASE_START(context);
+}
+
+void evo_Context_EndPhase(evo_Context* context, evo_PhaseTimer timer)
+{
+    PHASE_END(context, timer);
+}
+
+/*
+    Does the rest of an iteration, once the fitnesses are known:
+    selection, then crossover and mutation for every breeding event, with each phase's stages.
+    Returns whether the success predicate was satisfied.
+*/
+static evo_bool _evo_Context_Breed(evo_Context* context)
+{
+    evo_uint i, s, last, fused;
+    evo_Config* config = context->config;
+    const StageList* evaluated = &config->stages[EVO_PHASE_EVALUATED];
+    const StageList* bred = &config->stages[EVO_PHASE_BRED];
+    evo_bool success;
+
+    PHASE_START(context);
+    /*
+        Run the stages after evaluation, and find the maximum fitness of the population.
+        If the stages end with a per-gene pass, the maximum is found in that same pass.
+    */
+    context->bestFitness = 0;
+    last = _evo_StageLastRun(evaluated);
+    _evo_Context_RunStageList(context, evaluated, 0, last);
+    if(last < evaluated->count && evaluated->stages[last].policy == EVO_STAGE_PER_GENE)
+    {
+        _evo_Context_RunStagePass(context, evaluated->stages + last, evaluated->count - last, EVO_TRUE);
+    }
+    else
+    {
+        _evo_Context_RunStageList(context, evaluated, last, evaluated->count);
+        evo_Context_FindBestFitness(context);
+    }
+    PHASE_END(context, EVO_TIMER_EVALUATED);
+
+    _evo_Context_ClearSelection(context);
+    PHASE_END(context, EVO_TIMER_CLEAR);
+    /* Perform user-defined selection */
+    config->selectionOperator(context);
+    evo_Context_RunStages(context, EVO_PHASE_SELECTED);
+    PHASE_END(context, EVO_TIMER_SELECTION);
+    
+    /* A per-event pass at the start of the bred stages is done as each event is bred. */
+    fused = (bred->count && bred->stages[0].policy == EVO_STAGE_PER_EVENT) ? _evo_StageRun(bred, 0) : 0;
+    /* Use the parent and child lists to reproduce. */
+    for(i = 0; i < context->breedEventSize; i += 4)
+    {
+        /* Perform crossover. */
+        config->crossoverOperator(context,
+            context->genes[context->breedEvents[i]], context->genes[context->breedEvents[i + 1]], 
+            context->genes[context->breedEvents[i + 2]], context->genes[context->breedEvents[i + 3]]);
+            
+        /* Mutate the children. */
+        config->mutationOperator(context, context->genes[context->breedEvents[i + 2]]);
+        config->mutationOperator(context, context->genes[context->breedEvents[i + 3]]);
+        
+        /* The children's old games are no longer valid. */
+        if(config->pairwiseFitness)
+        {
+            context->dirtyGenes[context->breedEvents[i + 2]] = 1;
+            context->dirtyGenes[context->breedEvents[i + 3]] = 1;
+        }
+
+        for(s = 0; s < fused; s++)
+        {
+            RUN_STAGE(bred->stages[s], context, i);
+        }
+    }
+    _evo_Context_RunStageList(context, bred, fused, bred->count);
+    PHASE_END(context, EVO_TIMER_BREEDING);
+    
+    success = config->successPredicate(context);
+    PHASE_END(context, EVO_TIMER_SUCCESS);
+    return success;
+}
+
+/* Records the outcome of a finished trial in the context's stats. */
+static void _evo_Context_EndTrial(evo_Context* context, evo_bool success)
+{
+    /* Successful! Update specific success-only stats. */
+    if(success)
+    {
+        if(context->iteration > context->stats.maxSuccessIteration)
+        {
+            context->stats.maxSuccessIteration = context->iteration;
+        }
+        context->stats.sumSuccessIterations += context->iteration;
+        context->stats.sumSquaredSuccessIterations += context->iteration * context->iteration;
+    }
+    /* If the algorithm was not successful, record it. */
+    else
+    {
+        context->stats.failures++;
+    }
+    /* Update context stats. */
+    if(context->stats.trials == 0 || context->iteration < context->stats.minIteration)
+    {
+        context->stats.minIteration = context->iteration;
+    }
+    if(context->iteration > context->stats.maxIteration)
+    {
+        context->stats.maxIteration = context->iteration;
+    }
+    if(context->bestFitness > context->stats.bestFitness)
+    {
+        context->stats.bestFitness = context->bestFitness;
+    }
+    
+    context->stats.sumIterations += context->iteration;
+    context->stats.sumSquaredIterations += context->iteration * context->iteration;
+    context->stats.trials++;
+    evo_Context_Log(context, EVO_LOG_DEBUG, "Context %u trial %u with seed %u %s after %u iterations",
+        context->id, context->trial, context->seed, success ? "succeeded" : "failed", context->iteration);
+    _evo_Context_Trace(context, success ? "trial" : "failed trial", context->trialStart, "iterations", context->iteration);
+}
+
+/* Publishes the unit's progress, if the run has a progress page. */
+static void _evo_Context_Publish(evo_Context* context)
+{
+    if(context->config->progress)
+    {
+        evo_Progress_Update(context->config->progress, context->id, context->stats.trials,
+            context->iteration, context->bestFitness, context->runStats.evaluations);
+    }
+}
+
+void evo_Context_EndGeneration(evo_Context* context)
+{
+    _evo_Context_Trace(context, "generation", context->generationStart, "iteration", context->iteration);
+    _evo_Context_Publish(context);
+}
+
+/* Publishes the unit's final stats, and marks it as finished. */
+static void _evo_Context_Done(evo_Context* context)
+{
+    if(context->config->progress)
+    {
+        evo_Progress_Update(context->config->progress, context->id, context->stats.trials,
+            context->iteration, context->stats.bestFitness, context->runStats.evaluations);
+        evo_Progress_UnitDone(context->config->progress, context->id);
+    }
+}
+
 static void* _evo_RunThread(void* arg)
 {
     evo_bool success;
     evo_Context* context;
     evo_Config* config;
-    evo_uint i/*, j*/;
-    evo_uint id, trialsPerUnit, maxIterations, populationSize;
+    evo_uint trialsPerUnit, maxIterations;
+    double cpuStart, unitStart;
     
+    cpuStart = evo_ThreadCpuTime();
     context = (evo_Context*) arg;
+    unitStart = _evo_Context_TraceTime(context);
     config = context->config;
-    id = context->id;
+#ifdef EVO_USE_PERF_COUNTERS
+    /* Counters are per thread, so they have to be opened here. Without them, only time is measured. */
+    context->perfGroup = evo_PerfGroup_Open();
+    context->runStats.perfUnits = (context->perfGroup != NULL);
+#endif
     if(context->seedIndexStart == context->seedIndexEnd)
     {
         trialsPerUnit = 0;
@@ -359,130 +1103,291 @@ static void* _evo_RunThread(void* arg)
         trialsPerUnit = config->trials /* (context->seedIndexEnd - context->seedIndexStart)*/ / config->randomStreamCount;
     }
     maxIterations = config->maxIterations;
-    populationSize = config->populationSize;
 
-    /* Create the neccessary arrays */
-    context->fitnesses = malloc(populationSize * sizeof(double));
-    context->breedEvents = malloc(populationSize * sizeof(evo_uint));
-    context->markedGenes = malloc(populationSize * sizeof(evo_bool));
-    
-    /* Invoke all user start-of-run callbacks */
-    for(i = 0; i < config->contextStart.count; i++)
+    if(config->laneCount > 1)
     {
-        config->contextStart.cb[i](context, config->contextStart.param[i]);
+        _evo_Context_RunLanes(context, trialsPerUnit);
+        _evo_Context_Trace(context, "unit", unitStart, "trials", context->stats.trials);
+        _evo_Context_Done(context);
+        evo_PerfGroup_Close(context->perfGroup);
+        context->runStats.cpuTime += evo_ThreadCpuTime() - cpuStart;
+        return NULL;
     }
 
+    _evo_Context_Start(context);
+
     /* Go over every seed assigned to this context. */
     while(_evo_NextSeed(context))
     {
-        printf("Context %d running %d trials with seed %d\n", context->id, trialsPerUnit, context->seed);
+        evo_Context_Log(context, EVO_LOG_INFO, "Context %u running %u trials with seed %u", context->id, trialsPerUnit, context->seed);
 
         /* Keep going until every iteration has completed. */
         for(context->trial = 0; context->trial < trialsPerUnit; context->trial++)
         {
-            /* Initialize/rerandomize the population. */
-            config->populationInitializer(context);
-            
+            _evo_Context_BeginTrial(context);
             success = 0;
             
-            /* Do the main genetic algorithm. */
-            for(context->iteration = 0; context->iteration < maxIterations; context->iteration++)
+            if(config->trialRunner)
             {
-                /* Clear the fitnesses. */
-                memset(context->fitnesses, 0, populationSize * sizeof(double));
-                /* Evaluate all population members' initial fitnesses. */
-                config->fitnessOperator(context);
-                /* Find the maximum fitness of the population. */
-                context->bestFitness = 0;
-                for(i = 0; i < populationSize; i++)
+                success = config->trialRunner(context, config->trialRunnerParam);
+            }
+            else
+            {
+                /* Do the main genetic algorithm. */
+                for(context->iteration = 0; context->iteration < maxIterations; context->iteration++)
                 {
-                    if(context->fitnesses[i] > context->bestFitness)
+                    context->generationStart = _evo_Context_TraceTime(context);
+                    _evo_Context_Evaluate(context);
+                    success = _evo_Context_Breed(context);
+                    evo_Context_EndGeneration(context);
+                    /* Algorithm was successful, stop early. */
+                    if(success)
                     {
-                        context->bestFitness = context->fitnesses[i];
+                        break;
                     }
+                    /* Otherwise, go onto another iteration. */
                 }
-
-                /* Clear the selection event data. */
-                context->breedEventSize = 0;
-                memset(context->markedGenes, 0, populationSize * sizeof(evo_bool));
-                /* Perform user-defined selection */
-                config->selectionOperator(context);
-                
-                /* Use the parent and child lists to reproduce. */
-                for(i = 0; i < context->breedEventSize; i += 4)
-                {
-                    /* Perform crossover. */
-                    config->crossoverOperator(context,
-                        context->genes[context->breedEvents[i]], context->genes[context->breedEvents[i + 1]], 
-                        context->genes[context->breedEvents[i + 2]], context->genes[context->breedEvents[i + 3]]);
-                        
-                    /* Mutate the children. */
-                    config->mutationOperator(context, context->genes[context->breedEvents[i + 2]]);
-                    config->mutationOperator(context, context->genes[context->breedEvents[i + 3]]);
-                }
-                
-                /* Algorithm was successful, stop early. */
-                if(config->successPredicate(context))
-                {
-                    success = 1;
-                    break;
-                }
-                /* Otherwise, go onto another iteration. */
             }
             
-            /* Successful! Update specific success-only stats. */
-            if(success)
+            _evo_Context_EndTrial(context, success);
+            _evo_Context_Publish(context);
+        }
+    }
+    
+    _evo_Context_End(context);
+    _evo_Context_Trace(context, "unit", unitStart, "trials", context->stats.trials);
+    _evo_Context_Done(context);
+    evo_PerfGroup_Close(context->perfGroup);
+    context->runStats.cpuTime += evo_ThreadCpuTime() - cpuStart;
+    
+    /* Ding ding ding ding. */
+    return NULL;
+}
+
+/*
+    Starts a lane's next trial. When the lane has run every trial for its seed,
+    it takes the next seed this unit hasn't handed out yet.
+    Returns false if there are no seeds left, in which case the lane is done.
+*/
+static evo_bool _evo_Context_NextLaneTrial(evo_Context* context, evo_Context* lane, evo_uint trialsPerUnit)
+{
+    if(lane->trial >= trialsPerUnit)
+    {
+        if(context->seedIndex >= context->seedIndexEnd || !_evo_NextSeed(context))
+        {
+            lane->prevSeed = lane->seed;
+            return EVO_FALSE;
+        }
+        lane->prevSeed = lane->seed;
+        lane->seed = context->seed;
+        /* The seed's index keys the seed's own streams, like the competitions' pairings. */
+        lane->seedIndex = context->seedIndex;
+        lane->trial = 0;
+        evo_Context_Log(lane, EVO_LOG_INFO, "Context %u lane %u running %u trials with seed %u", context->id, lane->lane, trialsPerUnit, lane->seed);
+    }
+    _evo_Context_BeginTrial(lane);
+    return EVO_TRUE;
+}
+
+/* Publishes the progress of a unit that's running lanes, which is the lanes' put together. */
+static void _evo_Context_PublishLanes(evo_Context* context, evo_Context** lanes, evo_uint laneCount, const evo_bool* active)
+{
+    evo_uint l, trials, iteration;
+    double bestFitness, evaluations;
+
+    trials = iteration = 0;
+    bestFitness = 0;
+    evaluations = context->runStats.evaluations;
+    for(l = 0; l < laneCount; l++)
+    {
+        trials += lanes[l]->stats.trials;
+        evaluations += lanes[l]->runStats.evaluations;
+        if(active[l] && lanes[l]->iteration > iteration)
+        {
+            iteration = lanes[l]->iteration;
+        }
+        if(lanes[l]->bestFitness > bestFitness)
+        {
+            bestFitness = lanes[l]->bestFitness;
+        }
+    }
+    evo_Progress_Update(context->config->progress, context->id, trials, iteration, bestFitness, evaluations);
+}
+
+/*
+    Runs this unit's trials several at a time, in lockstep.
+
+    Each lane is a context of its own, working through the trials of one seed after another,
+    so a lane draws exactly the random numbers that a unit running that seed alone would.
+    Every iteration, the fitnesses of all lanes are evaluated together (by one call to the
+    batch fitness operator, if there is one), then each lane does its own selection and breeding.
+    A lane that finishes a trial starts its next one right away, and is masked off
+    once it runs out of seeds. The lanes' stats are added to the unit's at the end.
+*/
+static void _evo_Context_RunLanes(evo_Context* context, evo_uint trialsPerUnit)
+{
+    evo_uint i, l, laneCount, activeCount, populationSize;
+    evo_Config* config;
+    evo_Context* lane;
+    evo_Context** lanes;
+    evo_bool* active;
+    double* fitnesses;
+    evo_bool success;
+
+    config = context->config;
+    laneCount = config->laneCount;
+    populationSize = config->populationSize;
+
+    lanes = malloc(laneCount * sizeof(evo_Context*));
+    active = malloc(laneCount * sizeof(evo_bool));
+    fitnesses = malloc(laneCount * populationSize * sizeof(double));
+    activeCount = 0;
+    for(l = 0; l < laneCount; l++)
+    {
+        lane = lanes[l] = calloc(1, sizeof(evo_Context));
+        lane->config = config;
+        lane->id = context->id;
+        lane->lane = l;
+        lane->seedIndexStart = context->seedIndexStart;
+        lane->seedIndexEnd = context->seedIndexEnd;
+        /* The lanes share their unit's thread, and so its counters. Each has its own track in a trace. */
+        lane->perfGroup = context->perfGroup;
+        if(config->traceBuffers)
+        {
+            lane->traceBuffer = config->traceBuffers[context->id * (laneCount + 1) + 1 + l];
+        }
+        /* No seed yet, so the first trial will need one. */
+        lane->trial = trialsPerUnit;
+        _evo_Context_Start(lane);
+        active[l] = _evo_Context_NextLaneTrial(context, lane, trialsPerUnit);
+        activeCount += active[l];
+    }
+
+    while(activeCount)
+    {
+        context->generationStart = _evo_Context_TraceTime(context);
+        if(config->batchFitness)
+        {
+            /* The whole batch is timed and counted in the unit's own stats. */
+            PHASE_START(context);
+            memset(fitnesses, 0, laneCount * populationSize * sizeof(double));
+            PHASE_END(context, EVO_TIMER_CLEAR);
+            config->batchFitness(lanes, laneCount, active, fitnesses);
+            context->runStats.evaluations += activeCount * populationSize;
+            /* Copy each lane's column out, for its selection operator. */
+            for(l = 0; l < laneCount; l++)
             {
-                if(context->iteration > context->stats.maxSuccessIteration)
+                if(active[l])
                 {
-                    context->stats.maxSuccessIteration = context->iteration;
+                    for(i = 0; i < populationSize; i++)
+                    {
+                        lanes[l]->fitnesses[i] = fitnesses[i * laneCount + l];
+                    }
                 }
-                context->stats.sumSuccessIterations += context->iteration;
-                context->stats.sumSquaredSuccessIterations += context->iteration * context->iteration;
             }
-            /* If the algorithm was not successful, record it. */
-            else
+            PHASE_END(context, EVO_TIMER_FITNESS);
+        }
+        for(l = 0; l < laneCount; l++)
+        {
+            if(!active[l])
             {
-                context->stats.failures++;
+                continue;
             }
-            /* Update context stats. */
-            if(context->trial == 0 || context->iteration < context->stats.minIteration)
+            lane = lanes[l];
+            lane->generationStart = _evo_Context_TraceTime(lane);
+            if(!config->batchFitness)
             {
-                context->stats.minIteration = context->iteration;
+                _evo_Context_Evaluate(lane);
             }
-            if(context->iteration > context->stats.maxIteration)
+            success = _evo_Context_Breed(lane);
+            _evo_Context_Trace(lane, "generation", lane->generationStart, "iteration", lane->iteration);
+            if(!success)
             {
-                context->stats.maxIteration = context->iteration;
+                lane->iteration++;
             }
-            if(context->bestFitness > context->stats.bestFitness)
+            if(success || lane->iteration >= config->maxIterations)
             {
-                context->stats.bestFitness = context->bestFitness;
+                _evo_Context_EndTrial(lane, success);
+                lane->trial++;
+                if(!_evo_Context_NextLaneTrial(context, lane, trialsPerUnit))
+                {
+                    active[l] = 0;
+                    activeCount--;
+                }
             }
-            
-            context->stats.sumIterations += context->iteration;
-            context->stats.sumSquaredIterations += context->iteration * context->iteration;
-            
         }
-        /* Calculate the number of trials. */
-        context->stats.trials += context->trial;
+        _evo_Context_Trace(context, "lockstep", context->generationStart, NULL, 0);
+        if(config->progress)
+        {
+            _evo_Context_PublishLanes(context, lanes, laneCount, active);
+        }
     }
-    
-    /* Invoke all user end-of-run callbacks */
-    for(i = 0; i < config->contextEnd.count; i++)
+
+    for(l = 0; l < laneCount; l++)
     {
-        config->contextEnd.cb[i](context, config->contextEnd.param[i]);
+        _evo_Context_End(lanes[l]);
+        _evo_Stats_Add(&context->stats, &lanes[l]->stats);
+        _evo_RunStats_Add(&context->runStats, &lanes[l]->runStats);
+        free(lanes[l]);
     }
-    
-    /* Free the population */
-    context->config->populationFinalizer(context);
+    free(lanes);
+    free(active);
+    free(fitnesses);
+}
 
-    /* Free the previously necessary arrays */
-    free(context->fitnesses);
-    free(context->breedEvents);
-    free(context->markedGenes);
-    
-    /* Ding ding ding ding. */
-    return NULL;
+/*
+    Fills the fitnesses from the payoff matrix, after replaying every game
+    that involves a dirty gene. With k dirty genes, this plays about k * n games instead of n * n / 2.
+*/
+static void _evo_Context_PairwiseFitness(evo_Context* context)
+{
+    evo_uint i, j, n;
+    double payoffA, payoffB;
+    double* payoffs;
+    double* payoffSums;
+    evo_bool* dirtyGenes;
+    evo_PairwiseFitnessOperator pairwiseFitness;
+
+    n = context->config->populationSize;
+    payoffs = context->payoffs;
+    payoffSums = context->payoffSums;
+    dirtyGenes = context->dirtyGenes;
+    pairwiseFitness = context->config->pairwiseFitness;
+
+    for(i = 0; i < n; i++)
+    {
+        if(!dirtyGenes[i])
+        {
+            continue;
+        }
+        for(j = 0; j < n; j++)
+        {
+            /* Don't play yourself, or a dirty gene that already played you. */
+            if(j == i || (j < i && dirtyGenes[j]))
+            {
+                continue;
+            }
+            pairwiseFitness(context, context->genes[i], context->genes[j], &payoffA, &payoffB);
+            /* Row sums of clean genes are patched up by the difference. */
+            payoffSums[j] += payoffB - payoffs[(size_t) j * n + i];
+            payoffs[(size_t) i * n + j] = payoffA;
+            payoffs[(size_t) j * n + i] = payoffB;
+        }
+    }
+    for(i = 0; i < n; i++)
+    {
+        /* Row sums of dirty genes are recounted, so that rounding errors can't pile up. */
+        if(dirtyGenes[i])
+        {
+            payoffSums[i] = 0;
+            for(j = 0; j < n; j++)
+            {
+                payoffSums[i] += payoffs[(size_t) i * n + j];
+            }
+            dirtyGenes[i] = 0;
+        }
+        context->fitnesses[i] = (n > 1) ? payoffSums[i] / (n - 1) : 0;
+    }
 }
 
 evo_bool evo_Context_AddBreedEvent(evo_Context* context, evo_uint pa, evo_uint pb, evo_uint ca, evo_uint cb)
@@ -515,6 +1420,11 @@ evo_uint evo_Context_GetPopulationSize(evo_Context* context)
     return context->config->populationSize;
 }
 
+evo_uint evo_Context_GetMaxIterations(evo_Context* context)
+{
+    return context->config->maxIterations;
+}
+
 
 static evo_bool _evo_NextSeed(evo_Context* context)
 {
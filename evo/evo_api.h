@@ -7,6 +7,20 @@
 #define EVO_USE_RAND_R
 #endif
 
+/*
+    Define this (here, or when building the library) to time each phase of every iteration
+    into evo_RunStats.phaseTime. Otherwise the timers compile to nothing.
+*/
+/*#define EVO_USE_PHASE_TIMERS*/
+/*
+    Define this too to count hardware events (cycles, instructions, cache and branch misses)
+    in each phase, into evo_RunStats.phaseCounters. See evo_perf.h. It turns on the phase timers.
+*/
+/*#define EVO_USE_PERF_COUNTERS*/
+#if defined(EVO_USE_PERF_COUNTERS) && !defined(EVO_USE_PHASE_TIMERS)
+#define EVO_USE_PHASE_TIMERS
+#endif
+
 
 /* An wrapper for boolean types, since C's stdbool is only C99. */
 #define EVO_TRUE 1
@@ -17,11 +31,28 @@ typedef int evo_bool;
     Also allows me to swap internal representation easier, even though I'm not likely to.
 */
 typedef unsigned int evo_uint;
+/*
+    A 64-bit unsigned integer, for bitsets and packed gene words.
+    (Visual C++ has no stdint.h, so it gets its own spelling.)
+*/
+#ifdef _MSC_VER
+typedef unsigned __int64 evo_uint64;
+#else
+#include <stdint.h>
+typedef uint64_t evo_uint64;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /* Here we declare the structures but do not define them. */
 typedef struct evo_Config evo_Config;
 typedef struct evo_Context evo_Context;
 typedef struct evo_Stats evo_Stats;
+typedef struct evo_RunStats evo_RunStats;
+typedef struct evo_PerfGroup evo_PerfGroup;
+typedef struct evo_TraceBuffer evo_TraceBuffer;
 
 
 
@@ -70,6 +101,31 @@ typedef void (*evo_PopulationFinalizer)(evo_Context* context);
     Iterates over all genes, and returns a numeric value, assessing how good thaat particular gene is.
 */
 typedef void (*evo_FitnessOperator)(evo_Context* context);
+/*
+    The pairwise fitness operator.
+    
+    Plays one gene against another, and writes the payoff that each of them earned.
+    This is used instead of a fitness operator for competitive problems,
+    where a gene is only as good as how it does against the rest of the population.
+    
+    It must give the same payoffs every time it is given the same pair of genes,
+    since the results are kept around for as long as neither gene changes.
+*/
+typedef void (*evo_PairwiseFitnessOperator)(evo_Context* context,
+    void* geneA, void* geneB, double* payoffA, double* payoffB);
+/*
+    The batch fitness operator.
+    
+    Evaluates the populations of several lanes (trials running in lockstep) at once.
+    The fitnesses are laid out lane by lane within each gene, so the fitness of gene i
+    in lane l goes in fitnesses[i * laneCount + l], and a kernel can handle one lane per
+    SIMD element. They are cleared beforehand.
+    
+    Lanes that aren't active have finished all of their trials (or never had one to start),
+    and their genes and fitnesses should not be touched.
+*/
+typedef void (*evo_BatchFitnessOperator)(evo_Context** lanes, evo_uint laneCount,
+    const evo_bool* active, double* fitnesses);
 /*
     The selection operator.
     
@@ -104,6 +160,65 @@ typedef void (*evo_MutationOperator)(evo_Context* context, void* gene);
     However, when that occurs, the algorithm marks that particular iteration as a failure.
 */
 typedef evo_bool (*evo_SuccessPredicate)(evo_Context* context);
+/*
+    The trial runner.
+    
+    Runs every iteration of a trial, in place of the library's own loop over the
+    fitness, selection, crossover, mutation and success callbacks.
+    This lets a front-end (like the C++ one in evo.hpp) compile the loop with its
+    operators inlined, while seeds, threads and stats are still handled here.
+    
+    It is called after the population initializer. It should leave the context's iteration
+    at the one that succeeded, or at the max iterations if none did,
+    and return whether the trial succeeded.
+    It should bracket each generation with evo_Context_StartGeneration and
+    evo_Context_EndGeneration, and end its phases with evo_Context_EndPhase,
+    or the phase timers, trace and progress page won't see its generations.
+*/
+typedef evo_bool (*evo_TrialRunner)(evo_Context* context, void* param);
+
+/*
+    Stages.
+    
+    Extra steps that run every iteration, such as local search, elitism, migration or logging.
+    Each stage belongs to a phase of the iteration:
+        EVO_PHASE_EVALUATED - after the fitness operator, before the best fitness is found.
+        EVO_PHASE_SELECTED - after the selection operator, before breeding.
+        EVO_PHASE_BRED - after crossover and mutation, before the success predicate.
+    
+    And it declares how much of the population each call works on, which is its promise about
+    what it touches:
+        EVO_STAGE_SERIAL - called once, and may look at anything.
+        EVO_STAGE_PER_GENE - called once for each gene (index is the gene), and only touches
+            that gene and its fitness.
+        EVO_STAGE_PER_EVENT - called once for each breeding event (index is the offset of the event
+            in breedEvents), and only touches that event's genes. Not allowed in EVO_PHASE_EVALUATED.
+    
+    Stages in a phase run in the order they were added. But since per-gene and per-event stages
+    don't depend on each other, a run of them with the same policy is done in one pass,
+    each gene (or event) going through all of them in turn. The last per-gene pass of
+    EVO_PHASE_EVALUATED also finds the best fitness, and the first per-event pass of
+    EVO_PHASE_BRED runs inside the breeding loop, right after each event is bred.
+    
+    With pairwise fitness, only the children of breeding events have their games replayed,
+    so stages shouldn't change any other genes.
+*/
+typedef enum
+{
+    EVO_PHASE_EVALUATED,
+    EVO_PHASE_SELECTED,
+    EVO_PHASE_BRED,
+    EVO_PHASE_COUNT
+} evo_StagePhase;
+
+typedef enum
+{
+    EVO_STAGE_SERIAL,
+    EVO_STAGE_PER_GENE,
+    EVO_STAGE_PER_EVENT
+} evo_StagePolicy;
+
+typedef void (*evo_StageCallback)(evo_Context* context, evo_uint index, void* param);
 
 /*
     A callback into user code.
@@ -121,6 +236,36 @@ typedef void (*evo_UserCallback)(evo_Context* context, void* param);
 */
 typedef void (*evo_UserFinalizer)(void* param);
 
+/* How much gets logged. Each level includes the ones before it. */
+typedef enum
+{
+    /* Nothing. Logging then costs a comparison, and the drain thread isn't started. */
+    EVO_LOG_SILENT,
+    /* Things that went wrong, like a trace that couldn't be written. */
+    EVO_LOG_ERROR,
+    EVO_LOG_WARNING,
+    /* Each seed a unit starts, and the end of the run. The default. */
+    EVO_LOG_INFO,
+    /* How each trial ended. */
+    EVO_LOG_DEBUG,
+    EVO_LOG_LEVEL_COUNT
+} evo_LogLevel;
+
+/* The unit given for records from the configuration itself, rather than one of its units. */
+#define EVO_LOG_NO_UNIT ((evo_uint) -1)
+
+/*
+    Receives log records, each one message without a trailing newline.
+
+    The units' threads never call it. They put their records in rings, which a background
+    thread drains into the sink. So it's only called by one thread at a time, and needn't be
+    thread-safe, though it isn't always called by the same thread.
+*/
+typedef void (*evo_LogSink)(evo_LogLevel level, evo_uint unit, const char* message, void* param);
+
+/* Returns the name of a log level, like "info". */
+const char* evo_LogLevelName(evo_LogLevel level);
+
 /* Creates a new cnfiguration for the evolutionary algorithm. */
 evo_Config* evo_Config_New();
 /*
@@ -137,6 +282,10 @@ evo_bool evo_Config_IsUsed(evo_Config* config);
     Returns the stats associated with a run of the configuration.
 */
 evo_Stats* evo_Config_GetStats(evo_Config* config);
+/*
+    Returns the timings and counts taken over a run of the configuration.
+*/
+evo_RunStats* evo_Config_GetRunStats(evo_Config* config);
 
 /* 
     The crucial settings for the evolutionary algorithm.
@@ -166,6 +315,27 @@ evo_Stats* evo_Config_GetStats(evo_Config* config);
         (Optional) When set, overrides the default setting of
         one pseudo-random number stream per unit.
         (Might be useful when comparing for consistency across different unit counts.)
+    Lane count:
+        (Optional) When more than 1, each unit runs this many trials at a time, in lockstep.
+        Every lane gets its own context and works through its own random streams, and the
+        fitnesses of all lanes are evaluated together each iteration. Where every context
+        has its own random state (rand_r), lanes draw the same random numbers that a unit
+        running their streams alone would.
+        Helps most with small populations, where a batch fitness operator can do one
+        lane per SIMD element.
+    Trace file:
+        (Optional) When set, every unit records when each of its trials and generations ran
+        (and each phase, with EVO_USE_PHASE_TIMERS), and they're written to this file as
+        Chrome trace-event JSON at the end of the run, to be viewed in chrome://tracing or
+        https://ui.perfetto.dev. Each unit gets a track, and so does each of its lanes.
+        The filename isn't copied, so it has to stay valid until the run is over.
+    Progress name:
+        (Optional) When set, every unit publishes its trials, iteration, best fitness and
+        evaluations once a generation to a shared memory page with this name, which evo-top
+        can watch while the run goes (see evo_progress.h). The page is removed at the end of the run.
+        The name isn't copied either.
+    Log level:
+        (Optional) How much to log (see evo_LogLevel). EVO_LOG_INFO by default.
 */
 void evo_Config_SetUnitCount(evo_Config* config, evo_uint unitCount);
 void evo_Config_SetTrials(evo_Config* config, evo_uint trials);
@@ -173,6 +343,10 @@ void evo_Config_SetMaxIterations(evo_Config* config, evo_uint maxIterations);
 void evo_Config_SetPopulationSize(evo_Config* config, evo_uint populationSize);
 void evo_Config_SetRandomSeed(evo_Config* config, evo_uint randomSeed);
 void evo_Config_SetRandomStreamCount(evo_Config* config, evo_uint randomStreamCount);
+void evo_Config_SetLaneCount(evo_Config* config, evo_uint laneCount);
+void evo_Config_SetTraceFile(evo_Config* config, const char* traceFile);
+void evo_Config_SetProgressName(evo_Config* config, const char* progressName);
+void evo_Config_SetLogLevel(evo_Config* config, evo_LogLevel logLevel);
 /*
     Callbacks
     
@@ -182,11 +356,34 @@ void evo_Config_SetPopulationInitializer(evo_Config* config, evo_PopulationIniti
 void evo_Config_SetPopulationFinalizer(evo_Config* config, evo_PopulationFinalizer populationFinalizer);
 
 void evo_Config_SetFitnessOperator(evo_Config* config, evo_FitnessOperator fitnessOperator);
+/*
+    Sets a pairwise fitness operator, which replaces the fitness operator.
+    
+    Every gene plays every other gene, and its fitness is its mean payoff over those games.
+    Each context keeps the whole payoff matrix, so after the first generation
+    only the games involving genes that were rewritten by breeding are played again.
+*/
+void evo_Config_SetPairwiseFitness(evo_Config* config, evo_PairwiseFitnessOperator pairwiseFitness);
+/*
+    Sets a batch fitness operator, which replaces both of the above.
+    Without lanes, it is called for one lane at a time.
+*/
+void evo_Config_SetBatchFitness(evo_Config* config, evo_BatchFitnessOperator batchFitness);
 void evo_Config_SetSelectionOperator(evo_Config* config, evo_SelectionOperator selectionOperator);
 void evo_Config_SetCrossoverOperator(evo_Config* config, evo_CrossoverOperator crossoverOperator);
 void evo_Config_SetMutationOperator(evo_Config* config, evo_MutationOperator mutationOperator);
 
 void evo_Config_SetSuccessPredicate(evo_Config* config, evo_SuccessPredicate terminationPredicate);
+/*
+    Sets a trial runner. When there is one, the fitness, selection, crossover, mutation
+    and success callbacks aren't needed, and lanes can't be used.
+*/
+void evo_Config_SetTrialRunner(evo_Config* config, evo_TrialRunner trialRunner, void* param);
+/* Sets where log records go. Without one, errors and warnings go to stderr, and the rest to stdout. */
+void evo_Config_SetLogSink(evo_Config* config, evo_LogSink logSink, void* param);
+/* Adds a stage to the end of a phase. There is no limit on the number of stages. */
+void evo_Config_AddStage(evo_Config* config, evo_StagePhase phase, evo_StagePolicy policy,
+    evo_StageCallback cb, void* param);
 /* Optional callbacks. */
 void evo_Config_AddContextStartCallback(evo_Config* config, evo_UserCallback cb, void* param);
 void evo_Config_AddContextEndCallback(evo_Config* config, evo_UserCallback cb, void* param);
@@ -194,6 +391,39 @@ void evo_Config_AddConfigFinalizer(evo_Config* config, evo_UserFinalizer cb, voi
 /* Starts execution across multiple threads. */
 void evo_Config_Execute(evo_Config* config);
 
+/* The phases of an iteration, as timed by EVO_USE_PHASE_TIMERS. */
+typedef enum
+{
+    /* The population initializer, at the start of each trial. */
+    EVO_TIMER_INITIALIZE,
+    /* Clearing the fitnesses, breeding events and marks. */
+    EVO_TIMER_CLEAR,
+    /* The fitness operator (or the batch or pairwise fitness operator). */
+    EVO_TIMER_FITNESS,
+    /* The stages after evaluation, and finding the best fitness. */
+    EVO_TIMER_EVALUATED,
+    /* The selection operator, and the stages after selection. */
+    EVO_TIMER_SELECTION,
+    /* Crossover, mutation, and the stages after breeding. */
+    EVO_TIMER_BREEDING,
+    /* The success predicate. */
+    EVO_TIMER_SUCCESS,
+    EVO_TIMER_COUNT
+} evo_PhaseTimer;
+
+/* Returns the name of a phase timer, for reports. */
+const char* evo_PhaseTimerName(evo_PhaseTimer timer);
+
+/* The hardware events counted by EVO_USE_PERF_COUNTERS. */
+typedef enum
+{
+    EVO_COUNTER_CYCLES,
+    EVO_COUNTER_INSTRUCTIONS,
+    EVO_COUNTER_CACHE_MISSES,
+    EVO_COUNTER_BRANCH_MISSES,
+    EVO_COUNTER_COUNT
+} evo_PerfCounter;
+
 /* A structure containing overall stats. Can be used to construct other statistics when the program finishes. */
 struct evo_Stats
 {
@@ -220,6 +450,38 @@ struct evo_Stats
     double bestFitness;
 };
 
+/*
+    Timings and counts taken over a run, kept apart from evo_Stats so that struct,
+    and the evo_Context that holds one, keep their layout.
+*/
+struct evo_RunStats
+{
+    /* Seconds of CPU time used by the units' threads, added together. */
+    double cpuTime;
+    /* Seconds of wall time that evo_Config_Execute took. Only set in the config's run stats. */
+    double wallTime;
+    /*
+        The number of fitness evaluations, one per gene per iteration.
+        Trial runners replace the loop that counts these, so they count none unless they add to it.
+    */
+    double evaluations;
+    /* Evaluations per second of wall time. Only set in the config's run stats. */
+    double evaluationsPerSecond;
+    /*
+        Seconds spent in each phase, added together over the units.
+        All zero unless the library was built with EVO_USE_PHASE_TIMERS.
+    */
+    double phaseTime[EVO_TIMER_COUNT];
+    /*
+        Hardware events counted in each phase, added together over the units.
+        All zero unless the library was built with EVO_USE_PERF_COUNTERS,
+        and only counted by units that could open the counters (perfUnits of them).
+        A counter the CPU doesn't have stays zero.
+    */
+    double phaseCounters[EVO_TIMER_COUNT][EVO_COUNTER_COUNT];
+    evo_uint perfUnits;
+};
+
 /* A structure containing various information utilized by each thread in the evolutionary algorithm. */
 struct evo_Context
 {
@@ -281,6 +543,36 @@ struct evo_Context
     evo_uint seedIndexStart, seedIndexEnd;
     evo_uint seedIndex;
     evo_uint prevSeed, seed;
+
+    /* Newer fields go below, so the ones above keep their offsets. */
+
+    /* Userdata for fitness operator. */
+    void* fitnessUserData;
+    /* Userdata for the gene encoding (initializer, crossover and mutation operators). */
+    void* geneUserData;
+    
+    /*
+        Pairwise fitness data. For internal use.
+        The payoff each gene got against each other gene (row-major), the sum of each row,
+        and a checklist of genes whose games need to be replayed.
+    */
+    double* payoffs;
+    double* payoffSums;
+    evo_bool* dirtyGenes;
+
+    /* When the current phase started, and the counters then, for the phase timers. For internal use. */
+    double phaseStart;
+    double phaseCounterStart[EVO_COUNTER_COUNT];
+    evo_PerfGroup* perfGroup;
+    /* Where this context's trace goes, and when its current trial and generation started. For internal use. */
+    evo_TraceBuffer* traceBuffer;
+    double trialStart, generationStart;
+
+    /* Which lane of its unit this context is, when trials run in lockstep. Otherwise 0. */
+    evo_uint lane;
+
+    /* Timings and counts for this context, added into the config's run stats at the end. */
+    evo_RunStats runStats;
 };
 
 /*
@@ -301,6 +593,38 @@ void evo_Context_AddUnmarkedBreedEvent(evo_Context* context,
     Returns the population size.
 */
 evo_uint evo_Context_GetPopulationSize(evo_Context* context);
+/*
+    Returns the maximum number of iterations for a trial.
+*/
+evo_uint evo_Context_GetMaxIterations(evo_Context* context);
+/*
+    Runs every stage of a phase, one pass per run of stages with the same policy.
+    For trial runners, which replace the loop that would otherwise do this.
+    Returns the number of stages in the phase.
+*/
+evo_uint evo_Context_RunStages(evo_Context* context, evo_StagePhase phase);
+/*
+    Steps of the normal loop, for trial runners that only replace part of it.
+    Select clears the breeding events and marks, then calls the selection operator.
+    FindBestFitness sets bestFitness to the maximum of the fitnesses.
+*/
+void evo_Context_Select(evo_Context* context);
+void evo_Context_FindBestFitness(evo_Context* context);
+/*
+    The normal loop's hooks for the phase timers, the trace and the progress page,
+    for trial runners to call the same way.
+    StartGeneration starts a generation's span and its first phase.
+    EndPhase adds the time since the last phase ended to a timer, and starts the next phase.
+    EndGeneration records the generation's span, and publishes the unit's progress.
+*/
+void evo_Context_StartGeneration(evo_Context* context);
+void evo_Context_EndPhase(evo_Context* context, evo_PhaseTimer timer);
+void evo_Context_EndGeneration(evo_Context* context);
+/*
+    Logs a message from a unit's thread, printf style, if the level is being logged.
+    Messages are cut short at 255 characters, and shouldn't end in a newline.
+*/
+void evo_Context_Log(evo_Context* context, evo_LogLevel level, const char* format, ...);
 
 /*
     Generates a random double in the interval [0, 1).
@@ -312,4 +636,8 @@ double evo_Random(evo_Context* context);
 */
 int evo_RandomInt(evo_Context* context, int low, int high);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
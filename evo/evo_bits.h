@@ -0,0 +1,136 @@
+#ifndef EVO_BITS_H
+#define EVO_BITS_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Small bit-twiddling helpers shared by the modules that work on packed 64-bit words.
+    These are defined in the header so that they can be inlined into inner loops.
+*/
+#ifdef _MSC_VER
+#define EVO_INLINE static __inline
+#else
+#define EVO_INLINE static inline
+#endif
+
+/* Returns the number of set bits in a word. */
+EVO_INLINE evo_uint evo_PopCount64(evo_uint64 x)
+{
+#ifdef __GNUC__
+    return (evo_uint) __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (evo_uint) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Returns the index of the lowest set bit in a word. The word must not be zero. */
+EVO_INLINE evo_uint evo_CountTrailingZeros64(evo_uint64 x)
+{
+#ifdef __GNUC__
+    return (evo_uint) __builtin_ctzll(x);
+#else
+    evo_uint n = 0;
+    while(!(x & 1))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Returns the total number of set bits in an array of words. */
+EVO_INLINE evo_uint evo_PopCountWords(const evo_uint64* words, evo_uint count)
+{
+    evo_uint i;
+    evo_uint total = 0;
+    for(i = 0; i < count; i++)
+    {
+        total += evo_PopCount64(words[i]);
+    }
+    return total;
+}
+
+/*
+    Returns the bits of the w-th word that fall in the bit range [low, high)
+    of an array of words.
+*/
+EVO_INLINE evo_uint64 evo_BitRangeMask(evo_uint w, evo_uint low, evo_uint high)
+{
+    evo_uint64 mask = ~((evo_uint64) 0);
+    if(high <= w * 64 || low >= (w + 1) * 64)
+    {
+        return 0;
+    }
+    if(low > w * 64)
+    {
+        mask &= mask << (low - w * 64);
+    }
+    if(high < (w + 1) * 64)
+    {
+        mask &= ~(~((evo_uint64) 0) << (high - w * 64));
+    }
+    return mask;
+}
+
+/*
+    Returns the bit index of the n-th (zero-based) set bit in an array of words.
+    If there are not that many set bits, returns count * 64.
+*/
+EVO_INLINE evo_uint evo_NthSetBit(const evo_uint64* words, evo_uint count, evo_uint n)
+{
+    evo_uint i, c;
+    evo_uint64 w;
+    for(i = 0; i < count; i++)
+    {
+        c = evo_PopCount64(words[i]);
+        if(n < c)
+        {
+            w = words[i];
+            while(n--)
+            {
+                /* Drop the lowest set bit. */
+                w &= w - 1;
+            }
+            return i * 64 + evo_CountTrailingZeros64(w);
+        }
+        n -= c;
+    }
+    return count * 64;
+}
+
+/*
+    A fast stream of random words (splitmix64), for operators that need lots of random bits.
+    Seed it from the context's generator on each call, so results still follow the context's seed.
+*/
+typedef struct
+{
+    evo_uint64 state;
+} evo_WordStream;
+
+EVO_INLINE void evo_WordStream_Seed(evo_WordStream* stream, evo_Context* context)
+{
+    stream->state = ((evo_uint64) evo_RandomInt(context, 0, 1 << 30) << 32)
+        ^ (evo_uint64) evo_RandomInt(context, 0, 1 << 30);
+}
+
+EVO_INLINE evo_uint64 evo_WordStream_Next(evo_WordStream* stream)
+{
+    evo_uint64 z = (stream->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
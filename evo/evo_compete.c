@@ -0,0 +1,306 @@
+#include <stdlib.h>
+#include <string.h>
+#include "evo_compete.h"
+#include "evo_bits.h"
+
+typedef enum
+{
+    COMPETE_SAMPLED,
+    COMPETE_HALL_OF_FAME,
+    COMPETE_SWISS
+} CompetitionMode;
+
+typedef struct
+{
+    CompetitionMode mode;
+    evo_PairwiseFitnessOperator game;
+    evo_uint populationSize;
+    /* Opponents per gene (sampled, hall of fame), or rounds (swiss). */
+    evo_uint opponents;
+    evo_uint hallSize;
+    evo_uint geneSize;
+} CompetitionConfig;
+
+/* A gene's place in the Swiss ranking. */
+typedef struct
+{
+    double score;
+    evo_uint tieBreak;
+    evo_uint gene;
+} SwissEntry;
+
+typedef struct
+{
+    CompetitionConfig* competitionConfig;
+    /* Payoff totals and games played by each gene this generation. */
+    double* totals;
+    evo_uint* games;
+    SwissEntry* ranking;
+    /* Hall of fame: a ring of gene copies. */
+    unsigned char* hall;
+    evo_uint hallCount;
+    evo_uint hallNext;
+    /* The competition's own random stream. */
+    evo_WordStream random;
+} CompetitionContext;
+
+static void Use(evo_Config* config, CompetitionConfig* competitionConfig);
+static void ContextStart(evo_Context* context, void* data);
+static void ContextEnd(evo_Context* context, void* data);
+static void Fitness(evo_Context* context);
+
+void evo_UseSampledCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint opponents)
+{
+    CompetitionConfig* competitionConfig = calloc(1, sizeof(CompetitionConfig));
+    competitionConfig->mode = COMPETE_SAMPLED;
+    competitionConfig->game = game;
+    competitionConfig->populationSize = populationSize;
+    competitionConfig->opponents = opponents;
+    Use(config, competitionConfig);
+}
+
+void evo_UseHallOfFameCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint opponents, evo_uint hallSize, evo_uint geneSize)
+{
+    CompetitionConfig* competitionConfig = calloc(1, sizeof(CompetitionConfig));
+    competitionConfig->mode = COMPETE_HALL_OF_FAME;
+    competitionConfig->game = game;
+    competitionConfig->populationSize = populationSize;
+    competitionConfig->opponents = opponents;
+    competitionConfig->hallSize = hallSize;
+    competitionConfig->geneSize = geneSize;
+    Use(config, competitionConfig);
+}
+
+void evo_UseSwissCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint rounds)
+{
+    CompetitionConfig* competitionConfig = calloc(1, sizeof(CompetitionConfig));
+    competitionConfig->mode = COMPETE_SWISS;
+    competitionConfig->game = game;
+    competitionConfig->populationSize = populationSize;
+    competitionConfig->opponents = rounds;
+    Use(config, competitionConfig);
+}
+
+/*
+    Sets the competition up as the fitness operator. Every gene needs another gene to play,
+    and the sampled modes draw opponents other than the gene itself, so a population
+    too small for that is turned down: the config is left without a fitness operator,
+    and evo_Config_Execute won't run it.
+*/
+static void Use(evo_Config* config, CompetitionConfig* competitionConfig)
+{
+    if(competitionConfig->populationSize < 2
+        || (competitionConfig->mode != COMPETE_SWISS && competitionConfig->populationSize < competitionConfig->opponents + 1))
+    {
+        evo_Config_SetFitnessOperator(config, NULL);
+        free(competitionConfig);
+        return;
+    }
+    evo_Config_AddContextStartCallback(config, ContextStart, competitionConfig);
+    evo_Config_SetFitnessOperator(config, Fitness);
+    evo_Config_AddContextEndCallback(config, ContextEnd, competitionConfig);
+    evo_Config_AddConfigFinalizer(config, free, competitionConfig);
+}
+
+static void ContextStart(evo_Context* context, void* data)
+{
+    CompetitionContext* competitionContext;
+    CompetitionConfig* competitionConfig = data;
+
+    competitionContext = calloc(1, sizeof(CompetitionContext));
+    competitionContext->competitionConfig = competitionConfig;
+    competitionContext->totals = malloc(sizeof(double) * competitionConfig->populationSize);
+    competitionContext->games = malloc(sizeof(evo_uint) * competitionConfig->populationSize);
+    if(competitionConfig->mode == COMPETE_SWISS)
+    {
+        competitionContext->ranking = malloc(sizeof(SwissEntry) * competitionConfig->populationSize);
+    }
+    if(competitionConfig->mode == COMPETE_HALL_OF_FAME)
+    {
+        competitionContext->hall = malloc(competitionConfig->hallSize * competitionConfig->geneSize);
+    }
+
+    context->fitnessUserData = competitionContext;
+}
+
+static void ContextEnd(evo_Context* context, void* data)
+{
+    CompetitionContext* competitionContext = context->fitnessUserData;
+
+    free(competitionContext->totals);
+    free(competitionContext->games);
+    free(competitionContext->ranking);
+    free(competitionContext->hall);
+    free(competitionContext);
+}
+
+/* Returns a random integer in [0, n). */
+static evo_uint NextRandomInt(CompetitionContext* competitionContext, evo_uint n)
+{
+    return (evo_uint) (((evo_WordStream_Next(&competitionContext->random) >> 32) * n) >> 32);
+}
+
+/* Returns a random gene other than the one given. */
+static evo_uint RandomOpponent(CompetitionContext* competitionContext, evo_uint gene)
+{
+    evo_uint j = NextRandomInt(competitionContext, competitionContext->competitionConfig->populationSize - 1);
+    return (j >= gene) ? j + 1 : j;
+}
+
+/* Plays two genes of the population against each other, and credits both. */
+static void Play(evo_Context* context, CompetitionContext* competitionContext, evo_uint a, evo_uint b)
+{
+    double payoffA, payoffB;
+
+    competitionContext->competitionConfig->game(context, context->genes[a], context->genes[b], &payoffA, &payoffB);
+    competitionContext->totals[a] += payoffA;
+    competitionContext->totals[b] += payoffB;
+    competitionContext->games[a]++;
+    competitionContext->games[b]++;
+}
+
+static void SampledFitness(evo_Context* context, CompetitionContext* competitionContext)
+{
+    evo_uint i, k;
+    CompetitionConfig* competitionConfig = competitionContext->competitionConfig;
+
+    for(i = 0; i < competitionConfig->populationSize; i++)
+    {
+        for(k = 0; k < competitionConfig->opponents; k++)
+        {
+            Play(context, competitionContext, i, RandomOpponent(competitionContext, i));
+        }
+    }
+}
+
+static void HallOfFameFitness(evo_Context* context, CompetitionContext* competitionContext)
+{
+    evo_uint i, k, best;
+    double payoffA, payoffB;
+    void* opponent;
+    CompetitionConfig* competitionConfig = competitionContext->competitionConfig;
+
+    /* A new trial starts with an empty hall. */
+    if(context->iteration == 0)
+    {
+        competitionContext->hallCount = 0;
+        competitionContext->hallNext = 0;
+    }
+
+    if(!competitionContext->hallCount)
+    {
+        SampledFitness(context, competitionContext);
+    }
+    else
+    {
+        for(i = 0; i < competitionConfig->populationSize; i++)
+        {
+            for(k = 0; k < competitionConfig->opponents; k++)
+            {
+                opponent = competitionContext->hall
+                    + NextRandomInt(competitionContext, competitionContext->hallCount) * competitionConfig->geneSize;
+                competitionConfig->game(context, context->genes[i], opponent, &payoffA, &payoffB);
+                competitionContext->totals[i] += payoffA;
+                competitionContext->games[i]++;
+            }
+        }
+    }
+
+    /* Induct this generation's best. */
+    if(competitionConfig->hallSize)
+    {
+        best = 0;
+        for(i = 1; i < competitionConfig->populationSize; i++)
+        {
+            if(competitionContext->totals[i] * competitionContext->games[best]
+                > competitionContext->totals[best] * competitionContext->games[i])
+            {
+                best = i;
+            }
+        }
+        memcpy(competitionContext->hall + competitionContext->hallNext * competitionConfig->geneSize,
+            context->genes[best], competitionConfig->geneSize);
+        competitionContext->hallNext = (competitionContext->hallNext + 1) % competitionConfig->hallSize;
+        if(competitionContext->hallCount < competitionConfig->hallSize)
+        {
+            competitionContext->hallCount++;
+        }
+    }
+}
+
+/* Orders the Swiss ranking from the highest score to the lowest. */
+static int CompareSwissEntries(const void* a, const void* b)
+{
+    const SwissEntry* x = a;
+    const SwissEntry* y = b;
+    if(x->score != y->score)
+    {
+        return (x->score > y->score) ? -1 : 1;
+    }
+    if(x->tieBreak != y->tieBreak)
+    {
+        return (x->tieBreak < y->tieBreak) ? -1 : 1;
+    }
+    return (x->gene < y->gene) ? -1 : (x->gene > y->gene);
+}
+
+static void SwissFitness(evo_Context* context, CompetitionContext* competitionContext)
+{
+    evo_uint i, round;
+    SwissEntry* ranking = competitionContext->ranking;
+    CompetitionConfig* competitionConfig = competitionContext->competitionConfig;
+
+    for(round = 0; round < competitionConfig->opponents; round++)
+    {
+        for(i = 0; i < competitionConfig->populationSize; i++)
+        {
+            ranking[i].gene = i;
+            ranking[i].score = competitionContext->totals[i];
+            ranking[i].tieBreak = (evo_uint) (evo_WordStream_Next(&competitionContext->random) >> 32);
+        }
+        qsort(ranking, competitionConfig->populationSize, sizeof(SwissEntry), CompareSwissEntries);
+        for(i = 0; i + 1 < competitionConfig->populationSize; i += 2)
+        {
+            Play(context, competitionContext, ranking[i].gene, ranking[i + 1].gene);
+        }
+    }
+}
+
+static void Fitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint64 key;
+    CompetitionContext* competitionContext = context->fitnessUserData;
+    CompetitionConfig* competitionConfig = competitionContext->competitionConfig;
+
+    memset(competitionContext->totals, 0, sizeof(double) * competitionConfig->populationSize);
+    memset(competitionContext->games, 0, sizeof(evo_uint) * competitionConfig->populationSize);
+
+    /* Seed this generation's draws from the stream, trial and iteration alone. */
+    key = ((evo_uint64) (context->seedIndex - 1) << 40) ^ ((evo_uint64) context->trial << 20) ^ context->iteration;
+    competitionContext->random.state = key;
+    competitionContext->random.state = evo_WordStream_Next(&competitionContext->random);
+
+    switch(competitionConfig->mode)
+    {
+        case COMPETE_SAMPLED:
+            SampledFitness(context, competitionContext);
+            break;
+        case COMPETE_HALL_OF_FAME:
+            HallOfFameFitness(context, competitionContext);
+            break;
+        case COMPETE_SWISS:
+            SwissFitness(context, competitionContext);
+            break;
+    }
+
+    /* Normalize by games played, since that differs between genes. */
+    for(i = 0; i < competitionConfig->populationSize; i++)
+    {
+        context->fitnesses[i] = competitionContext->games[i]
+            ? competitionContext->totals[i] / competitionContext->games[i] : 0;
+    }
+}
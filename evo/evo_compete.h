@@ -0,0 +1,62 @@
+#ifndef EVO_COMPETE_H
+#define EVO_COMPETE_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Competitive fitness operators that scale past a full round robin.
+
+    Each of these plays genes against each other with the given pairwise fitness operator,
+    and sets a gene's fitness to its mean payoff over the games it played.
+    Opponents are drawn from a separate random stream that only depends on the stream index,
+    trial and iteration, so the draws don't disturb (and aren't disturbed by)
+    the other operators, and a trial plays out the same no matter how many units run.
+*/
+
+/*
+    Sampled opponents.
+
+    Every gene challenges a number of random opponents from the population.
+    A gene also collects the payoff from games it is challenged to, so on average
+    a gene plays about twice the given number of opponents.
+    The population must have more genes than the number of opponents, or the config is turned down.
+*/
+void evo_UseSampledCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint opponents);
+
+/*
+    Hall of fame.
+
+    Every gene plays a number of opponents sampled from a hall of fame,
+    which holds copies of the best gene of each earlier generation in this trial
+    (the oldest are dropped once the hall is full).
+    In the first generation, when the hall is still empty, opponents are sampled from the population.
+
+    Genes are copied into the hall byte-for-byte, so they must be geneSize bytes,
+    and must not hold pointers to other memory. As in the first generation opponents come from
+    the population, it must have more genes than the number of opponents, or the config is turned down.
+*/
+void evo_UseHallOfFameCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint opponents, evo_uint hallSize, evo_uint geneSize);
+
+/*
+    Swiss-system tournament.
+
+    Runs a number of rounds. In each round, genes are ranked by their score so far,
+    and paired off with their neighbour in the ranking, so strong genes meet strong genes.
+    With an odd population, the last-ranked gene sits out the round.
+    Pairings are not checked for rematches. The population must have at least 2 genes,
+    or the config is turned down.
+*/
+void evo_UseSwissCompetition(evo_Config* config, evo_PairwiseFitnessOperator game,
+    evo_uint populationSize, evo_uint rounds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
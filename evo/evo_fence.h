@@ -0,0 +1,23 @@
+#ifndef EVO_FENCE_H
+#define EVO_FENCE_H
+
+/*
+    A memory fence, for data that one thread writes and another reads without a lock
+    (progress pages, log rings, and the payoff cache's segments). Keeps the loads
+    and stores on either side of it from being reordered across it.
+
+    x86 already keeps stores in order with stores, and loads with loads,
+    so there it only has to hold back the compiler.
+*/
+#if defined(_MSC_VER)
+/* Declared by hand, since intrin.h and windows.h don't get along in Visual Studio 2008. */
+void _ReadWriteBarrier(void);
+#pragma intrinsic(_ReadWriteBarrier)
+#define EVO_FENCE() _ReadWriteBarrier()
+#elif defined(__ATOMIC_ACQ_REL)
+#define EVO_FENCE() __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#else
+#define EVO_FENCE() __sync_synchronize()
+#endif
+
+#endif
@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <string.h>
+#include "evo_gene_bitstring.h"
+#include "evo_sample.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define ALIGNMENT 32
+/*
+    Below this rate, mutated bits are found by geometric skips, which cost a log per flip.
+    Above it, masks built from random words are cheaper, at a few words per 64 bits.
+*/
+#define SPARSE_RATE (1.0 / 64)
+
+evo_uint64* evo_Bitstring_New(evo_uint bits)
+{
+    size_t size = sizeof(evo_uint64) * EVO_BITSTRING_WORDS(bits);
+    void* gene;
+#ifdef _MSC_VER
+    gene = _aligned_malloc(size, ALIGNMENT);
+#else
+    if(posix_memalign(&gene, ALIGNMENT, size))
+    {
+        gene = NULL;
+    }
+#endif
+    if(gene)
+    {
+        memset(gene, 0, size);
+    }
+    return gene;
+}
+
+void evo_Bitstring_Free(evo_uint64* gene)
+{
+#ifdef _MSC_VER
+    _aligned_free(gene);
+#else
+    free(gene);
+#endif
+}
+
+/* Returns the mask of the real (non-padding) bits in word w. */
+static evo_uint64 UsedMask(evo_uint bits, evo_uint w)
+{
+    return evo_BitRangeMask(w, 0, bits);
+}
+
+void evo_Bitstring_Randomize(evo_Context* context, evo_uint64* gene, evo_uint bits)
+{
+    evo_uint i;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+    evo_WordStream stream;
+
+    evo_WordStream_Seed(&stream, context);
+    for(i = 0; i < words; i++)
+    {
+        gene[i] = evo_WordStream_Next(&stream) & UsedMask(bits, i);
+    }
+}
+
+#ifdef __AVX2__
+/*
+    Counts the set bits of (a ^ b), or of a if b is NULL, 4 words at a time.
+    Each byte is split into nibbles, which are looked up in a 16-entry table with a shuffle,
+    and the byte counts are summed into 64-bit lanes with a sum of absolute differences.
+*/
+static evo_uint PopCountAvx2(const evo_uint64* a, const evo_uint64* b, evo_uint words)
+{
+    evo_uint i;
+    evo_uint64 lanes[4];
+    __m256i v, counts;
+    __m256i total = _mm256_setzero_si256();
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    const __m256i table = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+
+    for(i = 0; i < words; i += 4)
+    {
+        v = _mm256_load_si256((const __m256i*) (a + i));
+        if(b)
+        {
+            v = _mm256_xor_si256(v, _mm256_load_si256((const __m256i*) (b + i)));
+        }
+        counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(table, _mm256_and_si256(v, lowNibble)),
+            _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    _mm256_storeu_si256((__m256i*) lanes, total);
+    return (evo_uint) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+#endif
+
+evo_uint evo_Bitstring_PopCount(const evo_uint64* gene, evo_uint bits)
+{
+#ifdef __AVX2__
+    return PopCountAvx2(gene, NULL, EVO_BITSTRING_WORDS(bits));
+#else
+    return evo_PopCountWords(gene, EVO_BITSTRING_WORDS(bits));
+#endif
+}
+
+evo_uint evo_Bitstring_Hamming(const evo_uint64* a, const evo_uint64* b, evo_uint bits)
+{
+#ifdef __AVX2__
+    return PopCountAvx2(a, b, EVO_BITSTRING_WORDS(bits));
+#else
+    evo_uint i;
+    evo_uint total = 0;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+    for(i = 0; i < words; i++)
+    {
+        total += evo_PopCount64(a[i] ^ b[i]);
+    }
+    return total;
+#endif
+}
+
+/* Swaps the bits of the parents under the mask to make a word of each child. */
+#define SWAP_MASKED(parentA, parentB, childA, childB, i, mask) \
+    do \
+    { \
+        evo_uint64 swap_ = ((parentA)[i] ^ (parentB)[i]) & (mask); \
+        (childA)[i] = (parentA)[i] ^ swap_; \
+        (childB)[i] = (parentB)[i] ^ swap_; \
+    } while(0)
+
+void evo_Bitstring_TwoPointCrossover(evo_Context* context, evo_uint bits,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB)
+{
+    evo_uint cp1, cp2, i;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+
+    cp1 = evo_RandomInt(context, 0, bits);
+    cp2 = evo_RandomInt(context, 0, bits);
+    if(cp1 > cp2)
+    {
+        i = cp1;
+        cp1 = cp2;
+        cp2 = i;
+    }
+
+    for(i = 0; i < words; i++)
+    {
+        SWAP_MASKED(parentA, parentB, childA, childB, i, evo_BitRangeMask(i, cp1, cp2));
+    }
+}
+
+void evo_Bitstring_UniformCrossover(evo_Context* context, evo_uint bits,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB)
+{
+    evo_uint i;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+    evo_WordStream stream;
+
+    /* Padding bits are zero in both parents, so a random mask there doesn't matter. */
+    evo_WordStream_Seed(&stream, context);
+    for(i = 0; i < words; i++)
+    {
+        SWAP_MASKED(parentA, parentB, childA, childB, i, evo_WordStream_Next(&stream));
+    }
+}
+
+void evo_Bitstring_NPointCrossover(evo_Context* context, evo_uint bits, evo_uint points,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB)
+{
+    evo_uint i, cut;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+    evo_uint64 mask, carry;
+
+    /*
+        Mark the cut points in childA, which isn't needed until the end.
+        The mask is then the running parity of the marks, so no sorting is needed.
+    */
+    memset(childA, 0, sizeof(evo_uint64) * words);
+    for(i = 0; i < points; i++)
+    {
+        cut = evo_RandomInt(context, 0, bits);
+        childA[cut / 64] ^= ((evo_uint64) 1) << (cut % 64);
+    }
+
+    carry = 0;
+    for(i = 0; i < words; i++)
+    {
+        /* Prefix parity within the word, then flip if an odd number of cuts came before it. */
+        mask = childA[i];
+        mask ^= mask << 1;
+        mask ^= mask << 2;
+        mask ^= mask << 4;
+        mask ^= mask << 8;
+        mask ^= mask << 16;
+        mask ^= mask << 32;
+        mask ^= carry;
+        carry = (evo_uint64) 0 - (mask >> 63);
+        SWAP_MASKED(parentA, parentB, childA, childB, i, mask);
+    }
+}
+
+void evo_Bitstring_FlipMutation(evo_Context* context, evo_uint64* gene, evo_uint bits, double rate)
+{
+    evo_uint i, j, low;
+    evo_LocusSampler sampler;
+    evo_uint words = EVO_BITSTRING_WORDS(bits);
+    evo_uint64 mask;
+    evo_uint threshold;
+    evo_WordStream stream;
+
+    if(rate >= 1)
+    {
+        for(i = 0; i < words; i++)
+        {
+            gene[i] ^= UsedMask(bits, i);
+        }
+        return;
+    }
+    if(rate < SPARSE_RATE)
+    {
+        evo_LocusSampler_Start(&sampler, context, bits, rate);
+        while(evo_LocusSampler_Next(&sampler, &i))
+        {
+            gene[i / 64] ^= ((evo_uint64) 1) << (i % 64);
+        }
+        return;
+    }
+
+    /* The rate is rounded down to a multiple of 2^-32. */
+    threshold = (evo_uint) (rate * 4294967296.0);
+    if(rate <= 0 || !threshold)
+    {
+        return;
+    }
+
+    /*
+        Each mask bit has to be set with the given probability. Reading the binary digits
+        of the rate from the lowest set one upward, a word whose bits are set with probability p
+        becomes one with probability p / 2 (AND with a random word) for a 0 digit,
+        or (1 + p) / 2 (OR with a random word) for a 1 digit.
+        So a rate of 2^-k only needs k random words per 64 bits.
+    */
+    low = evo_CountTrailingZeros64(threshold);
+    evo_WordStream_Seed(&stream, context);
+    for(i = 0; i < words && i * 64 < bits; i++)
+    {
+        mask = evo_WordStream_Next(&stream);
+        for(j = low + 1; j < 32; j++)
+        {
+            if(threshold & (1u << j))
+            {
+                mask |= evo_WordStream_Next(&stream);
+            }
+            else
+            {
+                mask &= evo_WordStream_Next(&stream);
+            }
+        }
+        gene[i] ^= mask & UsedMask(bits, i);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef EVO_GENE_BITSTRING_H
+#define EVO_GENE_BITSTRING_H
+
+#include "evo_api.h"
+#include "evo_bits.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A bitstring gene.
+
+    Bit i is bit (i % 64) of word (i / 64). The words are 32-byte aligned, and padded
+    out to a multiple of 4 words (256 bits), so that whole vector registers can be used
+    without special cases at the end. The padding bits are always zero.
+
+    The crossover operators build masks a word at a time, and then swap the
+    masked bits between the parents, rather than copying bit by bit.
+*/
+
+/* Number of words used by a bitstring of the given length, including padding. */
+#define EVO_BITSTRING_WORDS(bits) ((((bits) + 255) / 256) * 4)
+
+/* Allocates a zeroed bitstring, aligned for vector loads. */
+evo_uint64* evo_Bitstring_New(evo_uint bits);
+void evo_Bitstring_Free(evo_uint64* gene);
+
+/* Sets every bit to a random value. */
+void evo_Bitstring_Randomize(evo_Context* context, evo_uint64* gene, evo_uint bits);
+
+/* Returns the number of set bits. */
+evo_uint evo_Bitstring_PopCount(const evo_uint64* gene, evo_uint bits);
+/* Returns the number of bits that differ between two bitstrings. */
+evo_uint evo_Bitstring_Hamming(const evo_uint64* a, const evo_uint64* b, evo_uint bits);
+
+/*
+    Crossover operators. The children take the bits their parent has everywhere,
+    except where the mask is set, where they take the other parent's bits.
+    The children must not be the same bitstrings as the parents.
+*/
+
+/* The mask covers the bits between two random cut points. */
+void evo_Bitstring_TwoPointCrossover(evo_Context* context, evo_uint bits,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB);
+/* Every bit of the mask is random. */
+void evo_Bitstring_UniformCrossover(evo_Context* context, evo_uint bits,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB);
+/*
+    The mask switches on and off at each of the given number of random cut points.
+    Cut points that land on the same bit cancel out.
+*/
+void evo_Bitstring_NPointCrossover(evo_Context* context, evo_uint bits, evo_uint points,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB);
+
+/* Flips each bit with the given probability. */
+void evo_Bitstring_FlipMutation(evo_Context* context, evo_uint64* gene, evo_uint bits, double rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+#include <string.h>
+#include "evo_gene_fsm.h"
+
+/* Returns the number of bits needed to hold the numbers [0, count). */
+static evo_uint BitsFor(evo_uint count)
+{
+    evo_uint bits = 0;
+    while((1u << bits) < count)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+void evo_FsmLayout_Init(evo_FsmLayout* layout, evo_uint stateCount, evo_uint symbolCount, evo_uint outputCount)
+{
+    evo_uint entryBits;
+
+    layout->stateCount = stateCount;
+    layout->symbolCount = symbolCount;
+    layout->outputCount = outputCount;
+
+    layout->stateBits = BitsFor(stateCount);
+    layout->outputBits = BitsFor(outputCount);
+    layout->stateMask = (((evo_uint64) 1) << layout->stateBits) - 1;
+    layout->outputMask = (((evo_uint64) 1) << layout->outputBits) - 1;
+
+    /* Round entries up to a power of two bits, so they never straddle words. */
+    layout->entryShift = 0;
+    entryBits = layout->stateBits + layout->outputBits;
+    while((1u << layout->entryShift) < entryBits)
+    {
+        layout->entryShift++;
+    }
+    layout->wordShift = 6 - layout->entryShift;
+
+    layout->entryCount = stateCount * symbolCount + 1;
+    layout->wordCount = (layout->entryCount + (1 << layout->wordShift) - 1) >> layout->wordShift;
+}
+
+void evo_Fsm_Randomize(evo_Context* context, const evo_FsmLayout* layout, evo_uint64* gene)
+{
+    evo_uint i, state;
+
+    memset(gene, 0, sizeof(evo_uint64) * layout->wordCount);
+    for(i = 0; i < layout->entryCount; i++)
+    {
+        state = evo_RandomInt(context, 0, layout->stateCount);
+        evo_Fsm_SetEntry(layout, gene, i, state, evo_RandomInt(context, 0, layout->outputCount));
+    }
+}
+
+void evo_Fsm_Crossover(evo_Context* context, const evo_FsmLayout* layout,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB)
+{
+    evo_uint cp1, cp2, i;
+    evo_uint64 swap;
+
+    /* The cut points are among the transitions, so the start entry stays with its own parent. */
+    cp1 = evo_RandomInt(context, 0, EVO_FSM_START_ENTRY(layout));
+    cp2 = evo_RandomInt(context, 0, EVO_FSM_START_ENTRY(layout));
+    if(cp1 > cp2)
+    {
+        i = cp1;
+        cp1 = cp2;
+        cp2 = i;
+    }
+
+    /* Entries in [cp1, cp2) come from the other parent. */
+    for(i = 0; i < layout->wordCount; i++)
+    {
+        swap = (parentA[i] ^ parentB[i])
+            & evo_BitRangeMask(i, cp1 << layout->entryShift, cp2 << layout->entryShift);
+        childA[i] = parentA[i] ^ swap;
+        childB[i] = parentB[i] ^ swap;
+    }
+}
+
+void evo_Fsm_Mutate(evo_Context* context, const evo_FsmLayout* layout, evo_uint64* gene)
+{
+    evo_uint choice, entry, state, output;
+
+    /* The initial state, the initial output, a transition's next state, or a transition's output. */
+    choice = evo_RandomInt(context, 0, 4);
+    if(choice < 2)
+    {
+        entry = EVO_FSM_START_ENTRY(layout);
+    }
+    else
+    {
+        entry = evo_RandomInt(context, 0, EVO_FSM_START_ENTRY(layout));
+    }
+    evo_Fsm_GetEntry(layout, gene, entry, &state, &output);
+    if(choice % 2 == 0)
+    {
+        state = evo_RandomInt(context, 0, layout->stateCount);
+    }
+    else
+    {
+        output = evo_RandomInt(context, 0, layout->outputCount);
+    }
+    evo_Fsm_SetEntry(layout, gene, entry, state, output);
+}
@@ -0,0 +1,110 @@
+#ifndef EVO_GENE_FSM_H
+#define EVO_GENE_FSM_H
+
+#include "evo_api.h"
+#include "evo_bits.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A packed finite state machine gene.
+
+    The machine has N states, reads K input symbols, and writes one of M output symbols
+    on every transition (a Mealy machine). Each (state, symbol) pair has an entry holding
+    the next state and the output, and one extra start entry holds the initial state
+    and the output given before any input is read.
+
+    Entries are packed into an array of 64-bit words, each taking a power-of-two
+    number of bits, so finding an entry is shifts and masks.
+    For example, a 4 state, 2 symbol, 2 output machine fits in a single word.
+*/
+typedef struct
+{
+    evo_uint stateCount;
+    evo_uint symbolCount;
+    evo_uint outputCount;
+
+    /* Everything below is worked out by evo_FsmLayout_Init. */
+    evo_uint stateBits;
+    evo_uint outputBits;
+    /* log2 of the bits each entry takes up, and of the entries in each word. */
+    evo_uint entryShift;
+    evo_uint wordShift;
+    evo_uint64 stateMask;
+    evo_uint64 outputMask;
+    /* Number of entries, including the start entry. */
+    evo_uint entryCount;
+    /* Number of words in a gene. */
+    evo_uint wordCount;
+} evo_FsmLayout;
+
+/*
+    Sets up a layout for machines of the given size.
+    Entries can take at most 64 bits, so that's a lot of states.
+*/
+void evo_FsmLayout_Init(evo_FsmLayout* layout, evo_uint stateCount, evo_uint symbolCount, evo_uint outputCount);
+
+/* Index of the start entry. */
+#define EVO_FSM_START_ENTRY(layout) ((layout)->stateCount * (layout)->symbolCount)
+
+/* Reads an entry's next state and output. */
+EVO_INLINE void evo_Fsm_GetEntry(const evo_FsmLayout* layout, const evo_uint64* gene,
+    evo_uint entry, evo_uint* state, evo_uint* output)
+{
+    evo_uint offset = entry << layout->entryShift;
+    evo_uint64 bits = gene[offset >> 6] >> (offset & 63);
+    *state = (evo_uint) (bits & layout->stateMask);
+    *output = (evo_uint) ((bits >> layout->stateBits) & layout->outputMask);
+}
+
+/* Overwrites an entry's next state and output. */
+EVO_INLINE void evo_Fsm_SetEntry(const evo_FsmLayout* layout, evo_uint64* gene,
+    evo_uint entry, evo_uint state, evo_uint output)
+{
+    evo_uint offset = entry << layout->entryShift;
+    evo_uint64 mask = (layout->stateMask | (layout->outputMask << layout->stateBits)) << (offset & 63);
+    evo_uint64 bits = (((evo_uint64) output << layout->stateBits) | state) << (offset & 63);
+    gene[offset >> 6] = (gene[offset >> 6] & ~mask) | bits;
+}
+
+/*
+    Feeds a symbol to the machine in the given state.
+    Returns the next state, and writes the output.
+*/
+EVO_INLINE evo_uint evo_Fsm_Step(const evo_FsmLayout* layout, const evo_uint64* gene,
+    evo_uint state, evo_uint symbol, evo_uint* output)
+{
+    evo_uint next;
+    evo_Fsm_GetEntry(layout, gene, state * layout->symbolCount + symbol, &next, output);
+    return next;
+}
+
+/* Reads the initial state and the output given before any input. */
+EVO_INLINE void evo_Fsm_GetStart(const evo_FsmLayout* layout, const evo_uint64* gene,
+    evo_uint* state, evo_uint* output)
+{
+    evo_Fsm_GetEntry(layout, gene, EVO_FSM_START_ENTRY(layout), state, output);
+}
+
+/* Fills every entry with a random next state and output. */
+void evo_Fsm_Randomize(evo_Context* context, const evo_FsmLayout* layout, evo_uint64* gene);
+/*
+    Two-point crossover over the transitions.
+    The children take the transitions between two random cut points from the other parent,
+    and keep their own parent's start entry.
+*/
+void evo_Fsm_Crossover(evo_Context* context, const evo_FsmLayout* layout,
+    const evo_uint64* parentA, const evo_uint64* parentB, evo_uint64* childA, evo_uint64* childB);
+/*
+    Replaces one of four things, each as likely: the initial state, the initial output,
+    or the next state or the output of one random transition.
+*/
+void evo_Fsm_Mutate(evo_Context* context, const evo_FsmLayout* layout, evo_uint64* gene);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
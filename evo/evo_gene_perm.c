@@ -0,0 +1,280 @@
+#include <string.h>
+#include "evo_gene_perm.h"
+
+void evo_Perm_Randomize(evo_Context* context, evo_uint* perm, evo_uint n)
+{
+    evo_uint i, j, t;
+    for(i = 0; i < n; i++)
+    {
+        perm[i] = i;
+    }
+    for(i = n; i > 1; i--)
+    {
+        j = evo_RandomInt(context, 0, i);
+        t = perm[i - 1];
+        perm[i - 1] = perm[j];
+        perm[j] = t;
+    }
+}
+
+/* Picks a random segment [start, end) of positions. */
+static void RandomSegment(evo_Context* context, evo_uint n, evo_uint* start, evo_uint* end)
+{
+    evo_uint a = evo_RandomInt(context, 0, n + 1);
+    evo_uint b = evo_RandomInt(context, 0, n + 1);
+    *start = a < b ? a : b;
+    *end = a < b ? b : a;
+}
+
+/*
+    Makes one PMX child: it starts as a copy of the other parent, and each value of the segment
+    is swapped into place from wherever it is. Swapping is the same as following the mapping
+    chain, since a value pushed out of the segment lands where the incoming value used to be.
+*/
+static void PmxChild(evo_uint n, evo_uint start, evo_uint end,
+    const evo_uint* segmentParent, const evo_uint* otherParent, evo_uint* child, evo_uint* position)
+{
+    evo_uint i, j, v;
+
+    memcpy(child, otherParent, sizeof(evo_uint) * n);
+    for(i = 0; i < n; i++)
+    {
+        position[child[i]] = i;
+    }
+    for(i = start; i < end; i++)
+    {
+        v = segmentParent[i];
+        j = position[v];
+        position[child[i]] = j;
+        position[v] = i;
+        child[j] = child[i];
+        child[i] = v;
+    }
+}
+
+void evo_Perm_PmxCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch)
+{
+    evo_uint start, end;
+
+    RandomSegment(context, n, &start, &end);
+    PmxChild(n, start, end, parentA, parentB, childA, scratch);
+    PmxChild(n, start, end, parentB, parentA, childB, scratch);
+}
+
+/* Makes one OX child, using used[] to remember which values the segment already holds. */
+static void OxChild(evo_uint n, evo_uint start, evo_uint end,
+    const evo_uint* segmentParent, const evo_uint* otherParent, evo_uint* child, evo_uint* used)
+{
+    evo_uint i, k, v;
+
+    memset(used, 0, sizeof(evo_uint) * n);
+    for(i = start; i < end; i++)
+    {
+        child[i] = segmentParent[i];
+        used[child[i]] = 1;
+    }
+    /* Fill from the end of the segment onward, wrapping around, in the other parent's order. */
+    k = end % n;
+    for(i = 0; i < n; i++)
+    {
+        v = otherParent[(end + i) % n];
+        if(!used[v])
+        {
+            child[k] = v;
+            k = (k + 1) % n;
+        }
+    }
+}
+
+void evo_Perm_OxCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch)
+{
+    evo_uint start, end;
+
+    RandomSegment(context, n, &start, &end);
+    OxChild(n, start, end, parentA, parentB, childA, scratch);
+    OxChild(n, start, end, parentB, parentA, childB, scratch);
+}
+
+void evo_Perm_CycleCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch)
+{
+    evo_uint i, j;
+    evo_bool swap;
+    evo_uint* positionA = scratch;
+    evo_uint* visited = scratch + n;
+
+    for(i = 0; i < n; i++)
+    {
+        positionA[parentA[i]] = i;
+        visited[i] = 0;
+    }
+
+    /* Walk each cycle once. The first keeps the parents' values, the next swaps them, and so on. */
+    swap = 0;
+    for(i = 0; i < n; i++)
+    {
+        if(visited[i])
+        {
+            continue;
+        }
+        j = i;
+        do
+        {
+            visited[j] = 1;
+            childA[j] = swap ? parentB[j] : parentA[j];
+            childB[j] = swap ? parentA[j] : parentB[j];
+            j = positionA[parentB[j]];
+        } while(j != i);
+        swap = !swap;
+    }
+}
+
+double evo_Perm_TourCost(const evo_uint* perm, evo_uint n, evo_PermDistance distance, void* param)
+{
+    evo_uint i;
+    double cost = 0;
+    for(i = 0; i + 1 < n; i++)
+    {
+        cost += distance(perm[i], perm[i + 1], param);
+    }
+    if(n > 1)
+    {
+        cost += distance(perm[n - 1], perm[0], param);
+    }
+    return cost;
+}
+
+void evo_Perm_Swap(evo_uint* perm, evo_uint i, evo_uint j)
+{
+    evo_uint t = perm[i];
+    perm[i] = perm[j];
+    perm[j] = t;
+}
+
+/* Returns the value at position k of the tour, as if positions i and j were swapped. */
+static evo_uint SwappedAt(const evo_uint* perm, evo_uint i, evo_uint j, evo_uint k)
+{
+    return perm[k == i ? j : (k == j ? i : k)];
+}
+
+double evo_Perm_SwapDelta(const evo_uint* perm, evo_uint n, evo_uint i, evo_uint j,
+    evo_PermDistance distance, void* param)
+{
+    /* The edges leaving positions i - 1, i, j - 1 and j, without counting any twice. */
+    evo_uint edges[4];
+    evo_uint count, e, k;
+    double delta = 0;
+
+    if(i == j || n < 3)
+    {
+        return 0;
+    }
+    count = 0;
+    edges[count++] = (i + n - 1) % n;
+    edges[count++] = i;
+    edges[count++] = (j + n - 1) % n;
+    edges[count++] = j;
+    for(e = 0; e < 4; e++)
+    {
+        for(k = 0; k < e; k++)
+        {
+            if(edges[k] == edges[e])
+            {
+                break;
+            }
+        }
+        if(k < e)
+        {
+            continue;
+        }
+        k = edges[e];
+        delta += distance(SwappedAt(perm, i, j, k), SwappedAt(perm, i, j, (k + 1) % n), param)
+            - distance(perm[k], perm[(k + 1) % n], param);
+    }
+    return delta;
+}
+
+void evo_Perm_Insert(evo_uint* perm, evo_uint from, evo_uint to)
+{
+    evo_uint v = perm[from];
+    if(from < to)
+    {
+        memmove(perm + from, perm + from + 1, sizeof(evo_uint) * (to - from));
+    }
+    else
+    {
+        memmove(perm + to + 1, perm + to, sizeof(evo_uint) * (from - to));
+    }
+    perm[to] = v;
+}
+
+double evo_Perm_InsertDelta(const evo_uint* perm, evo_uint n, evo_uint from, evo_uint to,
+    evo_PermDistance distance, void* param)
+{
+    evo_uint v, before, after, a, b;
+
+    if(from == to || n < 3)
+    {
+        return 0;
+    }
+    v = perm[from];
+    before = perm[(from + n - 1) % n];
+    after = perm[(from + 1) % n];
+
+    /* The neighbours v ends up between, in the tour with v taken out. */
+    if(from < to)
+    {
+        a = to;
+        b = (to + 1) % n;
+        if(b == from)
+        {
+            b = (b + 1) % n;
+        }
+    }
+    else
+    {
+        b = to;
+        a = (to + n - 1) % n;
+        if(a == from)
+        {
+            a = (a + n - 1) % n;
+        }
+    }
+    a = perm[a];
+    b = perm[b];
+
+    return distance(before, after, param) - distance(before, v, param) - distance(v, after, param)
+        + distance(a, v, param) + distance(v, b, param) - distance(a, b, param);
+}
+
+void evo_Perm_TwoOpt(evo_uint* perm, evo_uint i, evo_uint j)
+{
+    evo_uint t;
+    while(i < j)
+    {
+        t = perm[i];
+        perm[i] = perm[j];
+        perm[j] = t;
+        i++;
+        j--;
+    }
+}
+
+double evo_Perm_TwoOptDelta(const evo_uint* perm, evo_uint n, evo_uint i, evo_uint j,
+    evo_PermDistance distance, void* param)
+{
+    evo_uint a, b, c, d;
+
+    /* Reversing nothing, or the whole tour, doesn't change it. */
+    if(i >= j || (i == 0 && j == n - 1))
+    {
+        return 0;
+    }
+    a = perm[(i + n - 1) % n];
+    b = perm[i];
+    c = perm[j];
+    d = perm[(j + 1) % n];
+    return distance(a, c, param) + distance(b, d, param) - distance(a, b, param) - distance(c, d, param);
+}
@@ -0,0 +1,82 @@
+#ifndef EVO_GENE_PERM_H
+#define EVO_GENE_PERM_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Permutation genes, for ordering problems like routing and scheduling.
+
+    A gene is an array of n evo_uints holding each of 0 to n - 1 exactly once.
+    The crossover operators keep a table of where each value sits, so they take O(n) time
+    instead of searching the parents for every value. They need scratch space for that,
+    which the caller provides (EVO_PERM_SCRATCH(n) evo_uints), so nothing is allocated
+    per call. The children must not be the same arrays as the parents.
+*/
+
+/* Number of evo_uints of scratch space the crossover operators need. */
+#define EVO_PERM_SCRATCH(n) ((n) * 2)
+
+/* Fills a permutation with a random order of 0 to n - 1. */
+void evo_Perm_Randomize(evo_Context* context, evo_uint* perm, evo_uint n);
+
+/*
+    Partially mapped crossover (PMX).
+    Each child takes a random segment from one parent, and everything else from the other,
+    with any values that clash with the segment mapped through it.
+*/
+void evo_Perm_PmxCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch);
+/*
+    Order crossover (OX).
+    Each child takes a random segment from one parent, and fills the rest with the missing values
+    in the order they appear in the other, starting after the segment.
+*/
+void evo_Perm_OxCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch);
+/*
+    Cycle crossover (CX).
+    The positions are split into the cycles that the parents map onto each other,
+    and the children take alternate cycles from each parent, so every value keeps
+    a position it had in one of the parents.
+*/
+void evo_Perm_CycleCrossover(evo_Context* context, evo_uint n,
+    const evo_uint* parentA, const evo_uint* parentB, evo_uint* childA, evo_uint* childB, evo_uint* scratch);
+
+/*
+    Moves, for mutation and local search.
+
+    Each move has a delta function, which works out how much it would change the cost of
+    a permutation read as a closed tour (the last value connects back to the first),
+    by only looking at the edges the move touches. So trying a move is O(1),
+    and only moves worth making need to be applied.
+    The distance between values must be symmetric.
+*/
+typedef double (*evo_PermDistance)(evo_uint a, evo_uint b, void* param);
+
+/* Returns the cost of the closed tour. */
+double evo_Perm_TourCost(const evo_uint* perm, evo_uint n, evo_PermDistance distance, void* param);
+
+/* Swaps the values at positions i and j. */
+void evo_Perm_Swap(evo_uint* perm, evo_uint i, evo_uint j);
+double evo_Perm_SwapDelta(const evo_uint* perm, evo_uint n, evo_uint i, evo_uint j,
+    evo_PermDistance distance, void* param);
+
+/* Takes the value at position "from" out, and puts it back in so that it ends up at position "to". */
+void evo_Perm_Insert(evo_uint* perm, evo_uint from, evo_uint to);
+double evo_Perm_InsertDelta(const evo_uint* perm, evo_uint n, evo_uint from, evo_uint to,
+    evo_PermDistance distance, void* param);
+
+/* Reverses positions i to j inclusive, where i <= j (a 2-opt move). */
+void evo_Perm_TwoOpt(evo_uint* perm, evo_uint i, evo_uint j);
+double evo_Perm_TwoOptDelta(const evo_uint* perm, evo_uint n, evo_uint i, evo_uint j,
+    evo_PermDistance distance, void* param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
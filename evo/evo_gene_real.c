@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "evo_gene_real.h"
+#include "evo_bits.h"
+#include "evo_sample.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define ALIGNMENT 32
+/* Doubles per vector register. Gene vectors are padded to a multiple of this. */
+#define LANES 4
+#define TWO_PI 6.283185307179586
+
+typedef struct
+{
+    evo_uint populationSize;
+    evo_uint dimensions;
+    /* Doubles per gene, including padding. */
+    evo_uint stride;
+    /* Per-dimension bounds, and the standard deviation of the mutation noise. Padded with zeros. */
+    double* lower;
+    double* upper;
+    double* sigma;
+
+    evo_RealCrossover crossover;
+    double alpha;
+    double eta;
+    double mutationRate;
+} RealGeneConfig;
+
+typedef struct
+{
+    RealGeneConfig* geneConfig;
+    /* Scratch space for random numbers, made in bulk before each operator uses them. */
+    double* uniforms;
+    double* normals;
+    evo_uint* picked;
+} RealGeneContext;
+
+static void ContextStart(evo_Context* context, void* data);
+static void ContextEnd(evo_Context* context, void* data);
+static void ConfigFinalizer(void* data);
+static evo_bool Initializer(evo_Context* context);
+static void Finalizer(evo_Context* context);
+static void Crossover(evo_Context* context, void* parentA, void* parentB, void* childA, void* childB);
+static void Mutation(evo_Context* context, void* gene);
+
+static void* AlignedMalloc(size_t size)
+{
+    void* p;
+#ifdef _MSC_VER
+    p = _aligned_malloc(size, ALIGNMENT);
+#else
+    if(posix_memalign(&p, ALIGNMENT, size))
+    {
+        p = NULL;
+    }
+#endif
+    return p;
+}
+
+static void AlignedFree(void* p)
+{
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+/* Allocates a zeroed, aligned array of the given number of doubles. */
+static double* NewVector(evo_uint count)
+{
+    double* v = AlignedMalloc(sizeof(double) * count);
+    memset(v, 0, sizeof(double) * count);
+    return v;
+}
+
+void evo_UseRealGenes(evo_Config* config, evo_uint populationSize, const evo_RealSettings* settings)
+{
+    evo_uint i;
+    RealGeneConfig* geneConfig;
+    geneConfig = malloc(sizeof(RealGeneConfig));
+
+    geneConfig->populationSize = populationSize;
+    geneConfig->dimensions = settings->dimensions;
+    geneConfig->stride = (settings->dimensions + LANES - 1) / LANES * LANES;
+    geneConfig->lower = NewVector(geneConfig->stride);
+    geneConfig->upper = NewVector(geneConfig->stride);
+    geneConfig->sigma = NewVector(geneConfig->stride);
+    for(i = 0; i < settings->dimensions; i++)
+    {
+        geneConfig->lower[i] = settings->lower[i];
+        geneConfig->upper[i] = settings->upper[i];
+        geneConfig->sigma[i] = settings->mutationScale * (settings->upper[i] - settings->lower[i]);
+    }
+    geneConfig->crossover = settings->crossover;
+    geneConfig->alpha = settings->alpha;
+    geneConfig->eta = settings->eta;
+    geneConfig->mutationRate = settings->mutationRate;
+
+    evo_Config_AddContextStartCallback(config, ContextStart, geneConfig);
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    evo_Config_SetCrossoverOperator(config, Crossover);
+    evo_Config_SetMutationOperator(config, Mutation);
+    evo_Config_AddContextEndCallback(config, ContextEnd, geneConfig);
+    evo_Config_AddConfigFinalizer(config, ConfigFinalizer, geneConfig);
+}
+
+static void ConfigFinalizer(void* data)
+{
+    RealGeneConfig* geneConfig = data;
+    AlignedFree(geneConfig->lower);
+    AlignedFree(geneConfig->upper);
+    AlignedFree(geneConfig->sigma);
+    free(geneConfig);
+}
+
+static void ContextStart(evo_Context* context, void* data)
+{
+    RealGeneContext* geneContext;
+    RealGeneConfig* geneConfig = data;
+
+    geneContext = malloc(sizeof(RealGeneContext));
+    geneContext->geneConfig = geneConfig;
+    geneContext->uniforms = NewVector(geneConfig->stride * 2);
+    /* Normals come in pairs, but the stride is even anyway. */
+    geneContext->normals = NewVector(geneConfig->stride);
+    geneContext->picked = malloc(sizeof(evo_uint) * geneConfig->stride);
+
+    context->geneUserData = geneContext;
+}
+
+static void ContextEnd(evo_Context* context, void* data)
+{
+    RealGeneContext* geneContext = context->geneUserData;
+
+    AlignedFree(geneContext->uniforms);
+    AlignedFree(geneContext->normals);
+    free(geneContext->picked);
+    free(geneContext);
+}
+
+/* Fills an array with uniform random numbers in [0, 1), with 53 random bits each. */
+static void FillUniforms(evo_WordStream* stream, double* out, evo_uint count)
+{
+    evo_uint i;
+    for(i = 0; i < count; i++)
+    {
+        out[i] = (double) (evo_WordStream_Next(stream) >> 11) * (1.0 / 9007199254740992.0);
+    }
+}
+
+/*
+    Fills an array with standard normal random numbers.
+    Box-Muller makes them in pairs from pairs of uniforms, so count is rounded up to even.
+*/
+static void FillNormals(evo_WordStream* stream, double* out, evo_uint count)
+{
+    evo_uint i;
+    double u, v, r;
+    for(i = 0; i < count; i += 2)
+    {
+        /* u is in (0, 1], so the log is finite. */
+        u = (double) ((evo_WordStream_Next(stream) >> 11) + 1) * (1.0 / 9007199254740992.0);
+        v = (double) (evo_WordStream_Next(stream) >> 11) * (1.0 / 9007199254740992.0);
+        r = sqrt(-2.0 * log(u));
+        out[i] = r * cos(TWO_PI * v);
+        out[i + 1] = r * sin(TWO_PI * v);
+    }
+}
+
+/* Clamps a gene to the bounds. The padding stays zero, since its bounds are zero. */
+static void Clamp(const RealGeneConfig* geneConfig, double* gene)
+{
+    evo_uint i;
+#ifdef __AVX2__
+    for(i = 0; i < geneConfig->stride; i += LANES)
+    {
+        _mm256_store_pd(gene + i, _mm256_min_pd(_mm256_max_pd(_mm256_load_pd(gene + i),
+            _mm256_load_pd(geneConfig->lower + i)), _mm256_load_pd(geneConfig->upper + i)));
+    }
+#else
+    for(i = 0; i < geneConfig->stride; i++)
+    {
+        if(gene[i] < geneConfig->lower[i])
+        {
+            gene[i] = geneConfig->lower[i];
+        }
+        if(gene[i] > geneConfig->upper[i])
+        {
+            gene[i] = geneConfig->upper[i];
+        }
+    }
+#endif
+}
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i, j;
+    double* arena;
+    double* gene;
+    evo_WordStream stream;
+    RealGeneContext* geneContext = context->geneUserData;
+    RealGeneConfig* geneConfig = geneContext->geneConfig;
+
+    if(!context->genes)
+    {
+        /* One block for the whole population. genes[0] is the start of it. */
+        arena = AlignedMalloc(sizeof(double) * geneConfig->stride * geneConfig->populationSize);
+        if(!arena)
+        {
+            return 0;
+        }
+        memset(arena, 0, sizeof(double) * geneConfig->stride * geneConfig->populationSize);
+        context->genes = malloc(sizeof(void*) * geneConfig->populationSize);
+        for(i = 0; i < geneConfig->populationSize; i++)
+        {
+            context->genes[i] = arena + i * geneConfig->stride;
+        }
+    }
+
+    evo_WordStream_Seed(&stream, context);
+    for(i = 0; i < geneConfig->populationSize; i++)
+    {
+        gene = context->genes[i];
+        FillUniforms(&stream, geneContext->uniforms, geneConfig->dimensions);
+        for(j = 0; j < geneConfig->dimensions; j++)
+        {
+            gene[j] = geneConfig->lower[j]
+                + geneContext->uniforms[j] * (geneConfig->upper[j] - geneConfig->lower[j]);
+        }
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    AlignedFree(context->genes[0]);
+    free(context->genes);
+}
+
+/* Blend crossover, with the uniforms for both children already made. */
+static void BlendCrossover(const RealGeneConfig* geneConfig, const double* uniforms,
+    const double* a, const double* b, double* c, double* d)
+{
+    evo_uint i;
+    const double* ua = uniforms;
+    const double* ub = uniforms + geneConfig->stride;
+#ifdef __AVX2__
+    __m256d va, vb, lo, span, start;
+    const __m256d alpha = _mm256_set1_pd(geneConfig->alpha);
+    const __m256d width = _mm256_set1_pd(1.0 + 2.0 * geneConfig->alpha);
+    for(i = 0; i < geneConfig->stride; i += LANES)
+    {
+        va = _mm256_load_pd(a + i);
+        vb = _mm256_load_pd(b + i);
+        lo = _mm256_min_pd(va, vb);
+        span = _mm256_sub_pd(_mm256_max_pd(va, vb), lo);
+        start = _mm256_sub_pd(lo, _mm256_mul_pd(alpha, span));
+        span = _mm256_mul_pd(width, span);
+        _mm256_store_pd(c + i, _mm256_add_pd(start, _mm256_mul_pd(_mm256_load_pd(ua + i), span)));
+        _mm256_store_pd(d + i, _mm256_add_pd(start, _mm256_mul_pd(_mm256_load_pd(ub + i), span)));
+    }
+#else
+    double lo, span, start;
+    for(i = 0; i < geneConfig->stride; i++)
+    {
+        lo = a[i] < b[i] ? a[i] : b[i];
+        span = (a[i] < b[i] ? b[i] : a[i]) - lo;
+        start = lo - geneConfig->alpha * span;
+        span *= 1.0 + 2.0 * geneConfig->alpha;
+        c[i] = start + ua[i] * span;
+        d[i] = start + ub[i] * span;
+    }
+#endif
+}
+
+/* Simulated binary crossover, with a uniform for each dimension already made. */
+static void SbxCrossover(const RealGeneConfig* geneConfig, const double* uniforms,
+    const double* a, const double* b, double* c, double* d)
+{
+    evo_uint i;
+    double u, beta, ca, cb;
+    double exponent = 1.0 / (geneConfig->eta + 1.0);
+    for(i = 0; i < geneConfig->dimensions; i++)
+    {
+        u = uniforms[i];
+        if(u <= 0.5)
+        {
+            beta = pow(2.0 * u, exponent);
+        }
+        else
+        {
+            beta = pow(1.0 / (2.0 * (1.0 - u)), exponent);
+        }
+        ca = 0.5 * ((1.0 + beta) * a[i] + (1.0 - beta) * b[i]);
+        cb = 0.5 * ((1.0 - beta) * a[i] + (1.0 + beta) * b[i]);
+        c[i] = ca;
+        d[i] = cb;
+    }
+}
+
+static void Crossover(evo_Context* context, void* parentA, void* parentB, void* childA, void* childB)
+{
+    evo_WordStream stream;
+    RealGeneContext* geneContext = context->geneUserData;
+    RealGeneConfig* geneConfig = geneContext->geneConfig;
+
+    evo_WordStream_Seed(&stream, context);
+    switch(geneConfig->crossover)
+    {
+        case EVO_REAL_CROSSOVER_BLEND:
+            FillUniforms(&stream, geneContext->uniforms, geneConfig->stride * 2);
+            BlendCrossover(geneConfig, geneContext->uniforms, parentA, parentB, childA, childB);
+            break;
+        case EVO_REAL_CROSSOVER_SBX:
+            FillUniforms(&stream, geneContext->uniforms, geneConfig->dimensions);
+            SbxCrossover(geneConfig, geneContext->uniforms, parentA, parentB, childA, childB);
+            break;
+    }
+    Clamp(geneConfig, childA);
+    Clamp(geneConfig, childB);
+}
+
+static void Mutation(evo_Context* context, void* data)
+{
+    evo_uint i, count;
+    double* gene = data;
+    evo_WordStream stream;
+    evo_LocusSampler sampler;
+    RealGeneContext* geneContext = context->geneUserData;
+    RealGeneConfig* geneConfig = geneContext->geneConfig;
+
+    evo_WordStream_Seed(&stream, context);
+    if(geneConfig->mutationRate >= 1)
+    {
+        /* Every coordinate moves. */
+        FillNormals(&stream, geneContext->normals, geneConfig->dimensions);
+        for(i = 0; i < geneConfig->dimensions; i++)
+        {
+            gene[i] += geneContext->normals[i] * geneConfig->sigma[i];
+        }
+    }
+    else
+    {
+        /* Pick the coordinates first, so only as many normals are made as are needed. */
+        count = 0;
+        evo_LocusSampler_Start(&sampler, context, geneConfig->dimensions, geneConfig->mutationRate);
+        while(evo_LocusSampler_Next(&sampler, &i))
+        {
+            geneContext->picked[count++] = i;
+        }
+        FillNormals(&stream, geneContext->normals, count);
+        for(i = 0; i < count; i++)
+        {
+            gene[geneContext->picked[i]] += geneContext->normals[i] * geneConfig->sigma[geneContext->picked[i]];
+        }
+    }
+    Clamp(geneConfig, gene);
+}
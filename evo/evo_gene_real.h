@@ -0,0 +1,62 @@
+#ifndef EVO_GENE_REAL_H
+#define EVO_GENE_REAL_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Real-valued genes.
+
+    Each gene is a vector of doubles, one per dimension, kept within per-dimension bounds.
+    The genes of a unit are carved out of one contiguous, 32-byte aligned block, with each
+    vector padded to a multiple of 4 doubles, so the operators can work a whole vector register
+    at a time. The padding is always zero.
+
+    Using this sets the population initializer and finalizer, and the crossover and mutation
+    operators. The fitness operator gets each gene as a double*.
+*/
+
+typedef enum
+{
+    /*
+        Blend crossover (BLX-alpha). Each child coordinate is uniform over the range
+        spanned by the parents, widened by alpha times its length on either side.
+    */
+    EVO_REAL_CROSSOVER_BLEND,
+    /*
+        Simulated binary crossover (SBX). The children are spread around the parents
+        like single-point crossover spreads bitstrings. A larger eta keeps them closer.
+    */
+    EVO_REAL_CROSSOVER_SBX
+} evo_RealCrossover;
+
+typedef struct
+{
+    evo_uint dimensions;
+    /* The bounds of each dimension. Copied when the settings are used. */
+    const double* lower;
+    const double* upper;
+
+    evo_RealCrossover crossover;
+    /* Widening for blend crossover. 0.5 is usual. */
+    double alpha;
+    /* Distribution index for SBX. Somewhere from 2 to 20 is usual. */
+    double eta;
+
+    /* Chance that each coordinate of a child gets Gaussian noise added. */
+    double mutationRate;
+    /* Standard deviation of the noise, as a fraction of each dimension's range. */
+    double mutationScale;
+} evo_RealSettings;
+
+/* Uses real-valued genes with the given settings. The settings are copied. */
+void evo_UseRealGenes(evo_Config* config, evo_uint populationSize, const evo_RealSettings* settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/* vsnprintf and clock_gettime aren't declared in strict C89 without this. */
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "evo_log.h"
+#include "evo_fence.h"
+
+#ifdef _WIN32
+#include <sys/timeb.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef _MSC_VER
+/* Visual Studio 2008 only has _vsnprintf, which doesn't terminate a message that gets cut short. */
+#define vsnprintf _vsnprintf
+#endif
+
+/* Records per ring. A power of two, so the counters can wrap around. */
+#define LOG_RING_SIZE 256
+/* Longer messages are cut short. */
+#define LOG_MESSAGE_SIZE 256
+/* How long the drain thread waits when it finds every ring empty, unless it's woken to stop. */
+#define LOG_DRAIN_MILLISECONDS 10
+
+typedef struct
+{
+    evo_LogLevel level;
+    char message[LOG_MESSAGE_SIZE];
+} LogRecord;
+
+/*
+    A ring that one unit's thread writes and the drain thread reads.
+    The counters only go up, and each is written by one side only.
+*/
+typedef struct
+{
+    /* Records written, and dropped, by the unit's thread. */
+    volatile evo_uint head;
+    evo_uint dropped;
+    /* Keeps the two sides' counters off each other's cache line. */
+    char padding[56];
+    /* Records drained by the drain thread. */
+    volatile evo_uint tail;
+    LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+struct evo_Log
+{
+    LogRing* rings;
+    evo_uint ringCount;
+    evo_LogSink sink;
+    void* param;
+    pthread_t thread;
+    /* Guards stopping, so the drain thread can't miss the wake up from evo_Log_Stop. */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    volatile evo_bool stopping;
+};
+
+/* Waits for LOG_DRAIN_MILLISECONDS, or until evo_Log_Stop wakes the drain thread. */
+static void _evo_Log_Wait(evo_Log* log)
+{
+    struct timespec deadline;
+#ifdef _WIN32
+    struct _timeb now;
+#endif
+
+#ifdef _WIN32
+    _ftime(&now);
+    deadline.tv_sec = (long) now.time;
+    deadline.tv_nsec = now.millitm * 1000000L;
+#else
+    clock_gettime(CLOCK_REALTIME, &deadline);
+#endif
+    deadline.tv_nsec += LOG_DRAIN_MILLISECONDS * 1000000L;
+    if(deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    if(!log->stopping)
+    {
+        pthread_cond_timedwait(&log->wake, &log->lock, &deadline);
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+/* Passes every record written so far to the sink. Returns whether there were any. */
+static evo_bool _evo_Log_Drain(evo_Log* log)
+{
+    evo_uint i, head;
+    evo_bool drained = EVO_FALSE;
+    LogRing* ring;
+    const LogRecord* record;
+
+    for(i = 0; i < log->ringCount; i++)
+    {
+        ring = &log->rings[i];
+        head = ring->head;
+        /* The records up to head are all there, once head has been read. */
+        EVO_FENCE();
+        while(ring->tail != head)
+        {
+            record = &ring->records[ring->tail % LOG_RING_SIZE];
+            log->sink(record->level, i, record->message, log->param);
+            /* Done with the record, before the unit can reuse its space. */
+            EVO_FENCE();
+            ring->tail++;
+            drained = EVO_TRUE;
+        }
+    }
+    return drained;
+}
+
+static void* _evo_Log_Run(void* arg)
+{
+    evo_Log* log = (evo_Log*) arg;
+    evo_bool stopping;
+
+    do
+    {
+        /* Read before draining, so the last pass gets everything written before the stop. */
+        stopping = log->stopping;
+        EVO_FENCE();
+        if(!_evo_Log_Drain(log) && !stopping)
+        {
+            _evo_Log_Wait(log);
+        }
+    } while(!stopping);
+    return NULL;
+}
+
+evo_Log* evo_Log_Start(evo_uint unitCount, evo_LogSink sink, void* param)
+{
+    evo_Log* log = calloc(1, sizeof(evo_Log));
+
+    log->rings = calloc(unitCount, sizeof(LogRing));
+    log->ringCount = unitCount;
+    log->sink = sink;
+    log->param = param;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    if(pthread_create(&log->thread, NULL, _evo_Log_Run, log))
+    {
+        pthread_cond_destroy(&log->wake);
+        pthread_mutex_destroy(&log->lock);
+        free(log->rings);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+void evo_Log_Write(evo_Log* log, evo_uint unit, evo_LogLevel level, const char* format, va_list args)
+{
+    LogRing* ring = &log->rings[unit];
+    LogRecord* record;
+
+    if(ring->head - ring->tail == LOG_RING_SIZE)
+    {
+        ring->dropped++;
+        return;
+    }
+    /* The drain thread is done with the space, once tail says so. */
+    EVO_FENCE();
+    record = &ring->records[ring->head % LOG_RING_SIZE];
+    record->level = level;
+    vsnprintf(record->message, LOG_MESSAGE_SIZE - 1, format, args);
+    record->message[LOG_MESSAGE_SIZE - 1] = 0;
+    /* The record has to be all there before the drain thread can see it. */
+    EVO_FENCE();
+    ring->head++;
+}
+
+void evo_Log_Stop(evo_Log* log)
+{
+    evo_uint i;
+    char message[64];
+
+    pthread_mutex_lock(&log->lock);
+    log->stopping = EVO_TRUE;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+    pthread_cond_destroy(&log->wake);
+    pthread_mutex_destroy(&log->lock);
+    for(i = 0; i < log->ringCount; i++)
+    {
+        if(log->rings[i].dropped)
+        {
+            sprintf(message, "Unit %u dropped %u log records.", i, log->rings[i].dropped);
+            log->sink(EVO_LOG_WARNING, i, message, log->param);
+        }
+    }
+    free(log->rings);
+    free(log);
+}
+
+void evo_Log_Send(evo_LogSink sink, void* param, evo_LogLevel level, const char* format, va_list args)
+{
+    char message[LOG_MESSAGE_SIZE];
+
+    vsnprintf(message, LOG_MESSAGE_SIZE - 1, format, args);
+    message[LOG_MESSAGE_SIZE - 1] = 0;
+    sink(level, EVO_LOG_NO_UNIT, message, param);
+}
+
+void evo_Log_Print(evo_LogLevel level, evo_uint unit, const char* message, void* param)
+{
+    fprintf((level <= EVO_LOG_WARNING) ? stderr : stdout, "%s\n", message);
+}
@@ -0,0 +1,44 @@
+#ifndef EVO_LOG_H
+#define EVO_LOG_H
+
+#include <stdarg.h>
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Log rings, for evo_Context_Log.
+
+    Every unit gets a ring of records, which only its thread writes to, and one background
+    thread drains them all into the sink. So a unit's thread only formats its message into
+    the ring, and never waits on a lock or on the sink. A unit that gets a whole ring ahead of
+    the drain thread drops records rather than wait, and the drops are reported at the end.
+
+    Records from the same unit reach the sink in order, but records from different units
+    can be interleaved any way.
+*/
+typedef struct evo_Log evo_Log;
+
+/* Creates a ring for each unit, and starts the drain thread. Returns NULL if the thread couldn't be started. */
+evo_Log* evo_Log_Start(evo_uint unitCount, evo_LogSink sink, void* param);
+/* Adds a record to a unit's ring. Only the unit's thread may call this. */
+void evo_Log_Write(evo_Log* log, evo_uint unit, evo_LogLevel level, const char* format, va_list args);
+/*
+    Stops the drain thread once it has drained every ring, reports any dropped records, and frees the rings.
+    The units' threads must have finished.
+*/
+void evo_Log_Stop(evo_Log* log);
+
+/* Formats a record and passes it straight to the sink, as a record of the configuration's own. */
+void evo_Log_Send(evo_LogSink sink, void* param, evo_LogLevel level, const char* format, va_list args);
+
+/* The sink used when none is set. Errors and warnings go to stderr, and the rest to stdout. */
+void evo_Log_Print(evo_LogLevel level, evo_uint unit, const char* message, void* param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
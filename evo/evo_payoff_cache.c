@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "evo_payoff_cache.h"
+#include "evo_fence.h"
+
+/* Number of independently locked segments, picked by the top bits of a hash. */
+#define SEGMENT_BITS 6
+#define SEGMENT_COUNT (1 << (SEGMENT_BITS))
+/* Segments are only filled up to this fraction, so probe chains stay short. */
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
+
+typedef struct
+{
+    /* The pair of IDs, ordered so that a <= b. A zero a marks an empty entry. */
+    evo_uint64 a, b;
+    double payoffA, payoffB;
+} CacheEntry;
+
+/*
+    Writers take the lock, and bump the sequence counter before and after changing entries.
+    Readers don't lock: they retry if the counter was odd, or changed while they looked.
+*/
+typedef struct
+{
+    pthread_mutex_t lock;
+    volatile evo_uint sequence;
+    CacheEntry* entries;
+    evo_uint count;
+} CacheSegment;
+
+struct evo_PayoffCache
+{
+    /* Entries per segment. A power of two. */
+    evo_uint segmentCapacity;
+    CacheSegment segments[SEGMENT_COUNT];
+};
+
+evo_PayoffCache* evo_PayoffCache_New(evo_uint capacity)
+{
+    evo_uint i;
+    evo_PayoffCache* cache = calloc(1, sizeof(evo_PayoffCache));
+
+    cache->segmentCapacity = 16;
+    while(cache->segmentCapacity * SEGMENT_COUNT < capacity)
+    {
+        cache->segmentCapacity *= 2;
+    }
+    for(i = 0; i < SEGMENT_COUNT; i++)
+    {
+        pthread_mutex_init(&cache->segments[i].lock, NULL);
+        cache->segments[i].entries = calloc(cache->segmentCapacity, sizeof(CacheEntry));
+    }
+    return cache;
+}
+
+void evo_PayoffCache_Free(evo_PayoffCache* cache)
+{
+    evo_uint i;
+    for(i = 0; i < SEGMENT_COUNT; i++)
+    {
+        pthread_mutex_destroy(&cache->segments[i].lock);
+        free(cache->segments[i].entries);
+    }
+    free(cache);
+}
+
+/* Mixes a pair of IDs into a hash (the splitmix64 finalizer). */
+static evo_uint64 Hash(evo_uint64 a, evo_uint64 b)
+{
+    evo_uint64 z = a * 0x9E3779B97F4A7C15ULL + b;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+evo_bool evo_PayoffCache_Find(evo_PayoffCache* cache, evo_uint64 a, evo_uint64 b, double* payoffA, double* payoffB)
+{
+    evo_uint64 h, t;
+    evo_uint i, start, sequence;
+    evo_bool found, swapped;
+    double foundA, foundB;
+    CacheSegment* segment;
+    volatile CacheEntry* entry;
+
+    /* Games are stored one way around. */
+    swapped = a > b;
+    if(swapped)
+    {
+        t = a;
+        a = b;
+        b = t;
+    }
+
+    h = Hash(a, b);
+    segment = &cache->segments[h >> (64 - SEGMENT_BITS)];
+    start = (evo_uint) h & (cache->segmentCapacity - 1);
+
+    do
+    {
+        sequence = segment->sequence;
+        EVO_FENCE();
+        found = EVO_FALSE;
+        foundA = foundB = 0;
+        for(i = start; ; i = (i + 1) & (cache->segmentCapacity - 1))
+        {
+            entry = &segment->entries[i];
+            if(!entry->a)
+            {
+                break;
+            }
+            if(entry->a == a && entry->b == b)
+            {
+                foundA = entry->payoffA;
+                foundB = entry->payoffB;
+                found = EVO_TRUE;
+                break;
+            }
+        }
+        EVO_FENCE();
+    } while((sequence & 1) || sequence != segment->sequence);
+
+    if(found)
+    {
+        *payoffA = swapped ? foundB : foundA;
+        *payoffB = swapped ? foundA : foundB;
+    }
+    return found;
+}
+
+void evo_PayoffCache_Insert(evo_PayoffCache* cache, evo_uint64 a, evo_uint64 b, double payoffA, double payoffB)
+{
+    evo_uint64 h, t;
+    evo_uint i;
+    double p;
+    CacheSegment* segment;
+    CacheEntry* entry;
+
+    if(a > b)
+    {
+        t = a;
+        a = b;
+        b = t;
+        p = payoffA;
+        payoffA = payoffB;
+        payoffB = p;
+    }
+
+    h = Hash(a, b);
+    segment = &cache->segments[h >> (64 - SEGMENT_BITS)];
+    i = (evo_uint) h & (cache->segmentCapacity - 1);
+
+    pthread_mutex_lock(&segment->lock);
+    if(segment->count * MAX_LOAD_DENOMINATOR < cache->segmentCapacity * MAX_LOAD_NUMERATOR)
+    {
+        for(;;)
+        {
+            entry = &segment->entries[i];
+            /* Another unit may have just played the same game. */
+            if(entry->a == a && entry->b == b)
+            {
+                break;
+            }
+            if(!entry->a)
+            {
+                segment->sequence++;
+                EVO_FENCE();
+                entry->a = a;
+                entry->b = b;
+                entry->payoffA = payoffA;
+                entry->payoffB = payoffB;
+                EVO_FENCE();
+                segment->sequence++;
+                segment->count++;
+                break;
+            }
+            i = (i + 1) & (cache->segmentCapacity - 1);
+        }
+    }
+    pthread_mutex_unlock(&segment->lock);
+}
@@ -0,0 +1,40 @@
+#ifndef EVO_PAYOFF_CACHE_H
+#define EVO_PAYOFF_CACHE_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A payoff cache for competitive fitness.
+
+    Populations often hold many genes that behave identically. If the problem can give each gene
+    an ID that is equal exactly when two genes behave the same (e.g. a canonical form),
+    the result of a game can be remembered by the pair of IDs, and replaying it is a lookup.
+
+    One cache can be shared by every unit. It is split into segments: inserts lock their segment,
+    while lookups don't lock at all, and instead retry if an insert into the segment overlapped them.
+    Once a segment fills up, new results for it are simply not remembered.
+    IDs must not be zero.
+*/
+typedef struct evo_PayoffCache evo_PayoffCache;
+
+/* Creates a cache with room for about the given number of games. */
+evo_PayoffCache* evo_PayoffCache_New(evo_uint capacity);
+void evo_PayoffCache_Free(evo_PayoffCache* cache);
+
+/*
+    Looks up the payoffs of the game where gene a plays gene b.
+    Returns true and fills in both payoffs if the game was remembered.
+*/
+evo_bool evo_PayoffCache_Find(evo_PayoffCache* cache, evo_uint64 a, evo_uint64 b, double* payoffA, double* payoffB);
+/* Remembers the payoffs of the game where gene a plays gene b. */
+void evo_PayoffCache_Insert(evo_PayoffCache* cache, evo_uint64 a, evo_uint64 b, double payoffA, double payoffB);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
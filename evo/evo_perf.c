@@ -0,0 +1,145 @@
+/* syscall() isn't declared in strict C89 without this. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "evo_perf.h"
+
+const char* evo_PerfCounterName(evo_PerfCounter counter)
+{
+    static const char* names[EVO_COUNTER_COUNT] = {
+        "cycles", "instructions", "cache misses", "branch misses"
+    };
+    return (counter < EVO_COUNTER_COUNT) ? names[counter] : "unknown";
+}
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+struct evo_PerfGroup
+{
+    /* The group leader, which the whole group is read through. */
+    int leader;
+    /* One per counter, or -1 if it couldn't be opened. */
+    int fds[EVO_COUNTER_COUNT];
+    /* Where each counter comes in a read of the group, or -1. */
+    int slots[EVO_COUNTER_COUNT];
+    int count;
+};
+
+static const evo_uint64 _evo_perfEvents[EVO_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int _evo_PerfOpen(evo_uint64 event, int leader)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    /* The leader starts stopped, so the group can be started all at once. */
+    attr.disabled = (leader == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    /* This thread, on any CPU. */
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+evo_PerfGroup* evo_PerfGroup_Open(void)
+{
+    int i, fd;
+    evo_PerfGroup* group;
+
+    group = malloc(sizeof(evo_PerfGroup));
+    group->leader = -1;
+    group->count = 0;
+    for(i = 0; i < EVO_COUNTER_COUNT; i++)
+    {
+        fd = _evo_PerfOpen(_evo_perfEvents[i], group->leader);
+        group->fds[i] = fd;
+        group->slots[i] = -1;
+        if(fd >= 0)
+        {
+            if(group->leader == -1)
+            {
+                group->leader = fd;
+            }
+            group->slots[i] = group->count++;
+        }
+    }
+    if(group->leader == -1)
+    {
+        free(group);
+        return NULL;
+    }
+    ioctl(group->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return group;
+}
+
+evo_bool evo_PerfGroup_Read(evo_PerfGroup* group, double* values)
+{
+    int i;
+    /* The number of counters, then each counter's value. */
+    evo_uint64 buffer[1 + EVO_COUNTER_COUNT];
+
+    if(read(group->leader, buffer, sizeof(buffer)) < (long) sizeof(evo_uint64)
+        || buffer[0] != (evo_uint64) group->count)
+    {
+        return EVO_FALSE;
+    }
+    for(i = 0; i < EVO_COUNTER_COUNT; i++)
+    {
+        values[i] = (group->slots[i] >= 0) ? (double) buffer[1 + group->slots[i]] : 0;
+    }
+    return EVO_TRUE;
+}
+
+void evo_PerfGroup_Close(evo_PerfGroup* group)
+{
+    int i;
+
+    if(!group)
+    {
+        return;
+    }
+    ioctl(group->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    /* The leader goes last, after the rest of its group. */
+    for(i = EVO_COUNTER_COUNT - 1; i >= 0; i--)
+    {
+        if(group->fds[i] >= 0)
+        {
+            close(group->fds[i]);
+        }
+    }
+    free(group);
+}
+
+#else
+
+/* No perf events here, so there's never a group to read. */
+evo_PerfGroup* evo_PerfGroup_Open(void)
+{
+    return NULL;
+}
+
+evo_bool evo_PerfGroup_Read(evo_PerfGroup* group, double* values)
+{
+    return EVO_FALSE;
+}
+
+void evo_PerfGroup_Close(evo_PerfGroup* group)
+{
+}
+
+#endif
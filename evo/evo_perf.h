@@ -0,0 +1,38 @@
+#ifndef EVO_PERF_H
+#define EVO_PERF_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Hardware performance counters, for the calling thread.
+
+    On Linux these are opened with perf_event_open, as one group, so they're all read at once
+    and count over the same stretch of time. Only user-space events are counted, which is
+    allowed at the default perf_event_paranoid setting. Everywhere else, or when perf events
+    aren't allowed, or the CPU's counters aren't exposed (as in many virtual machines),
+    opening the group fails, and the caller carries on without counters.
+
+    The library uses these for EVO_USE_PERF_COUNTERS. Each read is a system call,
+    so they cost about a microsecond per phase.
+*/
+/* Opens and starts the counters for the calling thread. Returns NULL if none of them could be opened. */
+evo_PerfGroup* evo_PerfGroup_Open(void);
+/*
+    Reads the counters' totals so far into values, which has EVO_COUNTER_COUNT entries.
+    Counters the CPU doesn't have read as zero. Returns false if the read failed.
+*/
+evo_bool evo_PerfGroup_Read(evo_PerfGroup* group, double* values);
+void evo_PerfGroup_Close(evo_PerfGroup* group);
+
+/* Returns the name of a counter, for reports. */
+const char* evo_PerfCounterName(evo_PerfCounter counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
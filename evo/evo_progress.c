@@ -0,0 +1,292 @@
+/* shm_open, ftruncate and mmap are POSIX, and not declared in strict C89 without this. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "evo_progress.h"
+#include "evo_fence.h"
+
+/* How many times a reader tries for a consistent copy of a slot, before giving up on it for now. */
+#define MAX_READ_TRIES 1000
+
+struct evo_Progress
+{
+    evo_ProgressHeader* header;
+    evo_ProgressUnit* units;
+    size_t size;
+    /* The platform's name for the page. */
+    char* path;
+    /* Whether this is the page's creator, which removes it when it's closed. */
+    evo_bool owner;
+#ifdef _WIN32
+    void* mapping;
+#endif
+};
+
+#ifdef _WIN32
+#include <windows.h>
+
+#define PROGRESS_PATH_PREFIX "Local\\evo-"
+
+static void* _evo_Progress_CreatePage(evo_Progress* progress)
+{
+    void* page;
+
+    progress->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        0, (DWORD) progress->size, progress->path);
+    if(!progress->mapping)
+    {
+        return NULL;
+    }
+    /*
+        A viewer still holding an older page keeps it alive, and this gets that one back.
+        It's used again if it's big enough.
+    */
+    page = MapViewOfFile(progress->mapping, FILE_MAP_WRITE, 0, 0, progress->size);
+    if(!page)
+    {
+        CloseHandle(progress->mapping);
+        return NULL;
+    }
+    memset(page, 0, progress->size);
+    return page;
+}
+
+static void* _evo_Progress_OpenPage(evo_Progress* progress)
+{
+    void* page;
+    MEMORY_BASIC_INFORMATION info;
+
+    progress->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, progress->path);
+    if(!progress->mapping)
+    {
+        return NULL;
+    }
+    page = MapViewOfFile(progress->mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!page || !VirtualQuery(page, &info, sizeof(info)))
+    {
+        if(page)
+        {
+            UnmapViewOfFile(page);
+        }
+        CloseHandle(progress->mapping);
+        return NULL;
+    }
+    progress->size = info.RegionSize;
+    return page;
+}
+
+/* The page goes away by itself once nothing has it open. */
+static void _evo_Progress_ClosePage(evo_Progress* progress)
+{
+    UnmapViewOfFile(progress->header);
+    CloseHandle(progress->mapping);
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PROGRESS_PATH_PREFIX "/evo-"
+
+/*
+    An older page with the same name is removed first, rather than reused,
+    so a viewer still watching it keeps what it had.
+*/
+static void* _evo_Progress_CreatePage(evo_Progress* progress)
+{
+    int fd;
+    void* page;
+
+    shm_unlink(progress->path);
+    fd = shm_open(progress->path, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    if(ftruncate(fd, (off_t) progress->size))
+    {
+        close(fd);
+        shm_unlink(progress->path);
+        return NULL;
+    }
+    page = mmap(NULL, progress->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(page == MAP_FAILED)
+    {
+        shm_unlink(progress->path);
+        return NULL;
+    }
+    return page;
+}
+
+static void* _evo_Progress_OpenPage(evo_Progress* progress)
+{
+    int fd;
+    void* page;
+    struct stat info;
+
+    fd = shm_open(progress->path, O_RDONLY, 0);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    if(fstat(fd, &info) || info.st_size < (off_t) sizeof(evo_ProgressHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    progress->size = (size_t) info.st_size;
+    page = mmap(NULL, progress->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (page == MAP_FAILED) ? NULL : page;
+}
+
+static void _evo_Progress_ClosePage(evo_Progress* progress)
+{
+    munmap(progress->header, progress->size);
+    if(progress->owner)
+    {
+        shm_unlink(progress->path);
+    }
+}
+
+#endif
+
+static evo_Progress* _evo_Progress_New(const char* name)
+{
+    evo_Progress* progress = calloc(1, sizeof(evo_Progress));
+    progress->path = malloc(strlen(PROGRESS_PATH_PREFIX) + strlen(name) + 1);
+    sprintf(progress->path, "%s%s", PROGRESS_PATH_PREFIX, name);
+    return progress;
+}
+
+static void _evo_Progress_Free(evo_Progress* progress)
+{
+    free(progress->path);
+    free(progress);
+}
+
+evo_Progress* evo_Progress_Create(const char* name, const evo_ProgressHeader* header)
+{
+    evo_Progress* progress = _evo_Progress_New(name);
+
+    progress->owner = EVO_TRUE;
+    progress->size = sizeof(evo_ProgressHeader) + header->unitCount * sizeof(evo_ProgressUnit);
+    progress->header = _evo_Progress_CreatePage(progress);
+    if(!progress->header)
+    {
+        _evo_Progress_Free(progress);
+        return NULL;
+    }
+    progress->units = (evo_ProgressUnit*) (progress->header + 1);
+    memcpy(progress->header, header, sizeof(evo_ProgressHeader));
+    progress->header->magic = 0;
+    progress->header->version = EVO_PROGRESS_VERSION;
+    progress->header->finished = 0;
+    /* The magic goes in last, so readers don't take the page until the rest of the header is there. */
+    EVO_FENCE();
+    progress->header->magic = EVO_PROGRESS_MAGIC;
+    return progress;
+}
+
+void evo_Progress_Update(evo_Progress* progress, evo_uint unit, evo_uint trials, evo_uint iteration,
+    double bestFitness, double evaluations)
+{
+    evo_ProgressUnit* slot = &progress->units[unit];
+
+    slot->sequence++;
+    EVO_FENCE();
+    slot->trials = trials;
+    slot->iteration = iteration;
+    if(bestFitness > slot->bestFitness)
+    {
+        slot->bestFitness = bestFitness;
+    }
+    slot->evaluations = evaluations;
+    EVO_FENCE();
+    slot->sequence++;
+}
+
+void evo_Progress_UnitDone(evo_Progress* progress, evo_uint unit)
+{
+    evo_ProgressUnit* slot = &progress->units[unit];
+
+    slot->sequence++;
+    EVO_FENCE();
+    slot->done = EVO_TRUE;
+    EVO_FENCE();
+    slot->sequence++;
+}
+
+void evo_Progress_Finish(evo_Progress* progress)
+{
+    EVO_FENCE();
+    progress->header->finished = EVO_TRUE;
+}
+
+evo_Progress* evo_Progress_Open(const char* name)
+{
+    evo_Progress* progress = _evo_Progress_New(name);
+    evo_ProgressHeader* header;
+
+    header = _evo_Progress_OpenPage(progress);
+    if(!header)
+    {
+        _evo_Progress_Free(progress);
+        return NULL;
+    }
+    progress->header = header;
+    progress->units = (evo_ProgressUnit*) (header + 1);
+    EVO_FENCE();
+    if(header->magic != EVO_PROGRESS_MAGIC
+        || header->version != EVO_PROGRESS_VERSION
+        || progress->size < sizeof(evo_ProgressHeader) + header->unitCount * sizeof(evo_ProgressUnit))
+    {
+        evo_Progress_Close(progress);
+        return NULL;
+    }
+    return progress;
+}
+
+const evo_ProgressHeader* evo_Progress_GetHeader(const evo_Progress* progress)
+{
+    return progress->header;
+}
+
+evo_bool evo_Progress_Read(const evo_Progress* progress, evo_uint unit, evo_ProgressUnit* values)
+{
+    const evo_ProgressUnit* slot = &progress->units[unit];
+    evo_uint sequence, tries;
+
+    for(tries = 0; tries < MAX_READ_TRIES; tries++)
+    {
+        sequence = slot->sequence;
+        EVO_FENCE();
+        if(sequence & 1)
+        {
+            continue;
+        }
+        memcpy(values, (const void*) slot, sizeof(evo_ProgressUnit));
+        EVO_FENCE();
+        if(slot->sequence == sequence)
+        {
+            return EVO_TRUE;
+        }
+    }
+    return EVO_FALSE;
+}
+
+void evo_Progress_Close(evo_Progress* progress)
+{
+    if(!progress)
+    {
+        return;
+    }
+    _evo_Progress_ClosePage(progress);
+    _evo_Progress_Free(progress);
+}
@@ -0,0 +1,94 @@
+#ifndef EVO_PROGRESS_H
+#define EVO_PROGRESS_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Progress pages, for evo_Config_SetProgressName.
+
+    A page is a named shared memory object ("/evo-NAME" on POSIX systems, which Linux keeps
+    in /dev/shm, or "Local\evo-NAME" on Windows), so another process can watch a run while
+    it goes. It holds a header, then a slot for each unit.
+
+    Each unit's thread is the only writer of its slot, and guards it with a sequence lock:
+    the slot's sequence is odd while an update is part way through. A reader copies the slot,
+    and keeps the copy if the sequence was even and hadn't changed by the end, or tries again.
+    Writers never wait for readers, so watching a run doesn't slow it down.
+*/
+#define EVO_PROGRESS_MAGIC 0x45564f50
+#define EVO_PROGRESS_VERSION 1
+
+/* 64 bytes, so the slots after it start on a cache line. */
+typedef struct
+{
+    /* EVO_PROGRESS_MAGIC, once the page is ready to read. */
+    evo_uint magic;
+    evo_uint version;
+    evo_uint unitCount;
+    /* Trials each unit runs. */
+    evo_uint trialsPerUnit;
+    evo_uint maxIterations;
+    evo_uint populationSize;
+    /* 0 without lanes. */
+    evo_uint laneCount;
+    /* Set once every unit has finished. */
+    volatile evo_uint finished;
+    /* When the run started, in seconds of evo_WallTime. */
+    double startTime;
+    char padding[24];
+} evo_ProgressHeader;
+
+/* A cache line per unit, so no two units' threads write to the same line. */
+typedef struct
+{
+    /* Odd while the slot is being updated. */
+    volatile evo_uint sequence;
+    /* Trials the unit has finished. */
+    evo_uint trials;
+    /* The iteration of its current trial. With lanes, the furthest any lane has got. */
+    evo_uint iteration;
+    /* Set once the unit has finished. */
+    evo_uint done;
+    /* The best fitness of any generation so far. */
+    double bestFitness;
+    /* Fitness evaluations so far. */
+    double evaluations;
+    char padding[32];
+} evo_ProgressUnit;
+
+typedef struct evo_Progress evo_Progress;
+
+/*
+    Creates a page for a run, replacing any older page with that name,
+    and fills in its header from the given one. Returns NULL if it couldn't be created.
+*/
+evo_Progress* evo_Progress_Create(const char* name, const evo_ProgressHeader* header);
+/* Publishes a unit's progress. bestFitness only replaces the slot's if it's better. */
+void evo_Progress_Update(evo_Progress* progress, evo_uint unit, evo_uint trials, evo_uint iteration,
+    double bestFitness, double evaluations);
+/* Marks a unit as finished. */
+void evo_Progress_UnitDone(evo_Progress* progress, evo_uint unit);
+/* Marks the whole run as finished. */
+void evo_Progress_Finish(evo_Progress* progress);
+
+/* Opens an existing page to read. Returns NULL if there isn't one, or it isn't ready yet. */
+evo_Progress* evo_Progress_Open(const char* name);
+const evo_ProgressHeader* evo_Progress_GetHeader(const evo_Progress* progress);
+/*
+    Copies a unit's slot. Returns false if it couldn't get a consistent copy,
+    which only happens if the writer stopped part way through an update.
+*/
+evo_bool evo_Progress_Read(const evo_Progress* progress, evo_uint unit, evo_ProgressUnit* values);
+
+/* Unmaps the page. When it's the page's creator closing it, the name is removed too. */
+void evo_Progress_Close(evo_Progress* progress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
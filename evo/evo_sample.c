@@ -0,0 +1,55 @@
+#include <math.h>
+#include "evo_sample.h"
+
+/* Returns the number of loci skipped before the next chosen one. */
+static double Skip(evo_LocusSampler* sampler)
+{
+    /* u is in (0, 1], so the log is finite. */
+    double u = (double) ((evo_WordStream_Next(&sampler->stream) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return floor(log(u) * sampler->scale);
+}
+
+void evo_LocusSampler_Start(evo_LocusSampler* sampler, evo_Context* context, evo_uint count, double rate)
+{
+    double skip;
+
+    sampler->count = count;
+    if(rate <= 0)
+    {
+        sampler->next = count;
+        return;
+    }
+    if(rate >= 1)
+    {
+        sampler->scale = 0;
+        sampler->next = 0;
+        return;
+    }
+
+    sampler->scale = 1.0 / log(1.0 - rate);
+    evo_WordStream_Seed(&sampler->stream, context);
+    /* Compare as doubles, since a huge skip won't fit in an evo_uint. */
+    skip = Skip(sampler);
+    sampler->next = skip < count ? (evo_uint) skip : count;
+}
+
+evo_bool evo_LocusSampler_Next(evo_LocusSampler* sampler, evo_uint* locus)
+{
+    double skip;
+
+    if(sampler->next >= sampler->count)
+    {
+        return EVO_FALSE;
+    }
+    *locus = sampler->next;
+    skip = sampler->scale ? Skip(sampler) : 0;
+    if(skip < sampler->count - sampler->next - 1)
+    {
+        sampler->next += (evo_uint) skip + 1;
+    }
+    else
+    {
+        sampler->next = sampler->count;
+    }
+    return EVO_TRUE;
+}
@@ -0,0 +1,48 @@
+#ifndef EVO_SAMPLE_H
+#define EVO_SAMPLE_H
+
+#include "evo_api.h"
+#include "evo_bits.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Visits the loci of a gene that get mutated, when each of them is mutated independently
+    with the same small probability.
+
+    Rather than drawing a random number for every locus, this draws the gap to the next
+    mutated locus straight from the geometric distribution. The result is the same,
+    but the cost is one draw per mutated locus, so a gene of a million loci with a rate
+    of one in a million costs about one draw instead of a million.
+
+    Usage:
+        evo_LocusSampler sampler;
+        evo_uint locus;
+        evo_LocusSampler_Start(&sampler, context, lociCount, rate);
+        while(evo_LocusSampler_Next(&sampler, &locus))
+        {
+            ... mutate the locus ...
+        }
+*/
+typedef struct
+{
+    evo_WordStream stream;
+    evo_uint count;
+    /* The next locus to visit, or count once finished. */
+    evo_uint next;
+    /* 1 / log(1 - rate), or 0 if every locus is visited. */
+    double scale;
+} evo_LocusSampler;
+
+/* Starts visiting loci [0, count), each chosen with the given probability. */
+void evo_LocusSampler_Start(evo_LocusSampler* sampler, evo_Context* context, evo_uint count, double rate);
+/* Writes the next chosen locus, in increasing order. Returns false once there are no more. */
+evo_bool evo_LocusSampler_Next(evo_LocusSampler* sampler, evo_uint* locus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
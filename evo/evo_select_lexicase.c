@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <string.h>
+#include "evo_bits.h"
+#include "evo_select_lexicase.h"
+
+typedef struct
+{
+    evo_uint populationSize;
+    evo_uint caseCount;
+} LexicaseSelectionConfig;
+
+typedef struct
+{
+    LexicaseSelectionConfig* selectionConfig;
+    /* Number of words in a per-gene case bitset, and in a per-case population bitset. */
+    evo_uint caseWords;
+    evo_uint populationWords;
+    /*
+        Case results as written by the fitness operator, gene-major:
+        populationSize rows of caseWords words.
+    */
+    evo_uint64* geneBits;
+    /*
+        The same results transposed once per generation, case-major:
+        caseWords * 64 rows of populationWords words.
+        Filtering a candidate set by one case then reads a single contiguous row.
+    */
+    evo_uint64* caseBits;
+    /* Genes not yet used by a breed event this generation. */
+    evo_uint64* available;
+    /* Scratch sets for filtering. */
+    evo_uint64* candidates;
+    evo_uint64* survivors;
+    /* Case ordering, reshuffled lazily for every parent picked. */
+    evo_uint* order;
+} LexicaseSelectionContext;
+
+static void ContextStart(evo_Context* context, void* data);
+static void ContextEnd(evo_Context* context, void* data);
+static void Selection(evo_Context* context);
+
+void evo_UseLexicaseSelection(evo_Config* config, evo_uint populationSize, evo_uint caseCount)
+{
+    LexicaseSelectionConfig* selectionConfig;
+    selectionConfig = malloc(sizeof(LexicaseSelectionConfig));
+
+    selectionConfig->populationSize = populationSize;
+    selectionConfig->caseCount = caseCount;
+
+    evo_Config_AddContextStartCallback(config, ContextStart, selectionConfig);
+    evo_Config_SetSelectionOperator(config, Selection);
+    evo_Config_AddContextEndCallback(config, ContextEnd, selectionConfig);
+    evo_Config_AddConfigFinalizer(config, free, selectionConfig);
+}
+
+static void ContextStart(evo_Context* context, void* selectionConfig)
+{
+    evo_uint i;
+    LexicaseSelectionContext* selectionContext;
+    LexicaseSelectionConfig* c = selectionConfig;
+
+    selectionContext = malloc(sizeof(LexicaseSelectionContext));
+    selectionContext->selectionConfig = c;
+    selectionContext->caseWords = (c->caseCount + 63) / 64;
+    selectionContext->populationWords = (c->populationSize + 63) / 64;
+    selectionContext->geneBits = calloc(selectionContext->populationWords * 64 * selectionContext->caseWords, sizeof(evo_uint64));
+    selectionContext->caseBits = calloc(selectionContext->caseWords * 64 * selectionContext->populationWords, sizeof(evo_uint64));
+    selectionContext->available = malloc(sizeof(evo_uint64) * selectionContext->populationWords);
+    selectionContext->candidates = malloc(sizeof(evo_uint64) * selectionContext->populationWords);
+    selectionContext->survivors = malloc(sizeof(evo_uint64) * selectionContext->populationWords);
+    selectionContext->order = malloc(sizeof(evo_uint) * c->caseCount);
+    for(i = 0; i < c->caseCount; i++)
+    {
+        selectionContext->order[i] = i;
+    }
+
+    context->selectionUserData = selectionContext;
+}
+
+static void ContextEnd(evo_Context* context, void* selectionConfig)
+{
+    LexicaseSelectionContext* selectionContext = context->selectionUserData;
+
+    free(selectionContext->geneBits);
+    free(selectionContext->caseBits);
+    free(selectionContext->available);
+    free(selectionContext->candidates);
+    free(selectionContext->survivors);
+    free(selectionContext->order);
+    free(selectionContext);
+}
+
+evo_uint64* evo_Lexicase_GetCaseBits(evo_Context* context, evo_uint gene)
+{
+    LexicaseSelectionContext* selectionContext = context->selectionUserData;
+    return selectionContext->geneBits + gene * selectionContext->caseWords;
+}
+
+void evo_Lexicase_SetCase(evo_Context* context, evo_uint gene, evo_uint testCase, evo_bool passed)
+{
+    evo_uint64* bits = evo_Lexicase_GetCaseBits(context, gene);
+    evo_uint64 bit = ((evo_uint64) 1) << (testCase % 64);
+    if(passed)
+    {
+        bits[testCase / 64] |= bit;
+    }
+    else
+    {
+        bits[testCase / 64] &= ~bit;
+    }
+}
+
+/* Removes a gene from a population bitset. */
+static void ClearBit(evo_uint64* bits, evo_uint i)
+{
+    bits[i / 64] &= ~(((evo_uint64) 1) << (i % 64));
+}
+
+/* Transposes a 64x64 bit matrix in place, so that bit c of row r becomes bit r of row c. */
+static void Transpose64(evo_uint64* a)
+{
+    evo_uint j, k;
+    evo_uint64 m, t;
+
+    m = 0x00000000FFFFFFFFULL;
+    for(j = 32; j != 0; j >>= 1, m ^= (m << j))
+    {
+        for(k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+/*
+    Turns the gene-major results into case-major rows, 64x64 bits at a time,
+    and clears the gene-major results for the next generation.
+*/
+static void TransposeCases(LexicaseSelectionContext* selectionContext)
+{
+    evo_uint g, c, r;
+    evo_uint caseWords = selectionContext->caseWords;
+    evo_uint populationWords = selectionContext->populationWords;
+    evo_uint64 block[64];
+
+    for(g = 0; g < populationWords; g++)
+    {
+        for(c = 0; c < caseWords; c++)
+        {
+            for(r = 0; r < 64; r++)
+            {
+                block[r] = selectionContext->geneBits[(g * 64 + r) * caseWords + c];
+            }
+            Transpose64(block);
+            for(r = 0; r < 64; r++)
+            {
+                selectionContext->caseBits[(c * 64 + r) * populationWords + g] = block[r];
+            }
+        }
+    }
+    memset(selectionContext->geneBits, 0, sizeof(evo_uint64) * populationWords * 64 * caseWords);
+}
+
+/*
+    Picks a gene from the available set by lexicase filtering, ignoring the excluded gene.
+    Returns the population size if there is nothing left to pick.
+*/
+static evo_uint PickParent(evo_Context* context, LexicaseSelectionContext* selectionContext, evo_uint exclude)
+{
+    evo_uint i, j, k, w, t;
+    evo_uint first, last;
+    evo_uint count, survivorCount;
+    evo_uint64* row;
+    evo_uint64* swap;
+    evo_uint64* candidates = selectionContext->candidates;
+    evo_uint64* survivors = selectionContext->survivors;
+    evo_uint* order = selectionContext->order;
+    evo_uint caseCount = selectionContext->selectionConfig->caseCount;
+    evo_uint populationSize = selectionContext->selectionConfig->populationSize;
+    evo_uint populationWords = selectionContext->populationWords;
+
+    memcpy(candidates, selectionContext->available, sizeof(evo_uint64) * populationWords);
+    if(exclude < populationSize)
+    {
+        ClearBit(candidates, exclude);
+    }
+    count = evo_PopCountWords(candidates, populationWords);
+    if(!count)
+    {
+        return populationSize;
+    }
+
+    /* Only the words in [first, last) can still hold candidates. */
+    first = 0;
+    last = populationWords;
+    for(k = 0; k < caseCount && count > 1; k++)
+    {
+        /* Grow a random case ordering one step at a time (Fisher-Yates). */
+        j = evo_RandomInt(context, k, caseCount);
+        t = order[k];
+        order[k] = order[j];
+        order[j] = t;
+
+        row = selectionContext->caseBits + order[k] * populationWords;
+        survivorCount = 0;
+        for(w = first; w < last; w++)
+        {
+            survivors[w] = candidates[w] & row[w];
+            survivorCount += evo_PopCount64(survivors[w]);
+        }
+        /* If nobody passes this case, it doesn't discriminate: skip it. */
+        if(survivorCount)
+        {
+            swap = candidates;
+            candidates = survivors;
+            survivors = swap;
+            count = survivorCount;
+
+            while(!candidates[first])
+            {
+                first++;
+            }
+            while(!candidates[last - 1])
+            {
+                last--;
+            }
+        }
+    }
+
+    i = evo_NthSetBit(candidates + first, last - first, evo_RandomInt(context, 0, count));
+    return first * 64 + i;
+}
+
+/* Picks a uniformly random available gene, not equal to any of the excluded genes. */
+static evo_uint PickAvailable(evo_Context* context, LexicaseSelectionContext* selectionContext,
+    evo_uint excludeA, evo_uint excludeB, evo_uint excludeC)
+{
+    evo_uint count;
+    evo_uint64* candidates = selectionContext->candidates;
+    evo_uint populationSize = selectionContext->selectionConfig->populationSize;
+    evo_uint populationWords = selectionContext->populationWords;
+
+    memcpy(candidates, selectionContext->available, sizeof(evo_uint64) * populationWords);
+    if(excludeA < populationSize)
+    {
+        ClearBit(candidates, excludeA);
+    }
+    if(excludeB < populationSize)
+    {
+        ClearBit(candidates, excludeB);
+    }
+    if(excludeC < populationSize)
+    {
+        ClearBit(candidates, excludeC);
+    }
+    count = evo_PopCountWords(candidates, populationWords);
+    if(!count)
+    {
+        return populationSize;
+    }
+    return evo_NthSetBit(candidates, populationWords, evo_RandomInt(context, 0, count));
+}
+
+/* Picks a child to replace: the less fit of two random available genes. */
+static evo_uint PickChild(evo_Context* context, LexicaseSelectionContext* selectionContext,
+    evo_uint parentA, evo_uint parentB, evo_uint otherChild)
+{
+    evo_uint a, b;
+    evo_uint populationSize = selectionContext->selectionConfig->populationSize;
+
+    a = PickAvailable(context, selectionContext, parentA, parentB, otherChild);
+    if(a == populationSize)
+    {
+        return a;
+    }
+    b = PickAvailable(context, selectionContext, parentA, parentB, otherChild);
+    return (context->fitnesses[b] < context->fitnesses[a]) ? b : a;
+}
+
+static void Selection(evo_Context* context)
+{
+    evo_uint i, k;
+    evo_uint parents[2], children[2];
+    evo_uint populationSize, populationWords;
+    LexicaseSelectionContext* selectionContext;
+
+    selectionContext = context->selectionUserData;
+    populationSize = selectionContext->selectionConfig->populationSize;
+    populationWords = selectionContext->populationWords;
+
+    TransposeCases(selectionContext);
+
+    /* Every gene starts out available. */
+    memset(selectionContext->available, 0xFF, sizeof(evo_uint64) * populationWords);
+    if(populationSize % 64)
+    {
+        selectionContext->available[populationWords - 1] = (((evo_uint64) 1) << (populationSize % 64)) - 1;
+    }
+
+    for(k = 0; k < populationSize / 4; k++)
+    {
+        parents[0] = PickParent(context, selectionContext, populationSize);
+        parents[1] = PickParent(context, selectionContext, parents[0]);
+        children[0] = PickChild(context, selectionContext, parents[0], parents[1], populationSize);
+        children[1] = PickChild(context, selectionContext, parents[0], parents[1], children[0]);
+        if(parents[1] == populationSize || children[1] == populationSize)
+        {
+            break;
+        }
+
+        if(evo_Context_AddBreedEvent(context, parents[0], parents[1], children[0], children[1]))
+        {
+            for(i = 0; i < 2; i++)
+            {
+                ClearBit(selectionContext->available, parents[i]);
+                ClearBit(selectionContext->available, children[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef EVO_SELECT_LEXICASE_H
+#define EVO_SELECT_LEXICASE_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Lexicase selection.
+
+    Rather than a single number, each gene is judged on a list of test cases.
+    Parents are picked by walking the cases in a random order, and keeping only the genes
+    that pass each case, until one gene is left (or the cases run out, in which case
+    a random survivor is picked). A case that nobody left passes is skipped.
+
+    The fitness operator must record the cases each gene passed, with evo_Lexicase_SetCase.
+    It should still fill in the scalar fitness too: that is used by success predicates,
+    and to choose which genes get replaced by the children.
+*/
+void evo_UseLexicaseSelection(evo_Config* config, evo_uint populationSize, evo_uint caseCount);
+
+/*
+    Records whether a gene passed a test case in the current generation.
+    Cases that are never set during a generation count as failed.
+*/
+void evo_Lexicase_SetCase(evo_Context* context, evo_uint gene, evo_uint testCase, evo_bool passed);
+
+/*
+    Returns the pass bitset for a gene, one bit per case, 64 cases per word.
+    Bit (c % 64) of word (c / 64) is set when case c was passed.
+    Can be used to write many cases at once, instead of calling evo_Lexicase_SetCase.
+*/
+evo_uint64* evo_Lexicase_GetCaseBits(evo_Context* context, evo_uint gene);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,14 @@
 
 #include "evo_api.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void evo_UseRouletteSelection(evo_Config* config, evo_uint populationSize);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -3,6 +3,14 @@
 
 #include "evo_api.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void evo_UseTournamentSelection(evo_Config* config, evo_uint populationSize,  evo_uint tournamentSize);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
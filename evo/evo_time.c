@@ -0,0 +1,57 @@
+/* clock_gettime is POSIX, and not declared in strict C89 without this. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include "evo_time.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+double evo_WallTime(void)
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+}
+
+/* FILETIMEs count in 100 nanosecond ticks. */
+double evo_ThreadCpuTime(void)
+{
+    FILETIME creation, exit, kernel, user;
+    ULARGE_INTEGER k, u;
+    if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double) (k.QuadPart + u.QuadPart) * 1e-7;
+}
+
+#else
+#include <time.h>
+
+static double _evo_ClockSeconds(clockid_t clock)
+{
+    struct timespec t;
+    if(clock_gettime(clock, &t))
+    {
+        return 0;
+    }
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+double evo_WallTime(void)
+{
+    return _evo_ClockSeconds(CLOCK_MONOTONIC);
+}
+
+double evo_ThreadCpuTime(void)
+{
+    return _evo_ClockSeconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef EVO_TIME_H
+#define EVO_TIME_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Clocks for timing runs.
+
+    clock() can't be used for this, since on most platforms it adds up the CPU time of every
+    thread in the process, and on Windows it's wall time. These say which one they mean.
+    Both are in seconds, from an arbitrary starting point, so only differences are meaningful.
+*/
+/* Monotonic wall time. Isn't affected by changes to the system clock. */
+double evo_WallTime(void);
+/* CPU time used by the calling thread alone. */
+double evo_ThreadCpuTime(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
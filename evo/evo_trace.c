@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "evo_trace.h"
+
+/* A buffer stops growing here (about 80MB of spans), so a long run can't use up all the memory. */
+#define MAX_TRACE_EVENTS (1 << 21)
+
+typedef struct
+{
+    const char* name;
+    double start;
+    double end;
+    const char* argName;
+    evo_uint arg;
+} TraceEvent;
+
+struct evo_TraceBuffer
+{
+    evo_uint track;
+    char* name;
+    TraceEvent* events;
+    evo_uint count;
+    evo_uint capacity;
+    /* Spans that didn't fit. */
+    evo_uint dropped;
+};
+
+evo_TraceBuffer* evo_TraceBuffer_New(evo_uint track, const char* name)
+{
+    evo_TraceBuffer* buffer = calloc(1, sizeof(evo_TraceBuffer));
+    buffer->track = track;
+    buffer->name = malloc(strlen(name) + 1);
+    strcpy(buffer->name, name);
+    return buffer;
+}
+
+void evo_TraceBuffer_Free(evo_TraceBuffer* buffer)
+{
+    if(!buffer)
+    {
+        return;
+    }
+    free(buffer->events);
+    free(buffer->name);
+    free(buffer);
+}
+
+void evo_TraceBuffer_Add(evo_TraceBuffer* buffer, const char* name, double start, double end,
+    const char* argName, evo_uint arg)
+{
+    TraceEvent* events;
+    TraceEvent* e;
+
+    if(buffer->count == buffer->capacity)
+    {
+        events = NULL;
+        if(buffer->capacity < MAX_TRACE_EVENTS)
+        {
+            events = realloc(buffer->events, (buffer->capacity ? buffer->capacity * 2 : 1024) * sizeof(TraceEvent));
+        }
+        if(!events)
+        {
+            buffer->dropped++;
+            return;
+        }
+        buffer->events = events;
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+    }
+    e = &buffer->events[buffer->count++];
+    e->name = name;
+    e->start = start;
+    e->end = end;
+    e->argName = argName;
+    e->arg = arg;
+}
+
+evo_bool evo_Trace_Write(const char* filename, evo_TraceBuffer** buffers, evo_uint count, double origin)
+{
+    FILE* f;
+    evo_uint i, j;
+    const TraceEvent* e;
+    const char* separator = "";
+
+    f = fopen(filename, "w");
+    if(!f)
+    {
+        return EVO_FALSE;
+    }
+    /* Complete ("X") events, in microseconds. Each track is a thread of the one process. */
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for(i = 0; i < count; i++)
+    {
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}},\n",
+            separator, buffers[i]->track, buffers[i]->name);
+        fprintf(f, "{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"sort_index\": %u}}",
+            buffers[i]->track, buffers[i]->track);
+        separator = ",\n";
+        if(buffers[i]->dropped)
+        {
+            fprintf(f, ",\n{\"name\": \"dropped\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"spans\": %u}}",
+                buffers[i]->track, buffers[i]->dropped);
+        }
+        for(j = 0; j < buffers[i]->count; j++)
+        {
+            e = &buffers[i]->events[j];
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                e->name, buffers[i]->track, (e->start - origin) * 1e6, (e->end - e->start) * 1e6);
+            if(e->argName)
+            {
+                fprintf(f, ", \"args\": {\"%s\": %u}", e->argName, e->arg);
+            }
+            fprintf(f, "}");
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
@@ -0,0 +1,38 @@
+#ifndef EVO_TRACE_H
+#define EVO_TRACE_H
+
+#include "evo_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Trace buffers, for evo_Config_SetTraceFile.
+
+    Each track of the timeline (a unit, or a lane of one) gets a buffer of its own, which only
+    its unit's thread writes to, so recording takes no locks. The buffers are written out
+    together as Chrome trace-event JSON once every thread has finished, which can be opened
+    with chrome://tracing or https://ui.perfetto.dev.
+
+    Events are spans, given by their start and end in seconds of evo_WallTime.
+    Names (and argument names) must be string constants, since only the pointers are kept.
+*/
+/* A buffer for the track with the given id and name. The name is copied. */
+evo_TraceBuffer* evo_TraceBuffer_New(evo_uint track, const char* name);
+void evo_TraceBuffer_Free(evo_TraceBuffer* buffer);
+/*
+    Records a span. argName can be NULL, for a span without an argument.
+    A buffer that's full drops the span, and counts it instead.
+*/
+void evo_TraceBuffer_Add(evo_TraceBuffer* buffer, const char* name, double start, double end,
+    const char* argName, evo_uint arg);
+
+/* Writes every buffer to a file, with times from origin. Returns false if the file couldn't be written. */
+evo_bool evo_Trace_Write(const char* filename, evo_TraceBuffer** buffers, evo_uint count, double origin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef EVO_PROBLEM_H
+#define EVO_PROBLEM_H
+
+#include "evo_api.h"
+#include "evo_bits.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Standard benchmark problems.
+
+    Each evo_Use* call in this library sets up a whole problem on a config: the population
+    initializer and finalizer, and the fitness, crossover and mutation operators, along with
+    a success predicate that ends a trial once the optimum is found. The caller still sets
+    the attributes (units, trials, population size, and so on) and the selection operator.
+
+    Fitnesses are to be maximized. Problems that are naturally minimized, or that have
+    no natural maximum, are scaled so that the optimum is known ahead of time.
+
+    Random instances are made from an evo_WordStream started at a seed given with the problem,
+    so the same seed always makes the same instance, however the trials are seeded.
+    Instance data is shared by every unit, and freed along with the config.
+*/
+
+/* A uniform random double in [0, 1), for making instances. */
+EVO_INLINE double evo_Problem_Uniform(evo_WordStream* random)
+{
+    return (double) (evo_WordStream_Next(random) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* A uniform random integer in [0, n), for making instances. */
+EVO_INLINE evo_uint evo_Problem_Below(evo_WordStream* random, evo_uint n)
+{
+    return (evo_uint) ((evo_WordStream_Next(random) >> 32) * n >> 32);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
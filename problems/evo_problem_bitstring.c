@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include "evo_problem_bitstring.h"
+
+static void ContextStart(evo_Context* context, void* data);
+static evo_bool Initializer(evo_Context* context);
+static void Finalizer(evo_Context* context);
+static void Fitness(evo_Context* context);
+static void Crossover(evo_Context* context, void* parentA, void* parentB, void* childA, void* childB);
+static void Mutation(evo_Context* context, void* gene);
+static evo_bool Success(evo_Context* context);
+
+void evo_UseBitstringProblem(evo_Config* config, evo_uint populationSize, const evo_BitstringProblem* problem)
+{
+    evo_BitstringProblem* copy = malloc(sizeof(evo_BitstringProblem));
+    *copy = *problem;
+    if(copy->mutationRate <= 0)
+    {
+        copy->mutationRate = 1.0 / copy->bits;
+    }
+
+    evo_Config_AddContextStartCallback(config, ContextStart, copy);
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    evo_Config_SetFitnessOperator(config, Fitness);
+    evo_Config_SetCrossoverOperator(config, Crossover);
+    evo_Config_SetMutationOperator(config, Mutation);
+    evo_Config_SetSuccessPredicate(config, Success);
+    evo_Config_AddConfigFinalizer(config, free, copy);
+}
+
+static void ContextStart(evo_Context* context, void* data)
+{
+    context->geneUserData = data;
+}
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_BitstringProblem* problem = context->geneUserData;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    if(!context->genes)
+    {
+        context->genes = malloc(sizeof(void*) * populationSize);
+        for(i = 0; i < populationSize; i++)
+        {
+            context->genes[i] = evo_Bitstring_New(problem->bits);
+        }
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Randomize(context, context->genes[i], problem->bits);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    if(!context->genes)
+    {
+        return;
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Free(context->genes[i]);
+    }
+    free(context->genes);
+    context->genes = NULL;
+}
+
+static void Fitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_BitstringProblem* problem = context->geneUserData;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    for(i = 0; i < populationSize; i++)
+    {
+        context->fitnesses[i] = problem->fitness(context->genes[i], problem->param);
+    }
+}
+
+static void Crossover(evo_Context* context, void* parentA, void* parentB, void* childA, void* childB)
+{
+    evo_BitstringProblem* problem = context->geneUserData;
+
+    switch(problem->crossoverPoints)
+    {
+        case 0:
+            evo_Bitstring_UniformCrossover(context, problem->bits, parentA, parentB, childA, childB);
+            break;
+        case 2:
+            evo_Bitstring_TwoPointCrossover(context, problem->bits, parentA, parentB, childA, childB);
+            break;
+        default:
+            evo_Bitstring_NPointCrossover(context, problem->bits, problem->crossoverPoints,
+                parentA, parentB, childA, childB);
+            break;
+    }
+}
+
+static void Mutation(evo_Context* context, void* gene)
+{
+    evo_BitstringProblem* problem = context->geneUserData;
+    evo_Bitstring_FlipMutation(context, gene, problem->bits, problem->mutationRate);
+}
+
+static evo_bool Success(evo_Context* context)
+{
+    evo_BitstringProblem* problem = context->geneUserData;
+    /* Allow for rounding, in problems with fractional fitnesses. */
+    return context->bestFitness >= problem->optimum - 1e-9 * (problem->optimum > 1 ? problem->optimum : 1);
+}
@@ -0,0 +1,40 @@
+#ifndef EVO_PROBLEM_BITSTRING_H
+#define EVO_PROBLEM_BITSTRING_H
+
+#include "evo_problem.h"
+#include "evo_gene_bitstring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A problem over bitstring genes, given by a function that scores one gene.
+    The problems over bitstrings in this library are built on this, and it can be used
+    for new ones too.
+*/
+
+/* Scores one gene. param is the one given with the problem. */
+typedef double (*evo_BitstringFitness)(const evo_uint64* gene, void* param);
+
+typedef struct
+{
+    evo_uint bits;
+    evo_BitstringFitness fitness;
+    void* param;
+    /* The best possible fitness. A trial succeeds once some gene reaches it. */
+    double optimum;
+    /* Cut points for crossover, or 0 for uniform crossover. */
+    evo_uint crossoverPoints;
+    /* Chance that each bit of a child flips. 0 means one over the number of bits. */
+    double mutationRate;
+} evo_BitstringProblem;
+
+/* Uses bitstring genes for the given problem. The problem is copied, but not its param. */
+void evo_UseBitstringProblem(evo_Config* config, evo_uint populationSize, const evo_BitstringProblem* problem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include "evo_problem_knapsack.h"
+#include "evo_problem_bitstring.h"
+
+#define MAX_WEIGHT 100
+#define VALUE_SPREAD 10
+
+typedef struct
+{
+    evo_uint weight;
+    evo_uint value;
+} Item;
+
+typedef struct
+{
+    evo_uint itemCount;
+    evo_uint capacity;
+    Item* items;
+} Knapsack;
+
+/* Sorts by value per weight, best first. */
+static int CompareItems(const void* a, const void* b)
+{
+    const Item* x = a;
+    const Item* y = b;
+    double d = (double) y->value * x->weight - (double) x->value * y->weight;
+    return d < 0 ? -1 : (d > 0 ? 1 : 0);
+}
+
+/* The chosen items are walked a word at a time, skipping straight from one set bit to the next. */
+static double KnapsackFitness(const evo_uint64* gene, void* param)
+{
+    Knapsack* knapsack = param;
+    evo_uint w, i;
+    evo_uint64 word;
+    evo_uint weight = 0;
+    evo_uint value = 0;
+    const Item* item;
+
+    for(w = 0; w * 64 < knapsack->itemCount; w++)
+    {
+        word = gene[w];
+        while(word)
+        {
+            i = w * 64 + evo_CountTrailingZeros64(word);
+            word &= word - 1;
+            item = &knapsack->items[i];
+            if(weight + item->weight <= knapsack->capacity)
+            {
+                weight += item->weight;
+                value += item->value;
+            }
+        }
+    }
+    return value;
+}
+
+/* The best value for each weight limit, one item at a time. */
+static double KnapsackOptimum(const Knapsack* knapsack)
+{
+    evo_uint i, c;
+    evo_uint* best = calloc(knapsack->capacity + 1, sizeof(evo_uint));
+    double optimum;
+    const Item* item;
+
+    for(i = 0; i < knapsack->itemCount; i++)
+    {
+        item = &knapsack->items[i];
+        for(c = knapsack->capacity; c >= item->weight; c--)
+        {
+            if(best[c - item->weight] + item->value > best[c])
+            {
+                best[c] = best[c - item->weight] + item->value;
+            }
+        }
+    }
+    optimum = best[knapsack->capacity];
+    free(best);
+    return optimum;
+}
+
+static void KnapsackFree(void* param)
+{
+    Knapsack* knapsack = param;
+    free(knapsack->items);
+    free(knapsack);
+}
+
+void evo_UseKnapsack(evo_Config* config, evo_uint populationSize, evo_uint items, evo_uint64 seed)
+{
+    evo_WordStream random;
+    evo_uint i;
+    int value;
+    evo_uint totalWeight = 0;
+    evo_BitstringProblem problem;
+    Knapsack* knapsack = malloc(sizeof(Knapsack));
+
+    random.state = seed;
+    knapsack->itemCount = items;
+    knapsack->items = malloc(sizeof(Item) * items);
+    for(i = 0; i < items; i++)
+    {
+        knapsack->items[i].weight = 1 + evo_Problem_Below(&random, MAX_WEIGHT);
+        value = (int) knapsack->items[i].weight - VALUE_SPREAD + (int) evo_Problem_Below(&random, 2 * VALUE_SPREAD + 1);
+        knapsack->items[i].value = value < 1 ? 1 : value;
+        totalWeight += knapsack->items[i].weight;
+    }
+    qsort(knapsack->items, items, sizeof(Item), CompareItems);
+    knapsack->capacity = totalWeight / 2;
+
+    problem.bits = items;
+    problem.fitness = KnapsackFitness;
+    problem.param = knapsack;
+    problem.optimum = KnapsackOptimum(knapsack);
+    problem.crossoverPoints = 0;
+    problem.mutationRate = 0;
+    evo_UseBitstringProblem(config, populationSize, &problem);
+    evo_Config_AddConfigFinalizer(config, KnapsackFree, knapsack);
+}
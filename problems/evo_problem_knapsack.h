@@ -0,0 +1,27 @@
+#ifndef EVO_PROBLEM_KNAPSACK_H
+#define EVO_PROBLEM_KNAPSACK_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    0/1 knapsack. Bit i of a gene says whether to pack item i.
+
+    The items have random weights from 1 to 100, and values within 10 of their weights
+    (which makes them hard to tell apart by value per weight). The capacity is half the
+    total weight. The optimum is found ahead of time, by dynamic programming over the capacity.
+
+    Genes that don't fit are read first-fit: the items are sorted best value per weight first,
+    and packed in that order, skipping any that would go over. So every gene scores as a
+    packing that fits, and a gene that already fits scores its own value.
+*/
+void evo_UseKnapsack(evo_Config* config, evo_uint populationSize, evo_uint items, evo_uint64 seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include "evo_problem_maxsat.h"
+#include "evo_problem_bitstring.h"
+
+typedef struct
+{
+    /* The variable of each literal. */
+    evo_uint variable[3];
+    /* Bit j is set when literal j is negated. */
+    evo_uint negated;
+} Clause;
+
+typedef struct
+{
+    evo_uint clauseCount;
+    Clause* clauses;
+} MaxSat;
+
+static evo_uint Bit(const evo_uint64* gene, evo_uint i)
+{
+    return (evo_uint) (gene[i >> 6] >> (i & 63)) & 1;
+}
+
+/* Each clause reads its three bits into a 3-bit number, and is only unsatisfied when that equals its negation bits. */
+static double MaxSatFitness(const evo_uint64* gene, void* param)
+{
+    MaxSat* sat = param;
+    evo_uint i, values;
+    evo_uint satisfied = 0;
+    const Clause* clause = sat->clauses;
+
+    for(i = 0; i < sat->clauseCount; i++, clause++)
+    {
+        values = Bit(gene, clause->variable[0])
+            | (Bit(gene, clause->variable[1]) << 1)
+            | (Bit(gene, clause->variable[2]) << 2);
+        /* A literal is true when its value differs from its negation bit. */
+        satisfied += (values ^ clause->negated) != 0;
+    }
+    return satisfied;
+}
+
+static void MaxSatFree(void* param)
+{
+    MaxSat* sat = param;
+    free(sat->clauses);
+    free(sat);
+}
+
+void evo_UseMaxSat(evo_Config* config, evo_uint populationSize, evo_uint variables, evo_uint clauses, evo_uint64 seed)
+{
+    evo_WordStream random;
+    evo_uint i, j, values;
+    evo_uint64* hidden;
+    Clause* clause;
+    evo_BitstringProblem problem;
+    MaxSat* sat = malloc(sizeof(MaxSat));
+
+    random.state = seed;
+    hidden = evo_Bitstring_New(variables);
+    for(i = 0; i < variables; i++)
+    {
+        hidden[i >> 6] |= (evo_WordStream_Next(&random) >> 63) << (i & 63);
+    }
+
+    sat->clauseCount = clauses;
+    sat->clauses = malloc(sizeof(Clause) * clauses);
+    for(i = 0; i < clauses; i++)
+    {
+        clause = &sat->clauses[i];
+        do
+        {
+            /* Three different variables. */
+            clause->variable[0] = evo_Problem_Below(&random, variables);
+            do
+            {
+                clause->variable[1] = evo_Problem_Below(&random, variables);
+            } while(clause->variable[1] == clause->variable[0]);
+            do
+            {
+                clause->variable[2] = evo_Problem_Below(&random, variables);
+            } while(clause->variable[2] == clause->variable[0] || clause->variable[2] == clause->variable[1]);
+            clause->negated = evo_Problem_Below(&random, 8);
+
+            values = 0;
+            for(j = 0; j < 3; j++)
+            {
+                values |= Bit(hidden, clause->variable[j]) << j;
+            }
+        } while(values == clause->negated);
+    }
+    evo_Bitstring_Free(hidden);
+
+    problem.bits = variables;
+    problem.fitness = MaxSatFitness;
+    problem.param = sat;
+    problem.optimum = clauses;
+    problem.crossoverPoints = 0;
+    problem.mutationRate = 0;
+    evo_UseBitstringProblem(config, populationSize, &problem);
+    evo_Config_AddConfigFinalizer(config, MaxSatFree, sat);
+}
@@ -0,0 +1,25 @@
+#ifndef EVO_PROBLEM_MAXSAT_H
+#define EVO_PROBLEM_MAXSAT_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Max-SAT on random 3-SAT formulas. Bit i of a gene is the value of variable i,
+    and the fitness is the number of clauses satisfied.
+
+    The formula is made around a hidden assignment: clauses are random, but any that
+    the hidden assignment doesn't satisfy are thrown away and drawn again.
+    So every clause can be satisfied at once, and that is the optimum.
+    Around 4.3 clauses per variable makes the hardest formulas.
+*/
+void evo_UseMaxSat(evo_Config* config, evo_uint populationSize, evo_uint variables, evo_uint clauses, evo_uint64 seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
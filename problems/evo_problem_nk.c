@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <float.h>
+#include "evo_problem_nk.h"
+#include "evo_problem_bitstring.h"
+
+/* The most dynamic programming steps to spend finding the optimum. */
+#define MAX_OPTIMUM_STEPS 1000000000.0
+
+typedef struct
+{
+    evo_uint n;
+    evo_uint k;
+    /*
+        The contributions, one row of 2^(k + 1) per locus, rows in locus order.
+        A locus's neighbourhood is read as a number, with the locus itself as the lowest bit.
+        Floats keep the tables half the size, so more of them stay in cache.
+    */
+    float* table;
+} Nk;
+
+static evo_uint Bit(const evo_uint64* gene, evo_uint i)
+{
+    return (evo_uint) (gene[i >> 6] >> (i & 63)) & 1;
+}
+
+/*
+    The neighbourhood of each locus is the one before it shifted down a bit, with one new bit
+    on top, so each locus costs a single bit fetch and a lookup. The rows are visited in order,
+    which keeps the walk through the tables sequential.
+*/
+static double NkFitness(const evo_uint64* gene, void* param)
+{
+    Nk* nk = param;
+    evo_uint i, j, window;
+    evo_uint n = nk->n;
+    evo_uint k = nk->k;
+    evo_uint rowSize = 1 << (k + 1);
+    const float* row = nk->table;
+    double sum = 0;
+
+    window = 0;
+    for(j = 0; j < k; j++)
+    {
+        window |= Bit(gene, j % n) << j;
+    }
+    for(i = 0; i < n; i++)
+    {
+        j = i + k < n ? i + k : i + k - n;
+        window |= Bit(gene, j) << k;
+        sum += row[window];
+        window >>= 1;
+        row += rowSize;
+    }
+    return sum / n;
+}
+
+/*
+    Finds the best total contribution. For each setting of the first k bits, the rest are
+    chosen one at a time, keeping the best total for each setting of the last k bits chosen.
+    Once all are chosen, the loci whose neighbourhoods wrap around can be added up.
+*/
+static double NkOptimum(const Nk* nk)
+{
+    evo_uint start, state, window, b, j, t;
+    evo_uint n = nk->n;
+    evo_uint k = nk->k;
+    evo_uint states = 1 << k;
+    evo_uint rowSize = 1 << (k + 1);
+    double* best = malloc(sizeof(double) * states);
+    double* next = malloc(sizeof(double) * states);
+    double* swap;
+    double value, optimum = -DBL_MAX;
+
+    for(start = 0; start < states; start++)
+    {
+        for(state = 0; state < states; state++)
+        {
+            best[state] = -DBL_MAX;
+        }
+        best[start] = 0;
+        /* The state holds the last k bits chosen, the oldest lowest. */
+        for(j = k; j < n; j++)
+        {
+            for(state = 0; state < states; state++)
+            {
+                next[state] = -DBL_MAX;
+            }
+            for(state = 0; state < states; state++)
+            {
+                if(best[state] == -DBL_MAX)
+                {
+                    continue;
+                }
+                for(b = 0; b < 2; b++)
+                {
+                    window = state | (b << k);
+                    value = best[state] + nk->table[(j - k) * rowSize + window];
+                    if(value > next[window >> 1])
+                    {
+                        next[window >> 1] = value;
+                    }
+                }
+            }
+            swap = best;
+            best = next;
+            next = swap;
+        }
+        for(state = 0; state < states; state++)
+        {
+            if(best[state] == -DBL_MAX)
+            {
+                continue;
+            }
+            value = best[state];
+            for(t = 0; t < k; t++)
+            {
+                window = (state >> t) | ((start & ((2 << t) - 1)) << (k - t));
+                value += nk->table[(n - k + t) * rowSize + window];
+            }
+            if(value > optimum)
+            {
+                optimum = value;
+            }
+        }
+    }
+    free(best);
+    free(next);
+    return optimum / n;
+}
+
+static void NkFree(void* param)
+{
+    Nk* nk = param;
+    free(nk->table);
+    free(nk);
+}
+
+void evo_UseNkLandscape(evo_Config* config, evo_uint populationSize, evo_uint n, evo_uint k, evo_uint64 seed)
+{
+    evo_WordStream random;
+    evo_uint i, count;
+    evo_BitstringProblem problem;
+    Nk* nk = malloc(sizeof(Nk));
+
+    random.state = seed;
+    nk->n = n;
+    nk->k = k;
+    count = n << (k + 1);
+    nk->table = malloc(sizeof(float) * count);
+    for(i = 0; i < count; i++)
+    {
+        nk->table[i] = (float) evo_Problem_Uniform(&random);
+    }
+
+    problem.bits = n;
+    problem.fitness = NkFitness;
+    problem.param = nk;
+    if(n >= 2 * k + 1 && (double) n * (1 << k) * (1 << k) <= MAX_OPTIMUM_STEPS)
+    {
+        problem.optimum = NkOptimum(nk);
+    }
+    else
+    {
+        problem.optimum = DBL_MAX;
+    }
+    /* Neighbourhoods are runs of adjacent loci, which two-point crossover keeps together. */
+    problem.crossoverPoints = 2;
+    problem.mutationRate = 0;
+    evo_UseBitstringProblem(config, populationSize, &problem);
+    evo_Config_AddConfigFinalizer(config, NkFree, nk);
+}
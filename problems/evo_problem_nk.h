@@ -0,0 +1,26 @@
+#ifndef EVO_PROBLEM_NK_H
+#define EVO_PROBLEM_NK_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    NK landscapes. Each of the n loci adds a random contribution from [0, 1), looked up from
+    its own value and the values of the k loci after it (wrapping around the end).
+    The fitness is the mean contribution. A larger k makes the landscape more rugged.
+
+    The optimum is found ahead of time by dynamic programming around the ring, which takes
+    time proportional to n * 4^k. If that would be more than about a billion steps
+    (or n < 2k + 1), the optimum isn't known, and every trial runs to the iteration limit.
+    k must be at most 16.
+*/
+void evo_UseNkLandscape(evo_Config* config, evo_uint populationSize, evo_uint n, evo_uint k, evo_uint64 seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include "evo_problem_onemax.h"
+#include "evo_problem_bitstring.h"
+
+typedef struct
+{
+    evo_uint bits;
+    evo_uint trapSize;
+} Trap;
+
+static double OneMaxFitness(const evo_uint64* gene, void* param)
+{
+    return evo_Bitstring_PopCount(gene, *(evo_uint*) param);
+}
+
+void evo_UseOneMax(evo_Config* config, evo_uint populationSize, evo_uint bits, evo_uint crossoverPoints)
+{
+    evo_BitstringProblem problem;
+    evo_uint* size = malloc(sizeof(evo_uint));
+    *size = bits;
+
+    problem.bits = bits;
+    problem.fitness = OneMaxFitness;
+    problem.param = size;
+    problem.optimum = bits;
+    problem.crossoverPoints = crossoverPoints;
+    problem.mutationRate = 0;
+    evo_UseBitstringProblem(config, populationSize, &problem);
+    evo_Config_AddConfigFinalizer(config, free, size);
+}
+
+/*
+    Each block's bits are pulled out of the words with a shift or two and counted at once,
+    rather than bit by bit. A block that crosses a word boundary takes the rest from the next word.
+*/
+static double TrapFitness(const evo_uint64* gene, void* param)
+{
+    Trap* trap = param;
+    evo_uint i, u, shift;
+    evo_uint64 block;
+    evo_uint64 mask = (((evo_uint64) 1) << trap->trapSize) - 1;
+    double fitness = 0;
+
+    for(i = 0; i < trap->bits; i += trap->trapSize)
+    {
+        shift = i & 63;
+        block = gene[i >> 6] >> shift;
+        if(shift + trap->trapSize > 64)
+        {
+            block |= gene[(i >> 6) + 1] << (64 - shift);
+        }
+        u = evo_PopCount64(block & mask);
+        fitness += u == trap->trapSize ? trap->trapSize : trap->trapSize - 1 - u;
+    }
+    return fitness;
+}
+
+void evo_UseTrap(evo_Config* config, evo_uint populationSize, evo_uint bits, evo_uint trapSize)
+{
+    evo_BitstringProblem problem;
+    Trap* trap = malloc(sizeof(Trap));
+    trap->bits = bits;
+    trap->trapSize = trapSize;
+
+    problem.bits = bits;
+    problem.fitness = TrapFitness;
+    problem.param = trap;
+    problem.optimum = bits;
+    /* Two cut points rarely split a block, while uniform crossover splits nearly all of them. */
+    problem.crossoverPoints = 2;
+    problem.mutationRate = 0;
+    evo_UseBitstringProblem(config, populationSize, &problem);
+    evo_Config_AddConfigFinalizer(config, free, trap);
+}
@@ -0,0 +1,30 @@
+#ifndef EVO_PROBLEM_ONEMAX_H
+#define EVO_PROBLEM_ONEMAX_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    OneMax: the fitness is the number of set bits. The optimum is all ones.
+    The cheapest fitness there is, so it shows off the engine's own costs.
+    crossoverPoints is the number of cut points for crossover, or 0 for uniform crossover.
+*/
+void evo_UseOneMax(evo_Config* config, evo_uint populationSize, evo_uint bits, evo_uint crossoverPoints);
+
+/*
+    Concatenated deceptive traps. The gene is cut into blocks of trapSize bits, each scored
+    on its number of ones u: trapSize if all are set, and trapSize - 1 - u otherwise.
+    Inside a block, every step but the last leads away from the optimum of all ones,
+    so only crossover that keeps blocks together can solve it.
+    bits must be a multiple of trapSize, which must be from 2 to 32.
+*/
+void evo_UseTrap(evo_Config* config, evo_uint populationSize, evo_uint bits, evo_uint trapSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <math.h>
+#include "evo_problem_real.h"
+#include "evo_gene_real.h"
+
+#define TWO_PI 6.283185307179586
+
+typedef struct
+{
+    evo_uint dimensions;
+    /* The least fitness that counts as solved. */
+    double target;
+} RealProblem;
+
+static void ContextStart(evo_Context* context, void* data)
+{
+    context->fitnessUserData = data;
+}
+
+static evo_bool Success(evo_Context* context)
+{
+    RealProblem* problem = context->fitnessUserData;
+    return context->bestFitness >= problem->target;
+}
+
+/* The cosines are the cost here, and the loop has no dependencies between dimensions, so it vectorizes where the compiler can. */
+static void RastriginFitness(evo_Context* context)
+{
+    evo_uint i, j;
+    RealProblem* problem = context->fitnessUserData;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    const double* x;
+    double f;
+
+    for(i = 0; i < populationSize; i++)
+    {
+        x = context->genes[i];
+        f = 10.0 * problem->dimensions;
+        for(j = 0; j < problem->dimensions; j++)
+        {
+            f += x[j] * x[j] - 10.0 * cos(TWO_PI * x[j]);
+        }
+        context->fitnesses[i] = 1 / (1 + f);
+    }
+}
+
+static void RosenbrockFitness(evo_Context* context)
+{
+    evo_uint i, j;
+    RealProblem* problem = context->fitnessUserData;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    const double* x;
+    double f, a, b;
+
+    for(i = 0; i < populationSize; i++)
+    {
+        x = context->genes[i];
+        f = 0;
+        for(j = 0; j + 1 < problem->dimensions; j++)
+        {
+            a = x[j + 1] - x[j] * x[j];
+            b = 1 - x[j];
+            f += 100 * a * a + b * b;
+        }
+        context->fitnesses[i] = 1 / (1 + f);
+    }
+}
+
+static void UseRealProblem(evo_Config* config, evo_uint populationSize, evo_uint dimensions, double tolerance,
+    double bound, evo_FitnessOperator fitness)
+{
+    evo_uint i;
+    evo_RealSettings settings;
+    double* lower = malloc(sizeof(double) * dimensions);
+    double* upper = malloc(sizeof(double) * dimensions);
+    RealProblem* problem = malloc(sizeof(RealProblem));
+
+    for(i = 0; i < dimensions; i++)
+    {
+        lower[i] = -bound;
+        upper[i] = bound;
+    }
+    settings.dimensions = dimensions;
+    settings.lower = lower;
+    settings.upper = upper;
+    settings.crossover = EVO_REAL_CROSSOVER_SBX;
+    settings.alpha = 0.5;
+    settings.eta = 15;
+    settings.mutationRate = 1.0 / dimensions;
+    settings.mutationScale = 0.05;
+    evo_UseRealGenes(config, populationSize, &settings);
+    /* The settings were copied. */
+    free(lower);
+    free(upper);
+
+    problem->dimensions = dimensions;
+    problem->target = 1 / (1 + tolerance);
+    evo_Config_AddContextStartCallback(config, ContextStart, problem);
+    evo_Config_SetFitnessOperator(config, fitness);
+    evo_Config_SetSuccessPredicate(config, Success);
+    evo_Config_AddConfigFinalizer(config, free, problem);
+}
+
+void evo_UseRastrigin(evo_Config* config, evo_uint populationSize, evo_uint dimensions, double tolerance)
+{
+    UseRealProblem(config, populationSize, dimensions, tolerance, 5.12, RastriginFitness);
+}
+
+void evo_UseRosenbrock(evo_Config* config, evo_uint populationSize, evo_uint dimensions, double tolerance)
+{
+    UseRealProblem(config, populationSize, dimensions, tolerance, 2.048, RosenbrockFitness);
+}
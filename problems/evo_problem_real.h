@@ -0,0 +1,32 @@
+#ifndef EVO_PROBLEM_REAL_H
+#define EVO_PROBLEM_REAL_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Continuous test functions, over real-valued genes (see evo_gene_real.h).
+    Both are minimized, with a minimum of 0, so the fitness is 1 / (1 + f(x)).
+    A trial succeeds once some gene gets f(x) down to the given tolerance.
+*/
+
+/*
+    Rastrigin: f(x) = 10d + sum(x^2 - 10 cos(2 pi x)), over [-5.12, 5.12] in each dimension.
+    A regular grid of local minima, around the global one at the origin.
+*/
+void evo_UseRastrigin(evo_Config* config, evo_uint populationSize, evo_uint dimensions, double tolerance);
+
+/*
+    Rosenbrock: f(x) = sum(100 (x[i + 1] - x[i]^2)^2 + (1 - x[i])^2), over [-2.048, 2.048].
+    The minimum at (1, 1, ...) lies at the bottom of a long, curved, nearly flat valley.
+*/
+void evo_UseRosenbrock(evo_Config* config, evo_uint populationSize, evo_uint dimensions, double tolerance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <math.h>
+#include "evo_problem_tsp.h"
+#include "evo_gene_perm.h"
+
+#define PI 3.14159265358979323846
+
+typedef struct
+{
+    evo_uint cityCount;
+    evo_uint localSearchMoves;
+    evo_TspCrossover crossover;
+    /* Every distance, row-major. */
+    double* distances;
+    double shortestTour;
+} Tsp;
+
+typedef struct
+{
+    Tsp* tsp;
+    /* Scratch space for crossover. */
+    evo_uint* scratch;
+} TspContext;
+
+static double Distance(evo_uint a, evo_uint b, void* param)
+{
+    Tsp* tsp = param;
+    return tsp->distances[a * tsp->cityCount + b];
+}
+
+static void ContextStart(evo_Context* context, void* data)
+{
+    Tsp* tsp = data;
+    TspContext* tspContext = malloc(sizeof(TspContext));
+    tspContext->tsp = tsp;
+    tspContext->scratch = malloc(sizeof(evo_uint) * EVO_PERM_SCRATCH(tsp->cityCount));
+    context->geneUserData = tspContext;
+}
+
+static void ContextEnd(evo_Context* context, void* data)
+{
+    TspContext* tspContext = context->geneUserData;
+    free(tspContext->scratch);
+    free(tspContext);
+}
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    Tsp* tsp = ((TspContext*) context->geneUserData)->tsp;
+    evo_TspTour* tour;
+
+    if(!context->genes)
+    {
+        context->genes = malloc(sizeof(void*) * populationSize);
+        for(i = 0; i < populationSize; i++)
+        {
+            /* The cities are stored right after the tour. */
+            tour = malloc(sizeof(evo_TspTour) + sizeof(evo_uint) * tsp->cityCount);
+            tour->cities = (evo_uint*) (tour + 1);
+            context->genes[i] = tour;
+        }
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        tour = context->genes[i];
+        evo_Perm_Randomize(context, tour->cities, tsp->cityCount);
+        tour->length = evo_Perm_TourCost(tour->cities, tsp->cityCount, Distance, tsp);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    if(!context->genes)
+    {
+        return;
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        free(context->genes[i]);
+    }
+    free(context->genes);
+    context->genes = NULL;
+}
+
+/* The lengths are already known, so this is just a division per gene. */
+static void Fitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    Tsp* tsp = ((TspContext*) context->geneUserData)->tsp;
+
+    for(i = 0; i < populationSize; i++)
+    {
+        context->fitnesses[i] = tsp->shortestTour / ((evo_TspTour*) context->genes[i])->length;
+    }
+}
+
+static void Crossover(evo_Context* context, void* parentA, void* parentB, void* childA, void* childB)
+{
+    TspContext* tspContext = context->geneUserData;
+    Tsp* tsp = tspContext->tsp;
+    evo_uint* pa = ((evo_TspTour*) parentA)->cities;
+    evo_uint* pb = ((evo_TspTour*) parentB)->cities;
+    evo_TspTour* ca = childA;
+    evo_TspTour* cb = childB;
+
+    switch(tsp->crossover)
+    {
+        case EVO_TSP_PMX:
+            evo_Perm_PmxCrossover(context, tsp->cityCount, pa, pb, ca->cities, cb->cities, tspContext->scratch);
+            break;
+        case EVO_TSP_OX:
+            evo_Perm_OxCrossover(context, tsp->cityCount, pa, pb, ca->cities, cb->cities, tspContext->scratch);
+            break;
+        case EVO_TSP_CX:
+            evo_Perm_CycleCrossover(context, tsp->cityCount, pa, pb, ca->cities, cb->cities, tspContext->scratch);
+            break;
+    }
+    ca->length = evo_Perm_TourCost(ca->cities, tsp->cityCount, Distance, tsp);
+    cb->length = evo_Perm_TourCost(cb->cities, tsp->cityCount, Distance, tsp);
+}
+
+/* Picks two random positions i < j. */
+static void RandomPair(evo_Context* context, evo_uint n, evo_uint* i, evo_uint* j)
+{
+    evo_uint a = evo_RandomInt(context, 0, n);
+    evo_uint b = evo_RandomInt(context, 0, n - 1);
+    b += (b >= a);
+    *i = a < b ? a : b;
+    *j = a < b ? b : a;
+}
+
+static void Mutation(evo_Context* context, void* gene)
+{
+    evo_uint i, j;
+    evo_TspTour* tour = gene;
+    Tsp* tsp = ((TspContext*) context->geneUserData)->tsp;
+
+    RandomPair(context, tsp->cityCount, &i, &j);
+    tour->length += evo_Perm_TwoOptDelta(tour->cities, tsp->cityCount, i, j, Distance, tsp);
+    evo_Perm_TwoOpt(tour->cities, i, j);
+}
+
+static void LocalSearch(evo_Context* context, Tsp* tsp, evo_TspTour* tour)
+{
+    evo_uint i, j, k;
+    double delta;
+
+    for(k = 0; k < tsp->localSearchMoves; k++)
+    {
+        RandomPair(context, tsp->cityCount, &i, &j);
+        delta = evo_Perm_TwoOptDelta(tour->cities, tsp->cityCount, i, j, Distance, tsp);
+        if(delta < 0)
+        {
+            tour->length += delta;
+            evo_Perm_TwoOpt(tour->cities, i, j);
+        }
+    }
+}
+
+static void LocalSearchStage(evo_Context* context, evo_uint event, void* param)
+{
+    LocalSearch(context, param, context->genes[context->breedEvents[event + 2]]);
+    LocalSearch(context, param, context->genes[context->breedEvents[event + 3]]);
+}
+
+static evo_bool Success(evo_Context* context)
+{
+    /* Allow for rounding in the lengths. */
+    return context->bestFitness >= 1 - 1e-9;
+}
+
+static void TspFree(void* param)
+{
+    Tsp* tsp = param;
+    free(tsp->distances);
+    free(tsp);
+}
+
+void evo_UseTsp(evo_Config* config, evo_uint populationSize, evo_uint cities, evo_uint localSearchMoves,
+    evo_TspCrossover crossover, evo_uint64 seed)
+{
+    evo_WordStream random;
+    evo_uint i, j, t;
+    evo_uint* order;
+    double* x;
+    double* y;
+    Tsp* tsp = malloc(sizeof(Tsp));
+
+    random.state = seed;
+    tsp->cityCount = cities;
+    tsp->localSearchMoves = localSearchMoves;
+    tsp->crossover = crossover;
+
+    order = malloc(sizeof(evo_uint) * cities);
+    x = malloc(sizeof(double) * cities);
+    y = malloc(sizeof(double) * cities);
+    for(i = 0; i < cities; i++)
+    {
+        order[i] = i;
+    }
+    for(i = cities; i > 1; i--)
+    {
+        j = evo_Problem_Below(&random, i);
+        t = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = t;
+    }
+    for(i = 0; i < cities; i++)
+    {
+        x[order[i]] = cos(2 * PI * i / cities);
+        y[order[i]] = sin(2 * PI * i / cities);
+    }
+    tsp->distances = malloc(sizeof(double) * cities * cities);
+    for(i = 0; i < cities; i++)
+    {
+        for(j = 0; j < cities; j++)
+        {
+            tsp->distances[i * cities + j] = sqrt((x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]));
+        }
+    }
+    tsp->shortestTour = 2 * cities * sin(PI / cities);
+    free(order);
+    free(x);
+    free(y);
+
+    evo_Config_AddContextStartCallback(config, ContextStart, tsp);
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    evo_Config_SetFitnessOperator(config, Fitness);
+    evo_Config_SetCrossoverOperator(config, Crossover);
+    evo_Config_SetMutationOperator(config, Mutation);
+    evo_Config_SetSuccessPredicate(config, Success);
+    if(localSearchMoves)
+    {
+        evo_Config_AddStage(config, EVO_PHASE_BRED, EVO_STAGE_PER_EVENT, LocalSearchStage, tsp);
+    }
+    evo_Config_AddContextEndCallback(config, ContextEnd, tsp);
+    evo_Config_AddConfigFinalizer(config, TspFree, tsp);
+}
@@ -0,0 +1,44 @@
+#ifndef EVO_PROBLEM_TSP_H
+#define EVO_PROBLEM_TSP_H
+
+#include "evo_problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    The travelling salesman problem, over permutation genes (see evo_gene_perm.h).
+
+    The cities sit evenly around a circle, numbered in a random order, so the shortest tour
+    is known (the polygon's perimeter) without being the obvious one. The fitness is the
+    shortest length over the gene's length, so the optimum is 1.
+
+    Genes are tours that keep their length up to date through each move. Crossover is one of
+    the permutation crossovers below, mutation is one random 2-opt move, and a stage after
+    breeding tries a few more 2-opt moves on each child, keeping the ones that help.
+    Genes can be read as evo_TspTour*.
+*/
+typedef struct
+{
+    double length;
+    evo_uint* cities;
+} evo_TspTour;
+
+/* The crossovers from evo_gene_perm.h that a tour can be bred with. */
+typedef enum
+{
+    EVO_TSP_PMX,
+    EVO_TSP_OX,
+    EVO_TSP_CX
+} evo_TspCrossover;
+
+/* localSearchMoves is the number of 2-opt moves tried on each child. */
+void evo_UseTsp(evo_Config* config, evo_uint populationSize, evo_uint cities, evo_uint localSearchMoves,
+    evo_TspCrossover crossover, evo_uint64 seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#include <evo_time.h>
+#include "tests.h"
+
+/*
+    Things shared by the test runner and evo-bench: the list of tests,
+    and the timer the tests use to measure their runs.
+*/
+const TestData testList[] = {
+    {"saw", self_avoiding_walk},
+    {"prisoner", prisoner},
+    {"fsm", fsm},
+    {"onemax", onemax},
+    {"tsp", tsp},
+    {"engine", engine},
+    {"micro", micro},
+    {"problems", problems},
+    {"lanes", lanes},
+    {NULL, NULL},
+};
+
+RunRecord lastRun;
+const char* traceFile = NULL;
+const char* progressName = NULL;
+evo_LogLevel logLevel = EVO_LOG_INFO;
+
+static double startTime = 0.0;
+
+const TestData* FindTest(const char* name)
+{
+    int i = 0;
+    while(testList[i].name && testList[i].cb)
+    {
+        if(!strcmp(testList[i].name, name))
+        {
+            return &testList[i];
+        }
+        i++;
+    }
+    return NULL;
+}
+
+void UseRunOptions(evo_Config* config)
+{
+    if(traceFile)
+    {
+        evo_Config_SetTraceFile(config, traceFile);
+    }
+    if(progressName)
+    {
+        evo_Config_SetProgressName(config, progressName);
+    }
+    evo_Config_SetLogLevel(config, logLevel);
+}
+
+void StartTime()
+{
+    startTime = evo_WallTime();
+}
+
+double EndTime()
+{
+    lastRun.wallTime = evo_WallTime() - startTime;
+    return lastRun.wallTime;
+}
+
+/* Prints the instructions per cycle, and the misses per thousand instructions, that a phase had. */
+static void PrintCounters(const double* counters)
+{
+    double instructions = counters[EVO_COUNTER_INSTRUCTIONS];
+    printf("  %6.2f IPC", counters[EVO_COUNTER_CYCLES] > 0 ? instructions / counters[EVO_COUNTER_CYCLES] : 0.0);
+    printf("  %8.3f cache misses/k", instructions > 0 ? counters[EVO_COUNTER_CACHE_MISSES] * 1000 / instructions : 0.0);
+    printf("  %8.3f branch misses/k", instructions > 0 ? counters[EVO_COUNTER_BRANCH_MISSES] * 1000 / instructions : 0.0);
+}
+
+void RecordStats(evo_Config* config)
+{
+    int i;
+    double total = 0;
+    const evo_Stats* stats = evo_Config_GetStats(config);
+    const evo_RunStats* runStats = evo_Config_GetRunStats(config);
+
+    lastRun.cpuTime = runStats->cpuTime;
+    lastRun.trials = stats->trials;
+    lastRun.failures = stats->failures;
+    lastRun.evaluations = runStats->evaluations;
+    lastRun.perfUnits = runStats->perfUnits;
+    memcpy(lastRun.phaseTime, runStats->phaseTime, sizeof(lastRun.phaseTime));
+    memcpy(lastRun.phaseCounters, runStats->phaseCounters, sizeof(lastRun.phaseCounters));
+
+    /* The phases are only timed when the library is built with EVO_USE_PHASE_TIMERS. */
+    for(i = 0; i < EVO_TIMER_COUNT; i++)
+    {
+        total += runStats->phaseTime[i];
+    }
+    if(total > 0)
+    {
+        printf("%.0f evaluations, %.0f per second\n", runStats->evaluations, runStats->evaluationsPerSecond);
+        for(i = 0; i < EVO_TIMER_COUNT; i++)
+        {
+            printf("%-12s %10.4f s %6.1f%%", evo_PhaseTimerName((evo_PhaseTimer) i),
+                runStats->phaseTime[i], runStats->phaseTime[i] * 100 / total);
+            if(runStats->perfUnits)
+            {
+                PrintCounters(runStats->phaseCounters[i]);
+            }
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include <evo.hpp>
+#include <evo_select_tournament.h>
+#include <evo_gene_bitstring.h>
+#include "tests.h"
+
+/*
+    OneMax with short bitstrings, run once through the C callbacks and once through evo::Engine.
+    Both use the same operators and random streams, so they should end up with the same stats,
+    and any difference in time is the cost of calling through function pointers.
+*/
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+#define TRIALS 96
+#define MAX_ITERATIONS 1000
+#define POPULATION 1000
+
+/* Bits per gene. Can be overridden on the command line. */
+static evo_uint BITS = 64;
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+
+    populationSize = evo_Context_GetPopulationSize(context);
+    if(!context->genes)
+    {
+        context->genes = (void**) malloc(sizeof(void*) * populationSize);
+        for(i = 0; i < populationSize; i++)
+        {
+            context->genes[i] = evo_Bitstring_New(BITS);
+        }
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Randomize(context, (evo_uint64*) context->genes[i], BITS);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+    populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Free((evo_uint64*) context->genes[i]);
+    }
+    free(context->genes);
+}
+
+/* The C callbacks. */
+static void PopulationFitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        context->fitnesses[i] = evo_Bitstring_PopCount((const evo_uint64*) context->genes[i], BITS);
+    }
+}
+
+static void Crossover(evo_Context* context,
+    void* parentA, void* parentB, void* childA, void* childB)
+{
+    evo_Bitstring_UniformCrossover(context, BITS,
+        (const evo_uint64*) parentA, (const evo_uint64*) parentB, (evo_uint64*) childA, (evo_uint64*) childB);
+}
+
+static void Mutation(evo_Context* context, void* gene)
+{
+    evo_Bitstring_FlipMutation(context, (evo_uint64*) gene, BITS, 1.0 / BITS);
+}
+
+static evo_bool Success(evo_Context* context)
+{
+    return context->bestFitness == BITS;
+}
+
+/*
+    The same operators, as functors. A gene is seen as its first word.
+    The fitness counts with the inline helper from evo_bits.h, so it is inlined into the loop.
+*/
+struct OnesFitness : evo::Operator
+{
+    double operator()(evo_Context* context, const evo_uint64& gene) const
+    {
+        return evo_PopCountWords(&gene, EVO_BITSTRING_WORDS(BITS));
+    }
+};
+
+struct UniformCrossover : evo::Operator
+{
+    void operator()(evo_Context* context, const evo_uint64& parentA, const evo_uint64& parentB,
+        evo_uint64& childA, evo_uint64& childB) const
+    {
+        evo_Bitstring_UniformCrossover(context, BITS, &parentA, &parentB, &childA, &childB);
+    }
+};
+
+struct FlipMutation : evo::Operator
+{
+    void operator()(evo_Context* context, evo_uint64& gene) const
+    {
+        evo_Bitstring_FlipMutation(context, &gene, BITS, 1.0 / BITS);
+    }
+};
+
+struct AllOnes : evo::Operator
+{
+    bool operator()(evo_Context* context) const
+    {
+        return context->bestFitness == BITS;
+    }
+};
+
+typedef evo::Engine<evo_uint64, OnesFitness, evo::TournamentSelection, UniformCrossover, FlipMutation, AllOnes> OneMaxEngine;
+
+/* Sets the attributes and population callbacks that both versions share. */
+static void Setup(evo_Config* config)
+{
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, 48);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
+    evo_Config_SetPopulationSize(config, POPULATION);
+
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+}
+
+static void Report(const char* name, double t, evo_Config* config)
+{
+    const evo_Stats* stats = evo_Config_GetStats(config);
+
+    RecordStats(config);
+    printf("Failures %u/%u\n", stats->failures, stats->trials);
+    printf("Mean iterations %lf\n", stats->sumIterations / stats->trials);
+    printf("%d threads took %lf seconds to solve OneMax (%u bits) with %s.\n", THREADS, t, BITS, name);
+}
+
+TEST(engine)
+{
+    double t;
+    const char* mode = "both";
+    evo_Config* config;
+    OneMaxEngine* engine;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by the bits per gene, and which version to run (c, cpp, both).\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        BITS = atoi(argv[3]);
+    }
+    if(argc > 4)
+    {
+        mode = argv[4];
+    }
+    if(BITS < 2)
+    {
+        fprintf(stderr, "Genes need at least 2 bits.\n");
+        return -1;
+    }
+
+    if(strcmp(mode, "cpp"))
+    {
+        config = evo_Config_New();
+        Setup(config);
+        evo_Config_SetFitnessOperator(config, PopulationFitness);
+        evo_UseTournamentSelection(config, POPULATION, 4);
+        evo_Config_SetCrossoverOperator(config, Crossover);
+        evo_Config_SetMutationOperator(config, Mutation);
+        evo_Config_SetSuccessPredicate(config, Success);
+
+        StartTime();
+        evo_Config_Execute(config);
+        if(!evo_Config_IsUsed(config))
+        {
+            fprintf(stderr, "Could not use the given config.\n");
+            return 0;
+        }
+        t = EndTime();
+        Report("C callbacks", t, config);
+        evo_Config_Free(config);
+    }
+
+    if(strcmp(mode, "c"))
+    {
+        engine = new OneMaxEngine(OnesFitness(), evo::TournamentSelection(4));
+        Setup(engine->GetConfig());
+
+        StartTime();
+        if(!engine->Execute())
+        {
+            fprintf(stderr, "Could not use the given config.\n");
+            delete engine;
+            return 0;
+        }
+        t = EndTime();
+        Report("evo::Engine", t, engine->GetConfig());
+        delete engine;
+    }
+    return 0;
+}
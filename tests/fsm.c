@@ -0,0 +1,253 @@
+#include <evo_select_tournament.h>
+#include <evo_select_lexicase.h>
+#include <evo_gene_fsm.h>
+#include <evo_bits.h>
+#include "tests.h"
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+/* Whether parents are picked by lexicase selection, with each test as a case, rather than by tournament. */
+static evo_bool LEXICASE = EVO_FALSE;
+#define TRIALS 240
+#define MAX_ITERATIONS 1000
+#define POPULATION 1000
+
+#define NUM_STATES 4
+#define NUM_SYMBOLS 2
+/* Words in a packed machine (checked against the layout at startup). */
+#define MACHINE_WORDS 1
+
+/*
+    The test strings are every binary string of up to MAX_LENGTH symbols.
+    The machine should accept the strings with an even number of 0s and an even number of 1s.
+*/
+#define MAX_LENGTH 6
+#define NUM_TESTS ((1 << ((MAX_LENGTH) + 1)) - 1)
+#define TEST_WORDS (((NUM_TESTS) + 63) / 64)
+
+/*
+    The tests form a complete binary trie, numbered in breadth-first order:
+    test 0 is the empty string, and test i followed by symbol x is test 2i + 1 + x.
+    So every test is a prefix step away from its parent (i - 1) / 2, which has a lower number,
+    and one pass in order visits every test exactly once, with no strings to walk.
+*/
+#define TEST_PARENT(i) (((i) - 1) >> 1)
+#define TEST_SYMBOL(i) (((i) - 1) & 1)
+
+/*
+    The machine reads a string one symbol at a time, and outputs 1 on a transition
+    if it accepts the string read so far. The start entry's output says whether it
+    accepts the empty string.
+*/
+typedef struct 
+{
+    evo_uint64 machine[MACHINE_WORDS];
+} StateMachine;
+
+/* How the machines are packed: NUM_STATES states, reading NUM_SYMBOLS symbols, and writing 0 or 1. */
+static evo_FsmLayout layout;
+
+/* Bit i is set if test i should be accepted. */
+static evo_uint64 expected[TEST_WORDS];
+
+static void BuildExpected()
+{
+    /* Bit x is set if the test has an odd number of symbol x. */
+    evo_uint parity[NUM_TESTS];
+    evo_uint i;
+
+    memset(expected, 0, sizeof(expected));
+    parity[0] = 0;
+    expected[0] = 1;
+    for(i = 1; i < NUM_TESTS; i++)
+    {
+        parity[i] = parity[TEST_PARENT(i)] ^ (1 << TEST_SYMBOL(i));
+        if(!parity[i])
+        {
+            expected[i / 64] |= ((evo_uint64) 1) << (i % 64);
+        }
+    }
+}
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+    StateMachine* gene;
+
+    populationSize = evo_Context_GetPopulationSize(context);
+    if(!context->genes)
+    {
+        context->genes = malloc(sizeof(void*) * populationSize);
+        for(i = 0; i < populationSize; i++)
+        {
+            gene = malloc(sizeof(StateMachine));
+            context->genes[i] = gene;
+        }
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        gene = context->genes[i];
+        evo_Fsm_Randomize(context, &layout, gene->machine);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+    populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        free(context->genes[i]);
+    }
+    free(context->genes);
+    return;
+}
+
+/*
+    Runs the machine over every test in one pass down the trie,
+    so each prefix is stepped once no matter how many tests share it.
+    The answers are collected as bits, and the score is the number that match.
+    If passed isn't NULL, the tests answered right are written to it, one bit each.
+*/
+static double IndividualFitness(const StateMachine* machine, evo_uint64* passed)
+{
+    evo_uint states[NUM_TESTS];
+    evo_uint64 accepted[TEST_WORDS];
+    evo_uint i, output;
+
+    memset(accepted, 0, sizeof(accepted));
+    evo_Fsm_GetStart(&layout, machine->machine, &states[0], &output);
+    accepted[0] = output;
+    for(i = 1; i < NUM_TESTS; i++)
+    {
+        states[i] = evo_Fsm_Step(&layout, machine->machine, states[TEST_PARENT(i)], TEST_SYMBOL(i), &output);
+        accepted[i / 64] |= ((evo_uint64) output) << (i % 64);
+    }
+
+    /* Count the wrong answers. */
+    for(i = 0; i < TEST_WORDS; i++)
+    {
+        accepted[i] ^= expected[i];
+    }
+    if(passed)
+    {
+        for(i = 0; i < TEST_WORDS; i++)
+        {
+            passed[i] = ~accepted[i];
+        }
+        /* The bits past the last test aren't cases. */
+        if(NUM_TESTS % 64)
+        {
+            passed[TEST_WORDS - 1] &= (((evo_uint64) 1) << (NUM_TESTS % 64)) - 1;
+        }
+    }
+    return NUM_TESTS - evo_PopCountWords(accepted, TEST_WORDS);
+}
+
+static void PopulationFitness(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        context->fitnesses[i] = IndividualFitness((const StateMachine*) (context->genes[i]),
+            LEXICASE ? evo_Lexicase_GetCaseBits(context, i) : NULL);
+    }
+}
+
+static void Crossover(evo_Context* context,
+    void* parentA, void* parentB, void* childA, void* childB)
+{
+    StateMachine* pa = parentA;
+    StateMachine* pb = parentB;
+    StateMachine* ca = childA;
+    StateMachine* cb = childB;
+
+    evo_Fsm_Crossover(context, &layout, pa->machine, pb->machine, ca->machine, cb->machine);
+}
+
+static void Mutation(evo_Context* context, void* d)
+{
+    StateMachine* gene = d;
+    evo_Fsm_Mutate(context, &layout, gene->machine);
+}
+
+static evo_bool Success(evo_Context* context)
+{
+    return context->bestFitness == NUM_TESTS;
+}
+
+TEST(fsm)
+{
+    double t;
+    evo_Stats* stats;
+    evo_Config* config = evo_Config_New();
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by the selection (tournament, lexicase).\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        LEXICASE = !strcmp(argv[3], "lexicase");
+    }
+
+    evo_FsmLayout_Init(&layout, NUM_STATES, NUM_SYMBOLS, 2);
+    if(layout.wordCount > MACHINE_WORDS)
+    {
+        fprintf(stderr, "Machines need %u words, but genes only have room for %u.\n", layout.wordCount, MACHINE_WORDS);
+        return -1;
+    }
+    BuildExpected();
+
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, 48);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
+    evo_Config_SetPopulationSize(config, POPULATION);
+
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    evo_Config_SetFitnessOperator(config, PopulationFitness);
+
+    if(LEXICASE)
+    {
+        evo_UseLexicaseSelection(config, POPULATION, NUM_TESTS);
+    }
+    else
+    {
+        evo_UseTournamentSelection(config, POPULATION, 4);
+    }
+
+    evo_Config_SetCrossoverOperator(config, Crossover);
+    evo_Config_SetMutationOperator(config, Mutation);
+    evo_Config_SetSuccessPredicate(config, Success);
+
+    StartTime();
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        fprintf(stderr, "Could not use the given config.\n");
+        return 0;
+    }
+
+    t = EndTime();
+
+    stats = evo_Config_GetStats(config);
+    RecordStats(config);
+    printf("Failures %u/%u\n", stats->failures, stats->trials);
+    printf("Best fitness %lf\n", stats->bestFitness);
+    printf("%d threads took %lf seconds to learn a parity state machine (%s selection).\n",
+        THREADS, t, LEXICASE ? "lexicase" : "tournament");
+
+    evo_Config_Free(config);
+    return 0;
+}
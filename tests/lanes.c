@@ -0,0 +1,213 @@
+#include <evo_select_tournament.h>
+#include <evo_gene_bitstring.h>
+#include <evo_bits.h>
+#include <evo_compete.h>
+#include "tests.h"
+
+/*
+    Checks that lanes don't change a run's results. A small bitstring game is run once
+    without lanes and once with them, and the final population of every trial is hashed.
+    Each trial follows its own seed, so both runs should end every trial the same way,
+    whichever lane ran it.
+*/
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+#define STREAMS 8
+#define TRIALS 16
+#define TRIALS_PER_SEED (TRIALS / STREAMS)
+#define MAX_ITERATIONS 50
+#define POPULATION 64
+#define BITS 64
+#define OPPONENTS 4
+#define HALL_OF_FAME_SIZE 8
+#define SWISS_ROUNDS 6
+
+/* Lanes per unit in the second run. */
+static evo_uint LANES = 4;
+
+/* The population each trial ended with, hashed, indexed by seed and then trial. */
+static evo_uint64 hashes[TRIALS];
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+
+    populationSize = evo_Context_GetPopulationSize(context);
+    if(!context->genes)
+    {
+        context->genes = malloc(sizeof(void*) * populationSize);
+        for(i = 0; i < populationSize; i++)
+        {
+            context->genes[i] = evo_Bitstring_New(BITS);
+        }
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Randomize(context, context->genes[i], BITS);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize;
+    populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        evo_Bitstring_Free(context->genes[i]);
+    }
+    free(context->genes);
+}
+
+/* Each player scores the bits it has set that the other doesn't. */
+static void Game(evo_Context* context, void* geneA, void* geneB, double* payoffA, double* payoffB)
+{
+    evo_uint64 a = *(const evo_uint64*) geneA;
+    evo_uint64 b = *(const evo_uint64*) geneB;
+    evo_uint64 onlyA = a & ~b;
+    evo_uint64 onlyB = b & ~a;
+
+    *payoffA = evo_PopCountWords(&onlyA, 1);
+    *payoffB = evo_PopCountWords(&onlyB, 1);
+}
+
+static void Crossover(evo_Context* context,
+    void* parentA, void* parentB, void* childA, void* childB)
+{
+    evo_Bitstring_UniformCrossover(context, BITS, parentA, parentB, childA, childB);
+}
+
+static void Mutation(evo_Context* context, void* gene)
+{
+    evo_Bitstring_FlipMutation(context, gene, BITS, 1.0 / BITS);
+}
+
+/* Never succeeds, so every trial runs to the end. The newest generation's hash replaces the last. */
+static evo_bool Success(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint64 hash = 0;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    /* A context that lost track of its seed's index has nowhere to put its hash. */
+    if(context->seedIndex - 1 >= STREAMS || context->trial >= TRIALS_PER_SEED)
+    {
+        return 0;
+    }
+    for(i = 0; i < populationSize; i++)
+    {
+        hash = hash * 31 + *(const evo_uint64*) context->genes[i];
+    }
+    /* Each seed's trials are run by one unit or lane, so no two threads write the same hash. */
+    hashes[(context->seedIndex - 1) * TRIALS_PER_SEED + context->trial] = hash;
+    return 0;
+}
+
+/* Runs the game with the given lanes per unit, and fills in the hashes. Returns false if the config was rejected. */
+static evo_bool Run(const char* mode, evo_uint laneCount)
+{
+    evo_Config* config = evo_Config_New();
+
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, STREAMS);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
+    evo_Config_SetPopulationSize(config, POPULATION);
+    evo_Config_SetLaneCount(config, laneCount);
+
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    if(!strcmp(mode, "hall"))
+    {
+        evo_UseHallOfFameCompetition(config, Game, POPULATION, OPPONENTS, HALL_OF_FAME_SIZE,
+            EVO_BITSTRING_WORDS(BITS) * sizeof(evo_uint64));
+    }
+    else if(!strcmp(mode, "swiss"))
+    {
+        evo_UseSwissCompetition(config, Game, POPULATION, SWISS_ROUNDS);
+    }
+    else if(!strcmp(mode, "roundrobin"))
+    {
+        evo_Config_SetPairwiseFitness(config, Game);
+    }
+    else
+    {
+        evo_UseSampledCompetition(config, Game, POPULATION, OPPONENTS);
+    }
+    evo_UseTournamentSelection(config, POPULATION, 4);
+    evo_Config_SetCrossoverOperator(config, Crossover);
+    evo_Config_SetMutationOperator(config, Mutation);
+    evo_Config_SetSuccessPredicate(config, Success);
+
+    memset(hashes, 0, sizeof(hashes));
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        evo_Config_Free(config);
+        return EVO_FALSE;
+    }
+    RecordStats(config);
+    evo_Config_Free(config);
+    return EVO_TRUE;
+}
+
+TEST(lanes)
+{
+    double t;
+    evo_uint i, differences;
+    evo_uint64 expected[TRIALS];
+    const char* mode = "sampled";
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by the competition mode (sampled, hall, swiss, roundrobin), and lanes per unit.\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        mode = argv[3];
+    }
+    if(argc > 4)
+    {
+        LANES = atoi(argv[4]);
+    }
+    if(LANES < 2)
+    {
+        fprintf(stderr, "The second run needs at least 2 lanes.\n");
+        return -1;
+    }
+
+    StartTime();
+    if(!Run(mode, 1))
+    {
+        fprintf(stderr, "Could not use the given config.\n");
+        return -1;
+    }
+    memcpy(expected, hashes, sizeof(hashes));
+    if(!Run(mode, LANES))
+    {
+        fprintf(stderr, "Could not use the given config.\n");
+        return -1;
+    }
+    t = EndTime();
+
+    differences = 0;
+    for(i = 0; i < TRIALS; i++)
+    {
+        if(hashes[i] != expected[i])
+        {
+            fprintf(stderr, "Seed %u trial %u ended differently with %u lanes.\n", i / TRIALS_PER_SEED, i % TRIALS_PER_SEED, LANES);
+            differences++;
+        }
+    }
+    printf("Differences %u/%u\n", differences, TRIALS);
+    printf("%d threads took %lf seconds to run %s competitions without lanes and with %u lanes.\n", THREADS, t, mode, LANES);
+    return differences ? -1 : 0;
+}
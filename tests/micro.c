@@ -0,0 +1,291 @@
+#include <evo_select_tournament.h>
+#include <evo_select_roulette.h>
+#include <evo_time.h>
+#include "tests.h"
+
+/*
+    Microbenchmarks of the engine's own per-iteration work, with no problem attached,
+    at population sizes from 100 to 10 million. Each reports nanoseconds per gene,
+    so a change in the engine's core shows up apart from any problem code.
+
+    Every unit runs the same benchmark at once, so with more than one thread the numbers
+    show how the units get in each other's way (mostly memory bandwidth, at large sizes).
+*/
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+/* Each measurement repeats its step until at least this many seconds have passed. */
+#define MIN_SECONDS 0.2
+#define MIN_POPULATION 100
+#define MAX_POPULATION 10000000
+/* Roulette selection is quadratic in the population size, so it stops here. */
+#define MAX_ROULETTE_POPULATION 10000
+
+typedef struct
+{
+    const char* name;
+    /* Does the step once. */
+    void (*step)(evo_Context* context);
+    /* Sets the selection operator the step needs, if any. */
+    void (*setup)(evo_Config* config, evo_uint populationSize);
+    evo_uint maxPopulation;
+    /*
+        Another benchmark whose time is taken off this one's, for a step that can't run
+        without some setup each time (like a clear), or NULL.
+    */
+    const char* less;
+} Benchmark;
+
+/* Nanoseconds per gene, measured by each unit. */
+static double* unitResults = NULL;
+
+static evo_bool Initializer(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+
+    /* Fitnesses like a real population's, for the selection operators to sort through. */
+    for(i = 0; i < populationSize; i++)
+    {
+        context->fitnesses[i] = 1 + evo_Random(context);
+    }
+    return 1;
+}
+
+static void Finalizer(evo_Context* context)
+{
+}
+
+/* A selection that does nothing, so that evo_Context_Select only clears the events and marks. */
+static void NoSelection(evo_Context* context)
+{
+}
+
+/* Fills the events in order, one for every four genes. */
+static void InOrderSelection(evo_Context* context)
+{
+    evo_uint i;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i + 3 < populationSize; i += 4)
+    {
+        evo_Context_AddBreedEvent(context, i, i + 1, i + 2, i + 3);
+    }
+}
+
+static void UseNoSelection(evo_Config* config, evo_uint populationSize)
+{
+    evo_Config_SetSelectionOperator(config, NoSelection);
+}
+
+static void UseInOrderSelection(evo_Config* config, evo_uint populationSize)
+{
+    evo_Config_SetSelectionOperator(config, InOrderSelection);
+}
+
+static void UseTournament(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseTournamentSelection(config, populationSize, 4);
+}
+
+static void UseRoulette(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseRouletteSelection(config, populationSize);
+}
+
+static void SelectStep(evo_Context* context)
+{
+    evo_Context_Select(context);
+}
+
+static void BestFitnessStep(evo_Context* context)
+{
+    evo_Context_FindBestFitness(context);
+}
+
+/* The sums keep the compiler from dropping the calls. */
+static volatile double randomSink;
+
+static void RandomStep(evo_Context* context)
+{
+    evo_uint i;
+    double sum = 0;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        sum += evo_Random(context);
+    }
+    randomSink = sum;
+}
+
+static void RandomIntStep(evo_Context* context)
+{
+    evo_uint i;
+    double sum = 0;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    for(i = 0; i < populationSize; i++)
+    {
+        sum += evo_RandomInt(context, 0, populationSize);
+    }
+    randomSink = sum;
+}
+
+/*
+    Adding breed events needs the events and marks cleared each time, so the clear is timed
+    along with it, and then the clear benchmark's time is taken off.
+*/
+static const Benchmark benchmarks[] = {
+    {"clear", SelectStep, UseNoSelection, MAX_POPULATION, NULL},
+    {"best", BestFitnessStep, UseNoSelection, MAX_POPULATION, NULL},
+    {"breedevent", SelectStep, UseInOrderSelection, MAX_POPULATION, "clear"},
+    {"tournament", SelectStep, UseTournament, MAX_POPULATION, NULL},
+    {"roulette", SelectStep, UseRoulette, MAX_ROULETTE_POPULATION, NULL},
+    {"random", RandomStep, UseNoSelection, MAX_POPULATION, NULL},
+    {"randomint", RandomIntStep, UseNoSelection, MAX_POPULATION, NULL},
+    {NULL, NULL, NULL, 0, NULL}
+};
+
+/* Returns the benchmark with the given name, or NULL if there isn't one. */
+static const Benchmark* FindBenchmark(const char* name)
+{
+    evo_uint b;
+    for(b = 0; benchmarks[b].name; b++)
+    {
+        if(!strcmp(benchmarks[b].name, name))
+        {
+            return &benchmarks[b];
+        }
+    }
+    return NULL;
+}
+
+/* Runs the step over and over, instead of the usual trial. */
+static evo_bool Measure(evo_Context* context, void* param)
+{
+    const Benchmark* benchmark = param;
+    evo_uint reps = 0;
+    double start, elapsed;
+
+    start = evo_WallTime();
+    do
+    {
+        benchmark->step(context);
+        reps++;
+        elapsed = evo_WallTime() - start;
+    } while(elapsed < MIN_SECONDS);
+
+    unitResults[context->id] = elapsed * 1e9 / ((double) reps * evo_Context_GetPopulationSize(context));
+    return 1;
+}
+
+/* Returns the nanoseconds per gene, averaged over the units, or a negative number if the config couldn't be used. */
+static double RunStep(const Benchmark* benchmark, evo_uint populationSize)
+{
+    int i;
+    double sum = 0;
+    evo_Config* config;
+
+    config = evo_Config_New();
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, THREADS);
+    evo_Config_SetTrials(config, THREADS);
+    evo_Config_SetMaxIterations(config, 1);
+    evo_Config_SetPopulationSize(config, populationSize);
+
+    evo_Config_SetPopulationInitializer(config, Initializer);
+    evo_Config_SetPopulationFinalizer(config, Finalizer);
+    benchmark->setup(config, populationSize);
+    evo_Config_SetTrialRunner(config, Measure, (void*) benchmark);
+
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        evo_Config_Free(config);
+        return -1;
+    }
+    evo_Config_Free(config);
+
+    for(i = 0; i < THREADS; i++)
+    {
+        sum += unitResults[i];
+    }
+    return sum / THREADS;
+}
+
+/* Like RunStep, but with the time of the benchmark it's measured less taken off. */
+static double RunBenchmark(const Benchmark* benchmark, evo_uint populationSize)
+{
+    double ns, lessNs;
+
+    ns = RunStep(benchmark, populationSize);
+    if(ns < 0 || !benchmark->less)
+    {
+        return ns;
+    }
+    lessNs = RunStep(FindBenchmark(benchmark->less), populationSize);
+    if(lessNs < 0)
+    {
+        return lessNs;
+    }
+    /* Noise can make the difference come out a little below zero, when it's that small. */
+    return (ns > lessNs) ? ns - lessNs : 0;
+}
+
+TEST(micro)
+{
+    double t, ns;
+    evo_uint b, populationSize;
+    evo_uint maxPopulation = MAX_POPULATION;
+    const char* only = NULL;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by one benchmark to run, and the largest population size.\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3 && strcmp(argv[3], "all"))
+    {
+        only = argv[3];
+    }
+    if(argc > 4)
+    {
+        maxPopulation = atoi(argv[4]);
+    }
+    if(THREADS < 1)
+    {
+        fprintf(stderr, "There needs to be at least 1 thread.\n");
+        return -1;
+    }
+
+    unitResults = malloc(sizeof(double) * THREADS);
+    printf("%-12s %12s %12s\n", "benchmark", "population", "ns/gene");
+    StartTime();
+    for(b = 0; benchmarks[b].name; b++)
+    {
+        if(only && strcmp(only, benchmarks[b].name))
+        {
+            continue;
+        }
+        for(populationSize = MIN_POPULATION;
+            populationSize <= maxPopulation && populationSize <= benchmarks[b].maxPopulation;
+            populationSize *= 10)
+        {
+            ns = RunBenchmark(&benchmarks[b], populationSize);
+            if(ns < 0)
+            {
+                fprintf(stderr, "Could not use the config for %s at %u genes.\n", benchmarks[b].name, populationSize);
+                free(unitResults);
+                return 0;
+            }
+            printf("%-12s %12u %12.3f\n", benchmarks[b].name, populationSize, ns);
+        }
+    }
+    t = EndTime();
+    printf("%d threads took %lf seconds to run the microbenchmarks.\n", THREADS, t);
+
+    free(unitResults);
+    return 0;
+}
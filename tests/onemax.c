@@ -0,0 +1,90 @@
+#include <evo_select_tournament.h>
+#include <evo_problem_onemax.h>
+#include "tests.h"
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+#define TRIALS 96
+#define MAX_ITERATIONS 1000
+#define POPULATION 1000
+
+/* Bits per gene. Can be overridden on the command line. */
+static evo_uint BITS = 1024;
+
+/* Which bitstring crossover to use, by its number of cut points (0 for uniform). */
+static const char* crossoverNames[] = { "twopoint", "uniform", "npoint" };
+static const evo_uint crossoverPoints[] = { 2, 0, 8 };
+static evo_uint CROSSOVER = 1;
+
+TEST(onemax)
+{
+    double t;
+    evo_uint i;
+    evo_Stats* stats;
+    evo_Config* config;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by the bits per gene, and a crossover (twopoint, uniform, npoint).\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        BITS = atoi(argv[3]);
+    }
+    if(argc > 4)
+    {
+        for(i = 0; i < sizeof(crossoverNames) / sizeof(crossoverNames[0]); i++)
+        {
+            if(!strcmp(argv[4], crossoverNames[i]))
+            {
+                break;
+            }
+        }
+        if(i == sizeof(crossoverNames) / sizeof(crossoverNames[0]))
+        {
+            fprintf(stderr, "Unknown crossover '%s'.\n", argv[4]);
+            return -1;
+        }
+        CROSSOVER = i;
+    }
+    if(BITS < 2)
+    {
+        fprintf(stderr, "Genes need at least 2 bits.\n");
+        return -1;
+    }
+
+    config = evo_Config_New();
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, 48);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
+    evo_Config_SetPopulationSize(config, POPULATION);
+
+    evo_UseOneMax(config, POPULATION, BITS, crossoverPoints[CROSSOVER]);
+    evo_UseTournamentSelection(config, POPULATION, 4);
+
+    StartTime();
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        fprintf(stderr, "Could not use the given config.\n");
+        return 0;
+    }
+
+    t = EndTime();
+
+    stats = evo_Config_GetStats(config);
+    RecordStats(config);
+    printf("Failures %u/%u\n", stats->failures, stats->trials);
+    printf("Best fitness %lf\n", stats->bestFitness);
+    printf("%d threads took %lf seconds to solve OneMax (%u bits, %s crossover).\n",
+        THREADS, t, BITS, crossoverNames[CROSSOVER]);
+
+    evo_Config_Free(config);
+    return 0;
+}
@@ -1,41 +1,67 @@
 #include <evo_select_tournament.h>
+#include <evo_compete.h>
+#include <evo_payoff_cache.h>
+#include <evo_gene_fsm.h>
 #include "tests.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 /*#define THREADS 16*/
 
 static int THREADS = 0;
 #define TRIALS 240
 #define MAX_ITERATIONS 500
-#define POPULATION 32
-#define MATCHES 100
+/* Population size. Can be overridden on the command line. */
+static evo_uint POPULATION = 32;
+/* Rounds played per game. Can be overridden on the command line. */
+static evo_uint MATCHES = 100;
+/* Trials each unit runs in lockstep. Can be overridden on the command line. */
+static evo_uint LANES = 1;
+/* Settings for the competition modes that don't play a full round robin. */
+#define OPPONENTS 8
+#define HALL_OF_FAME_SIZE 64
+#define SWISS_ROUNDS 8
+/* Room for this many remembered games, shared by all units. */
+#define PAYOFF_CACHE_SIZE (1 << 20)
 
 // Number of states that this machine can hold.
 #define STATE_COUNT 4
+// Bits needed to hold a state number, in a canonical ID.
+#define STATE_BITS 2
 // Alphabet = { 1 = Cooperate, 0 = Defect } 
 #define ALPHABET_DEFECT 0
 #define ALPHABET_COOPERATE 1
 #define ALPHABET_SIZE 2
-// Number of outputs.
-#define OUTPUT_COUNT ((ALPHABET_SIZE) * (STATE_COUNT))
+// Words in a packed machine, and log2 of the bits in each entry (both checked against the layout at startup).
+#define MACHINE_WORDS 1
+#define ENTRY_SHIFT 2
+// Number of distinct joint states of a game: both players' states and last responses.
+#define JOINT_STATE_COUNT ((STATE_COUNT) * (STATE_COUNT) * (ALPHABET_SIZE) * (ALPHABET_SIZE))
+
+static const double payoffMatrix[2][2] = {{ 3.0, 5.0 }, { 0.0, 1.0 }};
 
 typedef struct
 {
-    // The first state the player uses.
-    int initialState;
-    // The first response the player uses.
-    int initialResponse;
-    // The next state for each pair (input, current state).
-    int nextStates[OUTPUT_COUNT];
-    // Output action in alphabet for each pair (input, current state).
-    // Can either Cooperate or Defect for each input given.
-    int responses[OUTPUT_COUNT];
+    // The machine, packed with the layout below.
+    // Its input is the opponent's last response, and its output is the player's response.
+    // The start entry holds the first state and the first response the player uses.
+    evo_uint64 machine[MACHINE_WORDS];
+    // The canonical ID of this player (see CanonicalId), or 0 if it needs to be worked out again.
+    evo_uint64 canonicalId;
 } PrisonerPlayer;
 
+/* How the machines are packed: STATE_COUNT states, reading and writing ALPHABET_SIZE symbols. */
+static evo_FsmLayout layout;
+
+/* Results of games between canonical players, shared by every unit. */
+static evo_PayoffCache* payoffCache = NULL;
+
 static void DumpResults(evo_Context* context, evo_bool last)
 {
     FILE* f;
     PrisonerPlayer* gene;
-    evo_uint p, i;
+    evo_uint p, s, x, state, output;
     evo_uint populationSize = evo_Context_GetPopulationSize(context);
     char alphabet[] = "DC";
     char name[128];
@@ -54,12 +80,17 @@ static void DumpResults(evo_Context* context, evo_bool last)
     {
         fprintf(f, "FSM %d:\n", p);
         gene = context->genes[p];
-        fprintf(f, "\tInitial State: %d\n", gene->initialState);
-        fprintf(f, "\tInitial Response: %c\n", alphabet[gene->initialResponse]);
+        evo_Fsm_GetStart(&layout, gene->machine, &state, &output);
+        fprintf(f, "\tInitial State: %d\n", state);
+        fprintf(f, "\tInitial Response: %c\n", alphabet[output]);
         fprintf(f, "\tTransitions:\n");
-        for(i = 0; i < OUTPUT_COUNT; i++)
+        for(x = 0; x < ALPHABET_SIZE; x++)
         {
-            fprintf(f, "\t\tState: %d\tInput: %c\tNew State: %d\tOutput: %c\n", i % STATE_COUNT, alphabet[i / STATE_COUNT], gene->nextStates[i], alphabet[gene->responses[i]]);
+            for(s = 0; s < STATE_COUNT; s++)
+            {
+                state = evo_Fsm_Step(&layout, gene->machine, s, x, &output);
+                fprintf(f, "\t\tState: %d\tInput: %c\tNew State: %d\tOutput: %c\n", s, alphabet[x], state, alphabet[output]);
+            }
         }
         fprintf(f, "\n\n");
     }
@@ -68,7 +99,7 @@ static void DumpResults(evo_Context* context, evo_bool last)
 
 static evo_bool Initializer(evo_Context* context)
 {
-    evo_uint i, j;
+    evo_uint i;
     evo_uint populationSize;
     PrisonerPlayer* gene;
 
@@ -89,13 +120,8 @@ static evo_bool Initializer(evo_Context* context)
     for(i = 0; i < populationSize; i++)
     {
         gene = context->genes[i];
-        gene->initialState = evo_RandomInt(context, 0, STATE_COUNT);
-        gene->initialResponse = evo_RandomInt(context, 0, ALPHABET_SIZE);
-        for(j = 0; j < OUTPUT_COUNT; j++)
-        {
-            gene->nextStates[j] = evo_RandomInt(context, 0, STATE_COUNT);
-            gene->responses[j] = evo_RandomInt(context, 0, ALPHABET_SIZE);
-        }
+        evo_Fsm_Randomize(context, &layout, gene->machine);
+        gene->canonicalId = 0;
     }
     return 1;
 }
@@ -117,122 +143,516 @@ static void Finalizer(evo_Context* context)
     return;
 }
 
-static void RoundRobin(evo_Context* context)
+/*
+    Feeds an input to a machine, like evo_Fsm_Step, but with the layout's shifts and masks
+    as constants. Games spend most of their time here, and with the layout read at run time,
+    each step would take a few more instructions on the chain from one state to the next.
+*/
+static evo_uint Step(const evo_uint64* machine, evo_uint state, evo_uint input, evo_uint* response)
 {
-    const double payoffMatrix[2][2] = {{ 3.0, 5.0 }, { 0.0, 1.0 }};
-    evo_uint populationSize;
+    evo_uint bits = (evo_uint) (machine[0] >> ((state * ALPHABET_SIZE + input) << ENTRY_SHIFT));
+    *response = (bits >> STATE_BITS) & 1;
+    return bits & (STATE_COUNT - 1);
+}
+
+/*
+    Plays a game of a number of rounds between two players, and adds up the payoff for each.
 
+    Both players are deterministic, so the joint state of the game (both states and both
+    last responses) must repeat within JOINT_STATE_COUNT rounds. Once it does, the rest of
+    the game is some whole laps of that cycle plus a partial one, which are added up
+    from prefix sums instead of being played out. So the cost doesn't depend on the rounds.
+*/
+static void PlayGame(const PrisonerPlayer* a, const PrisonerPlayer* b, evo_uint rounds,
+    double* scoreA, double* scoreB)
+{
+    int firstSeen[JOINT_STATE_COUNT];
+    /* Payoffs summed over the first k rounds. */
+    double sumA[JOINT_STATE_COUNT + 1];
+    double sumB[JOINT_STATE_COUNT + 1];
     evo_uint stateA, stateB;
     evo_uint responseA, responseB, responseTemp;
-    evo_uint i, j, k;
+    evo_uint k, joint, start, period, laps, rest;
+    const evo_uint64* machineA = a->machine;
+    const evo_uint64* machineB = b->machine;
 
-    PrisonerPlayer* a;
-    PrisonerPlayer* b;
-    double* fitnesses;
+    for(k = 0; k < JOINT_STATE_COUNT; k++)
+    {
+        firstSeen[k] = -1;
+    }
+    sumA[0] = sumB[0] = 0.0;
 
-    populationSize = evo_Context_GetPopulationSize(context);
-    fitnesses = context->fitnesses;
-    for(i = 0; i < populationSize - 1; i++)
+    evo_Fsm_GetStart(&layout, machineA, &stateA, &responseA);
+    evo_Fsm_GetStart(&layout, machineB, &stateB, &responseB);
+    for(k = 0; k < rounds; k++)
     {
-        for(j = i + 1; j < populationSize; j++)
+        joint = ((stateA * STATE_COUNT + stateB) * ALPHABET_SIZE + responseA) * ALPHABET_SIZE + responseB;
+        if(firstSeen[joint] >= 0)
         {
-            a = (PrisonerPlayer*) context->genes[i];
-            b = (PrisonerPlayer*) context->genes[j];
-            stateA = a->initialState;
-            stateB = b->initialState;
-            responseA = b->initialResponse;
-            responseB = b->initialResponse;
-            for(k = 0; k < MATCHES; k++)
-            {
-                /* Record fitness for both players. */
-                fitnesses[i] += payoffMatrix[responseA][responseB];
-                fitnesses[j] += payoffMatrix[responseB][responseA];
-                /* Feed actions. */
-                stateA = a->nextStates[responseB * STATE_COUNT + stateA];
-                responseTemp = a->responses[responseB * STATE_COUNT + stateA];
+            break;
+        }
+        firstSeen[joint] = k;
+
+        /* Record payoff for both players. */
+        sumA[k + 1] = sumA[k] + payoffMatrix[responseA][responseB];
+        sumB[k + 1] = sumB[k] + payoffMatrix[responseB][responseA];
+        /* Feed actions. */
+        stateA = Step(machineA, stateA, responseB, &responseTemp);
+        stateB = Step(machineB, stateB, responseA, &responseB);
+        responseA = responseTemp;
+    }
 
-                stateB = b->nextStates[responseA * STATE_COUNT + stateB];
-                responseB = b->responses[responseA * STATE_COUNT + stateB];
+    /* Game finished before anything repeated. */
+    if(k == rounds)
+    {
+        *scoreA = sumA[k];
+        *scoreB = sumB[k];
+        return;
+    }
 
-                responseA = responseTemp;
+    /* Rounds [start, k) form a cycle that repeats for the rest of the game. */
+    start = firstSeen[joint];
+    period = k - start;
+    laps = (rounds - k) / period;
+    rest = (rounds - k) % period;
+    *scoreA = sumA[k] + laps * (sumA[k] - sumA[start]) + (sumA[start + rest] - sumA[start]);
+    *scoreB = sumB[k] + laps * (sumB[k] - sumB[start]) + (sumB[start + rest] - sumB[start]);
+}
+
+/*
+    Plays the same pairing of genes in eight lanes at once, one lane per 32-bit element,
+    and adds up each lane's payoffs. This works like PlayGame, except the joint states each
+    lane has seen are kept as a 64-bit mask (split in two halves), and the rounds go on until
+    every lane has repeated one. Then each lane's cycle is found in the history and added up,
+    still eight lanes at a time.
+
+    The transitions of a machine are its low 32 bits, since there are 8 of them at 4 bits each.
+*/
+#ifdef __AVX2__
+static void PlayGames8(const evo_uint* transitionsA, const evo_uint* transitionsB,
+    const evo_uint* startA, const evo_uint* startB, evo_uint rounds, double* scoresA, double* scoresB)
+{
+    /* History for every lane, one round after another. A repeat happens within JOINT_STATE_COUNT rounds. */
+    evo_uint joints[(JOINT_STATE_COUNT + 1) * 8];
+    evo_uint sumsA[(JOINT_STATE_COUNT + 2) * 8];
+    evo_uint sumsB[(JOINT_STATE_COUNT + 2) * 8];
+    const __m256i payoffs = _mm256_set1_epi32((int) payoffMatrix[0][0] | ((int) payoffMatrix[0][1] << 4)
+        | ((int) payoffMatrix[1][0] << 8) | ((int) payoffMatrix[1][1] << 12));
+    const __m256i payoffMask = _mm256_set1_epi32(15);
+    const __m256i stateMask = _mm256_set1_epi32(STATE_COUNT - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i lowBits = _mm256_set1_epi32(31);
+    const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i machineA, machineB, stateA, stateB, responseA, responseB, bitsA, bitsB;
+    __m256i sumA, sumB, joint, bit, high, seen, seenLow, seenHigh, repeated, done;
+    __m256i repeatedAt, repeatedJoint, start, found, period, rest, kIndex, startIndex, restIndex;
+    __m256d left[2], laps[2], partial[2], atK, atStart, atRest;
+    __m128i halves[2];
+    evo_uint k, s, h;
+
+    machineA = _mm256_loadu_si256((const __m256i*) transitionsA);
+    machineB = _mm256_loadu_si256((const __m256i*) transitionsB);
+    bitsA = _mm256_loadu_si256((const __m256i*) startA);
+    bitsB = _mm256_loadu_si256((const __m256i*) startB);
+    stateA = _mm256_and_si256(bitsA, stateMask);
+    stateB = _mm256_and_si256(bitsB, stateMask);
+    responseA = _mm256_srli_epi32(bitsA, STATE_BITS);
+    responseB = _mm256_srli_epi32(bitsB, STATE_BITS);
+    sumA = sumB = seenLow = seenHigh = done = repeatedAt = repeatedJoint = _mm256_setzero_si256();
+    _mm256_storeu_si256((__m256i*) sumsA, sumA);
+    _mm256_storeu_si256((__m256i*) sumsB, sumB);
+
+    for(k = 0; k < rounds; k++)
+    {
+        joint = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(stateA, STATE_BITS + 2), _mm256_slli_epi32(stateB, 2)),
+            _mm256_or_si256(_mm256_add_epi32(responseA, responseA), responseB));
+        _mm256_storeu_si256((__m256i*) (joints + k * 8), joint);
+
+        /* Note the lanes that have just hit a joint state for the second time. */
+        bit = _mm256_sllv_epi32(one, _mm256_and_si256(joint, lowBits));
+        high = _mm256_cmpgt_epi32(joint, lowBits);
+        seen = _mm256_blendv_epi8(seenLow, seenHigh, high);
+        repeated = _mm256_andnot_si256(done, _mm256_cmpeq_epi32(_mm256_and_si256(seen, bit), bit));
+        if(!_mm256_testz_si256(repeated, repeated))
+        {
+            repeatedAt = _mm256_blendv_epi8(repeatedAt, _mm256_set1_epi32(k), repeated);
+            repeatedJoint = _mm256_blendv_epi8(repeatedJoint, joint, repeated);
+            done = _mm256_or_si256(done, repeated);
+            if(_mm256_movemask_ps(_mm256_castsi256_ps(done)) == 0xFF)
+            {
+                break;
             }
         }
+        seenLow = _mm256_or_si256(seenLow, _mm256_andnot_si256(high, bit));
+        seenHigh = _mm256_or_si256(seenHigh, _mm256_and_si256(high, bit));
+
+        /* Record payoff for both players. */
+        sumA = _mm256_add_epi32(sumA, _mm256_and_si256(_mm256_srlv_epi32(payoffs,
+            _mm256_slli_epi32(_mm256_add_epi32(_mm256_add_epi32(responseA, responseA), responseB), 2)), payoffMask));
+        sumB = _mm256_add_epi32(sumB, _mm256_and_si256(_mm256_srlv_epi32(payoffs,
+            _mm256_slli_epi32(_mm256_add_epi32(_mm256_add_epi32(responseB, responseB), responseA), 2)), payoffMask));
+        _mm256_storeu_si256((__m256i*) (sumsA + (k + 1) * 8), sumA);
+        _mm256_storeu_si256((__m256i*) (sumsB + (k + 1) * 8), sumB);
+
+        /* Feed actions: each machine reads entry (state * ALPHABET_SIZE + other's response). */
+        bitsA = _mm256_srlv_epi32(machineA, _mm256_slli_epi32(_mm256_add_epi32(_mm256_add_epi32(stateA, stateA), responseB), 2));
+        bitsB = _mm256_srlv_epi32(machineB, _mm256_slli_epi32(_mm256_add_epi32(_mm256_add_epi32(stateB, stateB), responseA), 2));
+        stateA = _mm256_and_si256(bitsA, stateMask);
+        stateB = _mm256_and_si256(bitsB, stateMask);
+        responseA = _mm256_and_si256(_mm256_srli_epi32(bitsA, STATE_BITS), one);
+        responseB = _mm256_and_si256(_mm256_srli_epi32(bitsB, STATE_BITS), one);
     }
 
-    /* Normalize the fitnesses */
-    for(i = 0; i < populationSize; i++)
+    /*
+        Lanes that never repeated played every round, so they're treated as an empty cycle
+        starting at the end. The rest find where their cycle started.
+    */
+    repeatedAt = _mm256_blendv_epi8(_mm256_set1_epi32(k), repeatedAt, done);
+    start = repeatedAt;
+    found = _mm256_xor_si256(done, _mm256_cmpeq_epi32(done, done));
+    for(s = 0; s < k; s++)
     {
-        fitnesses[i] /= ((populationSize - 1) * MATCHES);
+        repeated = _mm256_andnot_si256(found,
+            _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (joints + s * 8)), repeatedJoint));
+        start = _mm256_blendv_epi8(start, _mm256_set1_epi32(s), repeated);
+        found = _mm256_or_si256(found, repeated);
+    }
+    period = _mm256_max_epi32(_mm256_sub_epi32(repeatedAt, start), one);
+    /*
+        The laps are worked out in doubles, which hold any round count exactly, so dividing
+        and flooring gives the exact quotient. The rest of a lap is less than the period.
+    */
+    for(h = 0; h < 2; h++)
+    {
+        partial[h] = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(period, 1) : _mm256_castsi256_si128(period));
+        left[h] = _mm256_sub_pd(_mm256_set1_pd((double) rounds),
+            _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(repeatedAt, 1) : _mm256_castsi256_si128(repeatedAt)));
+        laps[h] = _mm256_floor_pd(_mm256_div_pd(left[h], partial[h]));
+        halves[h] = _mm256_cvtpd_epi32(_mm256_sub_pd(left[h], _mm256_mul_pd(laps[h], partial[h])));
+    }
+    rest = _mm256_inserti128_si256(_mm256_castsi128_si256(halves[0]), halves[1], 1);
+
+    kIndex = _mm256_add_epi32(_mm256_slli_epi32(repeatedAt, 3), laneIndex);
+    startIndex = _mm256_add_epi32(_mm256_slli_epi32(start, 3), laneIndex);
+    restIndex = _mm256_add_epi32(startIndex, _mm256_slli_epi32(rest, 3));
+    for(s = 0; s < 2; s++)
+    {
+        const int* sums = (const int*) (s ? sumsB : sumsA);
+        __m256i gatheredK = _mm256_i32gather_epi32(sums, kIndex, 4);
+        __m256i gatheredStart = _mm256_i32gather_epi32(sums, startIndex, 4);
+        __m256i gatheredRest = _mm256_i32gather_epi32(sums, restIndex, 4);
+        /* The sums before the cycle fit in 32 bits, but the laps of it are added up in doubles. */
+        for(h = 0; h < 2; h++)
+        {
+            atK = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(gatheredK, 1) : _mm256_castsi256_si128(gatheredK));
+            atStart = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(gatheredStart, 1) : _mm256_castsi256_si128(gatheredStart));
+            atRest = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(gatheredRest, 1) : _mm256_castsi256_si128(gatheredRest));
+            _mm256_storeu_pd((s ? scoresB : scoresA) + h * 4, _mm256_add_pd(
+                _mm256_add_pd(atK, _mm256_mul_pd(laps[h], _mm256_sub_pd(atK, atStart))),
+                _mm256_sub_pd(atRest, atStart)));
+        }
     }
 }
+#endif
 
-static void Crossover(evo_Context* context,
-    void* parentA, void* parentB, void* childA, void* childB)
+/*
+    Plays the round robin in every lane at once, for lockstep mode.
+
+    The machines are first copied out lane by lane within each gene, like the fitnesses,
+    so with AVX2 each pairing is played in eight lanes straight from those arrays.
+    Inactive lanes play empty machines there, but their scores are thrown away,
+    so their fitnesses are never touched.
+*/
+static void LockstepGames(evo_Context** lanes, evo_uint laneCount, const evo_bool* active, double* fitnesses)
 {
-    evo_uint cp1, cp2, i;
-    PrisonerPlayer* pa = parentA;
-    PrisonerPlayer* pb = parentB;
-    PrisonerPlayer* ca = childA;
-    PrisonerPlayer* cb = childB;
-    
-    cp1 = evo_RandomInt(context, 0, OUTPUT_COUNT);
-    cp2 = evo_RandomInt(context, 0, OUTPUT_COUNT);
-    if(cp1 > cp2)
+    evo_uint i, j, l, n;
+    double payoffA, payoffB;
+#ifdef __AVX2__
+    evo_uint k, state, response;
+    evo_uint* transitions;
+    evo_uint* starts;
+    double scoresA[8], scoresB[8];
+    PrisonerPlayer* gene;
+#endif
+
+    n = evo_Context_GetPopulationSize(lanes[0]);
+#ifdef __AVX2__
+    transitions = calloc(n * laneCount * 2, sizeof(evo_uint));
+    starts = transitions + n * laneCount;
+    for(i = 0; i < n; i++)
+    {
+        for(l = 0; l < laneCount; l++)
+        {
+            if(active[l])
+            {
+                gene = lanes[l]->genes[i];
+                transitions[i * laneCount + l] = (evo_uint) gene->machine[0];
+                evo_Fsm_GetStart(&layout, gene->machine, &state, &response);
+                starts[i * laneCount + l] = state | (response << STATE_BITS);
+            }
+        }
+    }
+#endif
+    for(i = 0; i < n; i++)
+    {
+        for(j = i + 1; j < n; j++)
+        {
+            l = 0;
+#ifdef __AVX2__
+            for(; l + 8 <= laneCount; l += 8)
+            {
+                PlayGames8(transitions + i * laneCount + l, transitions + j * laneCount + l,
+                    starts + i * laneCount + l, starts + j * laneCount + l, MATCHES, scoresA, scoresB);
+                for(k = 0; k < 8; k++)
+                {
+                    if(active[l + k])
+                    {
+                        fitnesses[i * laneCount + l + k] += scoresA[k];
+                        fitnesses[j * laneCount + l + k] += scoresB[k];
+                    }
+                }
+            }
+#endif
+            for(; l < laneCount; l++)
+            {
+                if(active[l])
+                {
+                    PlayGame(lanes[l]->genes[i], lanes[l]->genes[j], MATCHES, &payoffA, &payoffB);
+                    fitnesses[i * laneCount + l] += payoffA;
+                    fitnesses[j * laneCount + l] += payoffB;
+                }
+            }
+        }
+    }
+#ifdef __AVX2__
+    free(transitions);
+#endif
+    /* Same as the round robin: the mean payoff per round, over every other gene. */
+    for(i = 0; i < n; i++)
+    {
+        for(l = 0; l < laneCount; l++)
+        {
+            if(active[l])
+            {
+                fitnesses[i * laneCount + l] = (n > 1) ? fitnesses[i * laneCount + l] / ((double) MATCHES * (n - 1)) : 0;
+            }
+        }
+    }
+}
+
+/*
+    Works out an ID for a player that is equal for two players exactly when they
+    respond the same way to every sequence of inputs.
+
+    Only states reachable from the initial state matter. Of those, states that respond
+    the same to every sequence are merged (partition refinement), and the merged states
+    are numbered in breadth-first order from the initial one. The ID packs the initial
+    response, the state count, and the (next state, response) of each state and input.
+*/
+static evo_uint64 CanonicalId(const PrisonerPlayer* player)
+{
+    evo_uint next[STATE_COUNT][ALPHABET_SIZE];
+    evo_uint output[STATE_COUNT][ALPHABET_SIZE];
+    evo_bool reachable[STATE_COUNT];
+    evo_uint queue[STATE_COUNT];
+    evo_uint block[STATE_COUNT], newBlock[STATE_COUNT];
+    evo_uint label[STATE_COUNT], representative[STATE_COUNT];
+    evo_uint s, t, x, head, tail, blocks, newBlocks, labels;
+    evo_uint initialState, initialResponse;
+    evo_bool same;
+    evo_uint64 id;
+
+    for(s = 0; s < STATE_COUNT; s++)
+    {
+        for(x = 0; x < ALPHABET_SIZE; x++)
+        {
+            next[s][x] = evo_Fsm_Step(&layout, player->machine, s, x, &output[s][x]);
+        }
+        reachable[s] = 0;
+    }
+    evo_Fsm_GetStart(&layout, player->machine, &initialState, &initialResponse);
+
+    /* Find the reachable states. */
+    head = tail = 0;
+    queue[tail++] = initialState;
+    reachable[initialState] = 1;
+    while(head < tail)
+    {
+        s = queue[head++];
+        for(x = 0; x < ALPHABET_SIZE; x++)
+        {
+            if(!reachable[next[s][x]])
+            {
+                reachable[next[s][x]] = 1;
+                queue[tail++] = next[s][x];
+            }
+        }
+    }
+
+    /*
+        Split states into blocks by their responses, then keep splitting blocks
+        whose states lead into different blocks, until nothing changes.
+    */
+    blocks = 0;
+    for(s = 0; s < STATE_COUNT; s++)
+    {
+        block[s] = STATE_COUNT;
+    }
+    for(s = 0; s < STATE_COUNT; s++)
+    {
+        if(!reachable[s] || block[s] != STATE_COUNT)
+        {
+            continue;
+        }
+        block[s] = blocks;
+        for(t = s + 1; t < STATE_COUNT; t++)
+        {
+            if(reachable[t] && block[t] == STATE_COUNT)
+            {
+                same = 1;
+                for(x = 0; x < ALPHABET_SIZE; x++)
+                {
+                    same = same && output[s][x] == output[t][x];
+                }
+                if(same)
+                {
+                    block[t] = blocks;
+                }
+            }
+        }
+        blocks++;
+    }
+    for(;;)
     {
-        i = cp1;
-        cp1 = cp2;
-        cp2 = i;
+        newBlocks = 0;
+        for(s = 0; s < STATE_COUNT; s++)
+        {
+            newBlock[s] = STATE_COUNT;
+        }
+        for(s = 0; s < STATE_COUNT; s++)
+        {
+            if(!reachable[s] || newBlock[s] != STATE_COUNT)
+            {
+                continue;
+            }
+            newBlock[s] = newBlocks;
+            for(t = s + 1; t < STATE_COUNT; t++)
+            {
+                if(reachable[t] && newBlock[t] == STATE_COUNT && block[t] == block[s])
+                {
+                    same = 1;
+                    for(x = 0; x < ALPHABET_SIZE; x++)
+                    {
+                        same = same && block[next[s][x]] == block[next[t][x]];
+                    }
+                    if(same)
+                    {
+                        newBlock[t] = newBlocks;
+                    }
+                }
+            }
+            newBlocks++;
+        }
+        memcpy(block, newBlock, sizeof(block));
+        if(newBlocks == blocks)
+        {
+            break;
+        }
+        blocks = newBlocks;
     }
 
-    ca->initialState = pa->initialState;
-    cb->initialState = pb->initialState;
-    ca->initialResponse = pa->initialResponse;
-    cb->initialResponse = pb->initialResponse;
+    /* Number the blocks in breadth-first order, remembering a state from each. */
+    for(s = 0; s < STATE_COUNT; s++)
+    {
+        label[s] = STATE_COUNT;
+    }
+    labels = 0;
+    label[block[initialState]] = labels;
+    representative[labels++] = initialState;
+    for(head = 0; head < labels; head++)
+    {
+        s = representative[head];
+        for(x = 0; x < ALPHABET_SIZE; x++)
+        {
+            if(label[block[next[s][x]]] == STATE_COUNT)
+            {
+                label[block[next[s][x]]] = labels;
+                representative[labels++] = next[s][x];
+            }
+        }
+    }
 
-    for(i = 0; i < cp1; i++)
+    /* Pack it up. There is always at least one state, so the ID is never 0. */
+    id = initialResponse;
+    id = (id << 3) | labels;
+    for(head = 0; head < labels; head++)
     {
-        ca->nextStates[i] = pa->nextStates[i];
-        cb->nextStates[i] = pb->nextStates[i];
-        ca->responses[i] = pa->responses[i];
-        cb->responses[i] = pb->responses[i];
+        s = representative[head];
+        for(x = 0; x < ALPHABET_SIZE; x++)
+        {
+            id = (id << STATE_BITS) | label[block[next[s][x]]];
+            id = (id << 1) | output[s][x];
+        }
     }
-    for(i = cp1; i < cp2; i++)
+    return id;
+}
+
+/*
+    Plays a game between two players, for the round robin.
+    Payoffs are averaged per round, so the fitness doesn't depend on the game length.
+
+    Games between players whose canonical forms have met before are looked up instead.
+*/
+static void Game(evo_Context* context, void* geneA, void* geneB, double* payoffA, double* payoffB)
+{
+    PrisonerPlayer* a = geneA;
+    PrisonerPlayer* b = geneB;
+
+    if(payoffCache)
     {
-        ca->nextStates[i] = pb->nextStates[i];
-        cb->nextStates[i] = pa->nextStates[i];
-        ca->responses[i] = pb->responses[i];
-        cb->responses[i] = pa->responses[i];
+        if(!a->canonicalId)
+        {
+            a->canonicalId = CanonicalId(a);
+        }
+        if(!b->canonicalId)
+        {
+            b->canonicalId = CanonicalId(b);
+        }
+        if(evo_PayoffCache_Find(payoffCache, a->canonicalId, b->canonicalId, payoffA, payoffB))
+        {
+            return;
+        }
     }
-    for(i = cp2; i < OUTPUT_COUNT; i++)
+
+    PlayGame(a, b, MATCHES, payoffA, payoffB);
+    *payoffA /= MATCHES;
+    *payoffB /= MATCHES;
+
+    if(payoffCache)
     {
-        ca->nextStates[i] = pa->nextStates[i];
-        cb->nextStates[i] = pb->nextStates[i];
-        ca->responses[i] = pa->responses[i];
-        cb->responses[i] = pb->responses[i];
+        evo_PayoffCache_Insert(payoffCache, a->canonicalId, b->canonicalId, *payoffA, *payoffB);
     }
 }
 
+static void Crossover(evo_Context* context,
+    void* parentA, void* parentB, void* childA, void* childB)
+{
+    PrisonerPlayer* pa = parentA;
+    PrisonerPlayer* pb = parentB;
+    PrisonerPlayer* ca = childA;
+    PrisonerPlayer* cb = childB;
+
+    evo_Fsm_Crossover(context, &layout, pa->machine, pb->machine, ca->machine, cb->machine);
+    ca->canonicalId = 0;
+    cb->canonicalId = 0;
+}
+
 static void Mutation(evo_Context* context, void* d)
 {
     PrisonerPlayer* gene = d;
-    evo_uint i;
-    switch(evo_RandomInt(context, 0, 4))
-    {
-        case 0:
-            gene->initialState = evo_RandomInt(context, 0, STATE_COUNT);
-            break;
-        case 1:
-            gene->initialResponse = evo_RandomInt(context, 0, ALPHABET_SIZE);
-            break;
-        case 2:
-            i = evo_RandomInt(context, 0, OUTPUT_COUNT);
-            gene->nextStates[i] = evo_RandomInt(context, 0, STATE_COUNT);
-            break;
-        case 3:
-            i = evo_RandomInt(context, 0, OUTPUT_COUNT);
-            gene->responses[i] = evo_RandomInt(context, 0, ALPHABET_SIZE);
-            break;
-    }
+    evo_Fsm_Mutate(context, &layout, gene->machine);
+    gene->canonicalId = 0;
 }
 
 static evo_bool Success(evo_Context* context)
@@ -245,29 +665,87 @@ TEST(prisoner)
 {
     double t;
     evo_Stats* stats;
+    const char* mode = "roundrobin";
 	evo_Config* config = evo_Config_New();
 
     if(argc < 3)
     {
         fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by rounds per game, competition mode"
+            " (roundrobin, sampled, hall, swiss, lockstep), population size, and lanes per unit.\n");
         return -1;
     }
     THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        MATCHES = (evo_uint) strtoul(argv[3], NULL, 10);
+    }
+    if(argc > 4)
+    {
+        mode = argv[4];
+    }
+    if(argc > 5)
+    {
+        POPULATION = atoi(argv[5]);
+    }
+    if(argc > 6)
+    {
+        LANES = atoi(argv[6]);
+    }
+    else if(!strcmp(mode, "lockstep"))
+    {
+        LANES = 8;
+    }
+
+    evo_FsmLayout_Init(&layout, STATE_COUNT, ALPHABET_SIZE, ALPHABET_SIZE);
+    if(layout.wordCount > MACHINE_WORDS)
+    {
+        fprintf(stderr, "Machines need %u words, but players only have room for %u.\n", layout.wordCount, MACHINE_WORDS);
+        return -1;
+    }
+    if(layout.entryShift != ENTRY_SHIFT || layout.stateBits != STATE_BITS)
+    {
+        fprintf(stderr, "Machines are packed differently than Step expects.\n");
+        return -1;
+    }
 
     evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
     evo_Config_SetRandomStreamCount(config, 48);
     evo_Config_SetTrials(config, TRIALS);
     evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
     evo_Config_SetPopulationSize(config, POPULATION);
+    evo_Config_SetLaneCount(config, LANES);
 
     evo_Config_SetPopulationInitializer(config, Initializer);
     evo_Config_SetPopulationFinalizer(config, Finalizer);
-    evo_Config_SetFitnessOperator(config, RoundRobin);
+    if(!strcmp(mode, "sampled"))
+    {
+        evo_UseSampledCompetition(config, Game, POPULATION, OPPONENTS);
+    }
+    else if(!strcmp(mode, "hall"))
+    {
+        evo_UseHallOfFameCompetition(config, Game, POPULATION, OPPONENTS, HALL_OF_FAME_SIZE, sizeof(PrisonerPlayer));
+    }
+    else if(!strcmp(mode, "swiss"))
+    {
+        evo_UseSwissCompetition(config, Game, POPULATION, SWISS_ROUNDS);
+    }
+    else if(!strcmp(mode, "lockstep"))
+    {
+        evo_Config_SetBatchFitness(config, LockstepGames);
+    }
+    else
+    {
+        evo_Config_SetPairwiseFitness(config, Game);
+    }
     evo_UseTournamentSelection(config, POPULATION, 4);
     evo_Config_SetCrossoverOperator(config, Crossover);
     evo_Config_SetMutationOperator(config, Mutation);
     evo_Config_SetSuccessPredicate(config, Success);
 
+    payoffCache = evo_PayoffCache_New(PAYOFF_CACHE_SIZE);
+
     StartTime();
     evo_Config_Execute(config);
     if(!evo_Config_IsUsed(config))
@@ -279,7 +757,11 @@ TEST(prisoner)
     t = EndTime();
 
     stats = evo_Config_GetStats(config);
-    printf("%d threads took %lf seconds to generate prisoner's dilemma state machine files.\n", THREADS, t);
+    RecordStats(config);
+    evo_PayoffCache_Free(payoffCache);
+    payoffCache = NULL;
+    printf("%d threads took %lf seconds to generate prisoner's dilemma state machine files (%u rounds per game, %s, population %u, %u lanes).\n",
+        THREADS, t, MATCHES, mode, POPULATION, LANES);
 
 	evo_Config_Free(config);
 	return 0;
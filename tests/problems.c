@@ -0,0 +1,182 @@
+#include <evo_select_tournament.h>
+#include <evo_problem_onemax.h>
+#include <evo_problem_nk.h>
+#include <evo_problem_real.h>
+#include <evo_problem_knapsack.h>
+#include <evo_problem_tsp.h>
+#include <evo_problem_maxsat.h>
+#include "tests.h"
+
+/*
+    Runs the problems library's benchmarks, at one size each, and reports how long
+    they take to solve. The fitness costs and genome sizes vary a lot between them,
+    so a change to the engine can be judged across all of them at once.
+    Reference numbers are kept in results_problems_rls.txt.
+*/
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+#define TRIALS 48
+#define INSTANCE_SEED 1
+
+typedef struct
+{
+    const char* name;
+    const char* description;
+    void (*setup)(evo_Config* config, evo_uint populationSize);
+    evo_uint populationSize;
+    evo_uint maxIterations;
+} Problem;
+
+static void OneMax(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseOneMax(config, populationSize, 1024, 0);
+}
+
+static void Trap(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseTrap(config, populationSize, 60, 4);
+}
+
+static void Nk(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseNkLandscape(config, populationSize, 48, 3, INSTANCE_SEED);
+}
+
+static void Rastrigin(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseRastrigin(config, populationSize, 10, 1e-2);
+}
+
+static void Rosenbrock(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseRosenbrock(config, populationSize, 4, 1e-2);
+}
+
+static void Knapsack(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseKnapsack(config, populationSize, 500, INSTANCE_SEED);
+}
+
+static void Tsp(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseTsp(config, populationSize, 48, 16, EVO_TSP_PMX, INSTANCE_SEED);
+}
+
+static void MaxSat(evo_Config* config, evo_uint populationSize)
+{
+    evo_UseMaxSat(config, populationSize, 100, 400, INSTANCE_SEED);
+}
+
+static const Problem problemList[] = {
+    {"onemax", "1024 bits", OneMax, 1000, 1000},
+    {"trap", "15 traps of 4 bits", Trap, 1000, 1000},
+    {"nk", "n = 48, k = 3", Nk, 1000, 1000},
+    {"rastrigin", "10 dimensions", Rastrigin, 1000, 1000},
+    {"rosenbrock", "4 dimensions", Rosenbrock, 1000, 1000},
+    {"knapsack", "500 items", Knapsack, 1000, 1000},
+    {"tsp", "48 cities", Tsp, 500, 1000},
+    {"maxsat", "100 variables, 400 clauses", MaxSat, 1000, 1000},
+    {NULL, NULL, NULL, 0, 0}
+};
+
+/* Runs one problem, and prints a line of the summary. Returns false if the config couldn't be used. */
+static evo_bool RunProblem(const Problem* problem)
+{
+    double t;
+    evo_Stats* stats;
+    evo_Config* config;
+
+    config = evo_Config_New();
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, 48);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, problem->maxIterations);
+    evo_Config_SetPopulationSize(config, problem->populationSize);
+    evo_UseTournamentSelection(config, problem->populationSize, 4);
+    problem->setup(config, problem->populationSize);
+
+    StartTime();
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        evo_Config_Free(config);
+        return EVO_FALSE;
+    }
+    t = EndTime();
+
+    stats = evo_Config_GetStats(config);
+    RecordStats(config);
+    printf("%-12s %-28s %9u/%-3u %12.1f %10.3f %14.4f\n", problem->name, problem->description,
+        stats->trials - stats->failures, stats->trials, stats->sumIterations / stats->trials, t,
+        stats->trials > stats->failures ? t / (stats->trials - stats->failures) : 0.0);
+    fflush(stdout);
+
+    evo_Config_Free(config);
+    return EVO_TRUE;
+}
+
+/* Adds one problem's run to the suite's. */
+static void AddRun(RunRecord* total, const RunRecord* run)
+{
+    evo_uint p, c;
+
+    total->wallTime += run->wallTime;
+    total->cpuTime += run->cpuTime;
+    total->trials += run->trials;
+    total->failures += run->failures;
+    total->evaluations += run->evaluations;
+    for(p = 0; p < EVO_TIMER_COUNT; p++)
+    {
+        total->phaseTime[p] += run->phaseTime[p];
+        for(c = 0; c < EVO_COUNTER_COUNT; c++)
+        {
+            total->phaseCounters[p][c] += run->phaseCounters[p][c];
+        }
+    }
+    if(run->perfUnits > total->perfUnits)
+    {
+        total->perfUnits = run->perfUnits;
+    }
+}
+
+TEST(problems)
+{
+    evo_uint i;
+    const char* only = NULL;
+    RunRecord total;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by one problem to run.\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3 && strcmp(argv[3], "all"))
+    {
+        only = argv[3];
+    }
+
+    printf("%-12s %-28s %13s %12s %10s %14s\n", "problem", "size", "solved", "iterations", "seconds", "s/solution");
+    memset(&total, 0, sizeof(RunRecord));
+    for(i = 0; problemList[i].name; i++)
+    {
+        if(only && strcmp(only, problemList[i].name))
+        {
+            continue;
+        }
+        if(!RunProblem(&problemList[i]))
+        {
+            fprintf(stderr, "Could not use the config for %s.\n", problemList[i].name);
+            return 0;
+        }
+        AddRun(&total, &lastRun);
+    }
+    /* evo-bench measures the whole suite, not just the last problem. */
+    lastRun = total;
+    printf("%d threads took %lf seconds to run the problems.\n", THREADS, total.wallTime);
+    return 0;
+}
@@ -1,22 +1,80 @@
 #include <evo_select_tournament.h>
+#include <evo_bits.h>
 #include "tests.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 /*#define THREADS 16*/
 
 static int THREADS = 0;
-#define TRIALS 768
-#define MAX_ITERATIONS 1000
-#define POPULATION 1000
+/* Trials are split evenly between the random streams, so they have to come in multiples of this. */
+#define RANDOM_STREAMS 48
+/* These can all be overridden on the command line. */
+static evo_uint TRIALS = 768;
+static evo_uint MAX_ITERATIONS = 1000;
+static evo_uint POPULATION = 1000;
 
-#define BOARD_WIDTH 6
-#define BOARD_HEIGHT 6
-#define GENE_SIZE 42
+/* Boards can be from 2 to MAX_BOARD_SIDE cells on a side. */
+#define MAX_BOARD_SIDE 128
+static evo_uint BOARD_WIDTH = 6;
+static evo_uint BOARD_HEIGHT = 6;
+static evo_uint BOARD_SIZE;
+/* A walk gets a sixth more moves than there are cells (42 on the 6x6 board). */
+static evo_uint GENE_SIZE;
+
+/*
+    Each move is packed into 2 bits, 32 moves to a word.
+    Move codes are 0 = up, 1 = down, 2 = left, 3 = right.
+*/
+#define MOVES_PER_WORD 32
+static evo_uint GENE_WORDS;
+
+/*
+    The visited cells are kept in a bitboard, of BOARD_WORDS words.
+    Boards of up to 64 cells fit in one word, which is kept in a register
+    (and in vector lanes, with AVX2). Bigger boards keep theirs in memory, one per unit.
+*/
+static evo_uint BOARD_WORDS;
+
+/*
+    For each (cell, move) pair, the cell that the move ends up in.
+    Moves into a wall leave the walker where it is.
+    Indexed by cell * 4 + move, so a step is a single table lookup.
+    The table grows with the board, to 512KB at 128x128.
+*/
+static evo_uint64* moveTable = NULL;
+
+static void BuildMoveTable()
+{
+    evo_uint x, y, cell;
+    moveTable = malloc(sizeof(evo_uint64) * BOARD_SIZE * 4);
+    for(y = 0; y < BOARD_HEIGHT; y++)
+    {
+        for(x = 0; x < BOARD_WIDTH; x++)
+        {
+            cell = y * BOARD_WIDTH + x;
+            moveTable[cell * 4 + 0] = (y > 0) ? cell - BOARD_WIDTH : cell;
+            moveTable[cell * 4 + 1] = (y < BOARD_HEIGHT - 1) ? cell + BOARD_WIDTH : cell;
+            moveTable[cell * 4 + 2] = (x > 0) ? cell - 1 : cell;
+            moveTable[cell * 4 + 3] = (x < BOARD_WIDTH - 1) ? cell + 1 : cell;
+        }
+    }
+}
+
+/* Overwrites the move at position i. */
+static void SetMove(evo_uint64* gene, evo_uint i, evo_uint move)
+{
+    evo_uint shift = (i % MOVES_PER_WORD) * 2;
+    gene[i / MOVES_PER_WORD] = (gene[i / MOVES_PER_WORD] & ~(((evo_uint64) 3) << shift))
+        | (((evo_uint64) move) << shift);
+}
 
 static evo_bool Initializer(evo_Context* context)
 {
     evo_uint populationSize;
     evo_uint i, j;
-    char* gene;
+    evo_uint64* gene;
 
     populationSize = evo_Context_GetPopulationSize(context);
     if(!context->genes)
@@ -24,24 +82,18 @@ static evo_bool Initializer(evo_Context* context)
         context->genes = malloc(sizeof(void*) * populationSize);
         for(i = 0; i < populationSize; i++)
         {
-            gene = (char*) malloc(sizeof(char) * (GENE_SIZE + 1));
+            gene = (evo_uint64*) malloc(sizeof(evo_uint64) * GENE_WORDS);
             context->genes[i] = gene;
         }
     }
     for(i = 0; i < populationSize; i++)
     {
         gene = context->genes[i];
+        memset(gene, 0, sizeof(evo_uint64) * GENE_WORDS);
         for(j = 0; j < GENE_SIZE; j++)
         {
-            switch(evo_RandomInt(context, 0, 4))
-            {
-                case 0: gene[j] = 'U'; break;
-                case 1: gene[j] = 'D'; break;
-                case 2: gene[j] = 'L'; break;
-                case 3: gene[j] = 'R'; break;
-            }
+            SetMove(gene, j, evo_RandomInt(context, 0, 4));
         }
-        gene[GENE_SIZE] = 0;
     }
     
     return 1;
@@ -60,69 +112,138 @@ static void Finalizer(evo_Context* context)
     return;
 }
 
-static double IndividualFitness(char* gene)
+/* Gives each unit its own board, for boards too big for a word. */
+static void BoardStart(evo_Context* context, void* param)
 {
-    double fitness;
-    evo_uint x, y, i;
-    evo_bool board[BOARD_WIDTH * BOARD_HEIGHT];
+    context->fitnessUserData = malloc(sizeof(evo_uint64) * BOARD_WORDS);
+}
 
-    x = y = 0;
-    fitness = 0.0;
-    memset(board, 0, sizeof(evo_bool) * BOARD_WIDTH * BOARD_HEIGHT);
-    
-    board[0] = 1;
+static void BoardEnd(evo_Context* context, void* param)
+{
+    free(context->fitnessUserData);
+}
+
+static double IndividualFitness(const evo_uint64* gene)
+{
+    evo_uint i;
+    evo_uint64 word, cell, board;
+
+    /* Start in the top-left corner, which counts as covered. */
+    cell = 0;
+    board = 1;
+    word = gene[0];
     /* Move through the board. */
     for(i = 0; i < GENE_SIZE; i++)
     {
-        /* Parse move string. */
-        switch(gene[i])
+        if(i % MOVES_PER_WORD == 0)
         {
-            case 'U':
-                if(y > 0)
-                {
-                    y--;
-                }
-                break;
-            case 'D':
-                if(y < BOARD_HEIGHT - 1)
-                {
-                    y++;
-                }
-                break;
-            case 'L':
-                if(x > 0)
-                {
-                    x--;
-                }
-                break;
-            case 'R':
-                if(x < BOARD_WIDTH - 1)
-                {
-                    x++;
-                }
-                break;
+            word = gene[i / MOVES_PER_WORD];
         }
+        cell = moveTable[(cell << 2) | (word & 3)];
+        word >>= 2;
         /* Mark this spot. */
-        board[y * BOARD_WIDTH + x] = 1;
+        board |= ((evo_uint64) 1) << cell;
     }
 
     /* Reward one point for each space covered. */
-    for(i = 0; i < BOARD_WIDTH * BOARD_HEIGHT; i++)
+    return evo_PopCount64(board);
+}
+
+/* The same walk, on a board of many words. Cells are counted as they're first covered. */
+static double BoardFitness(const evo_uint64* gene, evo_uint64* board)
+{
+    evo_uint i, covered;
+    evo_uint64 word, cell, bit;
+
+    memset(board, 0, sizeof(evo_uint64) * BOARD_WORDS);
+    cell = 0;
+    board[0] = 1;
+    covered = 1;
+    word = gene[0];
+    for(i = 0; i < GENE_SIZE; i++)
+    {
+        if(i % MOVES_PER_WORD == 0)
+        {
+            word = gene[i / MOVES_PER_WORD];
+        }
+        cell = moveTable[(cell << 2) | (word & 3)];
+        word >>= 2;
+        bit = ((evo_uint64) 1) << (cell & 63);
+        covered += !(board[cell >> 6] & bit);
+        board[cell >> 6] |= bit;
+    }
+    return covered;
+}
+
+#ifdef __AVX2__
+/*
+    Evaluates 8 genes at once, one gene per 64-bit lane, in two registers of 4 lanes.
+    Each step is a gather from the move table and a variable shift into the board.
+*/
+static void IndividualFitness8(void** genes, double* fitnesses)
+{
+    evo_uint i, j;
+    const evo_uint64* g[8];
+    __m256i wordA, wordB, cellA, cellB, boardA, boardB;
+    const __m256i three = _mm256_set1_epi64x(3);
+    const __m256i one = _mm256_set1_epi64x(1);
+    evo_uint64 boards[8];
+
+    for(j = 0; j < 8; j++)
+    {
+        g[j] = genes[j];
+    }
+    cellA = cellB = _mm256_setzero_si256();
+    boardA = boardB = one;
+    wordA = wordB = _mm256_setzero_si256();
+    for(i = 0; i < GENE_SIZE; i++)
     {
-        if(board[i])
+        if(i % MOVES_PER_WORD == 0)
         {
-            fitness++;
+            j = i / MOVES_PER_WORD;
+            wordA = _mm256_set_epi64x(g[3][j], g[2][j], g[1][j], g[0][j]);
+            wordB = _mm256_set_epi64x(g[7][j], g[6][j], g[5][j], g[4][j]);
         }
+        cellA = _mm256_i64gather_epi64((const long long*) moveTable,
+            _mm256_or_si256(_mm256_slli_epi64(cellA, 2), _mm256_and_si256(wordA, three)), 8);
+        cellB = _mm256_i64gather_epi64((const long long*) moveTable,
+            _mm256_or_si256(_mm256_slli_epi64(cellB, 2), _mm256_and_si256(wordB, three)), 8);
+        wordA = _mm256_srli_epi64(wordA, 2);
+        wordB = _mm256_srli_epi64(wordB, 2);
+        boardA = _mm256_or_si256(boardA, _mm256_sllv_epi64(one, cellA));
+        boardB = _mm256_or_si256(boardB, _mm256_sllv_epi64(one, cellB));
+    }
+
+    _mm256_storeu_si256((__m256i*) boards, boardA);
+    _mm256_storeu_si256((__m256i*) (boards + 4), boardB);
+    for(j = 0; j < 8; j++)
+    {
+        fitnesses[j] = evo_PopCount64(boards[j]);
     }
-    return fitness;
 }
+#endif
 
 static void PopulationFitness(evo_Context* context)
 {
-    evo_uint i;
-    for(i = 0; i < evo_Context_GetPopulationSize(context); i++)
+    evo_uint i = 0;
+    evo_uint populationSize = evo_Context_GetPopulationSize(context);
+    if(BOARD_WORDS > 1)
+    {
+        for(; i < populationSize; i++)
+        {
+            context->fitnesses[i] = BoardFitness((const evo_uint64*) context->genes[i], context->fitnessUserData);
+        }
+        return;
+    }
+#ifdef __AVX2__
+    for(; i + 8 <= populationSize; i += 8)
     {
-        context->fitnesses[i] = IndividualFitness((char*) (context->genes[i]));
+        IndividualFitness8(context->genes + i, context->fitnesses + i);
+    }
+#endif
+    for(; i < populationSize; i++)
+    {
+        context->fitnesses[i] = IndividualFitness((const evo_uint64*) (context->genes[i]));
     }
 }
 
@@ -131,10 +252,11 @@ static void Crossover(evo_Context* context,
     void* parentA, void* parentB, void* childA, void* childB)
 {
     evo_uint cp1, cp2, i;
-    char* pa = parentA;
-    char* pb = parentB;
-    char* ca = childA;
-    char* cb = childB;
+    evo_uint64 swap;
+    evo_uint64* pa = parentA;
+    evo_uint64* pb = parentB;
+    evo_uint64* ca = childA;
+    evo_uint64* cb = childB;
     
     cp1 = evo_RandomInt(context, 0, GENE_SIZE);
     cp2 = evo_RandomInt(context, 0, GENE_SIZE);
@@ -145,62 +267,90 @@ static void Crossover(evo_Context* context,
         cp2 = i;
     }
 
-    for(i = 0; i < cp1; i++)
+    /* Moves in [cp1, cp2) come from the other parent. */
+    for(i = 0; i < GENE_WORDS; i++)
     {
-        ca[i] = pa[i];
-        cb[i] = pb[i];
-    }
-    for(i = cp1; i < cp2; i++)
-    {
-        ca[i] = pb[i];
-        cb[i] = pa[i];
-    }
-    for(i = cp2; i < GENE_SIZE; i++)
-    {
-        ca[i] = pa[i];
-        cb[i] = pb[i];
+        swap = (pa[i] ^ pb[i]) & evo_BitRangeMask(i, cp1 * 2, cp2 * 2);
+        ca[i] = pa[i] ^ swap;
+        cb[i] = pb[i] ^ swap;
     }
 }
 
 static void Mutation(evo_Context* context, void* d)
 {
-    char* gene = d;
+    evo_uint64* gene = d;
     evo_uint i;
     evo_uint count = evo_RandomInt(context, 0, 5) + 1;
     while(count)
     {
         count--;
         i = evo_RandomInt(context, 0, GENE_SIZE);
-        switch(evo_RandomInt(context, 0, 4))
-        {
-            case 0: gene[i] = 'U'; break;
-            case 1: gene[i] = 'D'; break;
-            case 2: gene[i] = 'L'; break;
-            case 3: gene[i] = 'R'; break;
-        }
+        SetMove(gene, i, evo_RandomInt(context, 0, 4));
     }
 }
 
 static evo_bool Success(evo_Context* context)
 {
-    return context->bestFitness == BOARD_WIDTH * BOARD_HEIGHT;
+    return context->bestFitness == BOARD_SIZE;
 }
 
 TEST(self_avoiding_walk)
 {
-    double t;
+    double t, generations;
     evo_Stats* stats;
-	evo_Config* config = evo_Config_New();
+	evo_Config* config;
 
     if(argc < 3)
     {
         fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by the board width and height, the population size,\n");
+        fprintf(stderr, "the number of trials (a multiple of %d), and the most iterations per trial.\n", RANDOM_STREAMS);
         return -1;
     }
     THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        BOARD_WIDTH = atoi(argv[3]);
+        BOARD_HEIGHT = argc > 4 ? atoi(argv[4]) : BOARD_WIDTH;
+    }
+    if(argc > 5)
+    {
+        POPULATION = atoi(argv[5]);
+    }
+    if(argc > 6)
+    {
+        TRIALS = atoi(argv[6]);
+    }
+    if(argc > 7)
+    {
+        MAX_ITERATIONS = atoi(argv[7]);
+    }
+    if(BOARD_WIDTH < 2 || BOARD_HEIGHT < 2 || BOARD_WIDTH > MAX_BOARD_SIDE || BOARD_HEIGHT > MAX_BOARD_SIDE)
+    {
+        fprintf(stderr, "The board must be from 2 to %d cells on a side.\n", MAX_BOARD_SIDE);
+        return -1;
+    }
+    if(POPULATION < 4 || POPULATION % 4)
+    {
+        fprintf(stderr, "The population size must be a multiple of 4.\n");
+        return -1;
+    }
+    if(TRIALS == 0 || TRIALS % RANDOM_STREAMS)
+    {
+        fprintf(stderr, "The number of trials must be a positive multiple of %d.\n", RANDOM_STREAMS);
+        return -1;
+    }
+    BOARD_SIZE = BOARD_WIDTH * BOARD_HEIGHT;
+    GENE_SIZE = (BOARD_SIZE * 7 + 5) / 6;
+    GENE_WORDS = (GENE_SIZE + MOVES_PER_WORD - 1) / MOVES_PER_WORD;
+    BOARD_WORDS = (BOARD_SIZE + 63) / 64;
+    BuildMoveTable();
+
+    config = evo_Config_New();
 
     evo_Config_SetUnitCount(config, THREADS);
-    evo_Config_SetRandomStreamCount(config, 48);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, RANDOM_STREAMS);
     evo_Config_SetTrials(config, TRIALS);
     evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
     evo_Config_SetPopulationSize(config, POPULATION);
@@ -214,23 +364,37 @@ TEST(self_avoiding_walk)
     evo_Config_SetCrossoverOperator(config, Crossover);
     evo_Config_SetMutationOperator(config, Mutation);
     evo_Config_SetSuccessPredicate(config, Success);
+    if(BOARD_WORDS > 1)
+    {
+        evo_Config_AddContextStartCallback(config, BoardStart, NULL);
+        evo_Config_AddContextEndCallback(config, BoardEnd, NULL);
+    }
 
     StartTime();
     evo_Config_Execute(config);
     if(!evo_Config_IsUsed(config))
     {
         fprintf(stderr, "Could not use the given config.\n");
+        evo_Config_Free(config);
+        free(moveTable);
         return 0;
     }
 
     t = EndTime();
 
     stats = evo_Config_GetStats(config);
+    RecordStats(config);
     printf("\n", stats->failures, stats->trials);
     printf("Failures %u/%u\n", stats->failures, stats->trials);
     printf("Best fitness %lf\n", stats->bestFitness, stats->trials);
     printf("%d threads took %lf seconds to generate self-avoiding walk statistics.\n", THREADS, t);
+    /* Every iteration evaluates the whole population, including the last one of a successful trial. */
+    generations = stats->sumIterations + (stats->trials - stats->failures);
+    printf("%u x %u board, %u moves, population %u: %.1f generations/s, %.0f genes/s, %.0f moves/s.\n",
+        BOARD_WIDTH, BOARD_HEIGHT, GENE_SIZE, POPULATION,
+        generations / t, generations * POPULATION / t, generations * POPULATION * GENE_SIZE / t);
 
 	evo_Config_Free(config);
+    free(moveTable);
 	return 0;
 }
\ No newline at end of file
@@ -1,61 +1,61 @@
 #include <string.h>
-#include <time.h>
 #include "tests.h"
 
-// Helper function, don't call directly
-double TimeHelper(int reset)
-{
-	static clock_t start = 0.0;
-	if (reset)
-	{
-		start = clock();
-		return 0.0;
-	}
-	return (double)(clock() - start)/CLOCKS_PER_SEC;
-}
-
-// StartTime resets timer
-// EndTime returns no. of seconds of CPU time since StartTime
-void StartTime()
-{
-	TimeHelper(1); // reset timer
-}
-
-double EndTime()
-{
-	return TimeHelper( 0 );
-}
-
 int main(int argc, char** argv)
 {
-    static const TestData testList[] = {
-        {"saw", self_avoiding_walk},
-        {"prisoner", prisoner},
-        {NULL, NULL},
-    };
-
+    const TestData* test;
     int i = 0;
+    int level;
+    /* Options come before the test name, so the tests' own arguments stay where they are. */
+    while(argc > 2 && (!strcmp(argv[1], "--trace") || !strcmp(argv[1], "--progress") || !strcmp(argv[1], "--log")))
+    {
+        if(!strcmp(argv[1], "--trace"))
+        {
+            traceFile = argv[2];
+        }
+        else if(!strcmp(argv[1], "--progress"))
+        {
+            progressName = argv[2];
+        }
+        else
+        {
+            level = EVO_LOG_SILENT;
+            while(level < EVO_LOG_LEVEL_COUNT && strcmp(argv[2], evo_LogLevelName((evo_LogLevel) level)))
+            {
+                level++;
+            }
+            if(level == EVO_LOG_LEVEL_COUNT)
+            {
+                fprintf(stderr, "Unknown log level '%s'.\n", argv[2]);
+                return -1;
+            }
+            logLevel = (evo_LogLevel) level;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
     if(argc < 2)
     {
-        fprintf(stderr, "Usage:\n    %s TEST\n", argv[0]);
+        fprintf(stderr, "Usage:\n    %s [--trace FILE] [--progress NAME] [--log LEVEL] TEST\n", argv[0]);
         fprintf(stderr, "\n    Where test is one of:\n", argv[0]);
         while(testList[i].name && testList[i].cb)
         {
             fprintf(stderr, "        %s\n", testList[i].name);
             i++;
         }
+        fprintf(stderr, "\n    --trace FILE writes a Chrome trace of the test's last run to FILE.\n");
+        fprintf(stderr, "    --progress NAME publishes progress to a page that evo-top NAME can watch.\n");
+        fprintf(stderr, "    --log LEVEL logs silent, error, warning, info (the default) or debug records.\n");
         fprintf(stderr, "\n");
         return -1;
     }
-    while(testList[i].name && testList[i].cb)
+    test = FindTest(argv[1]);
+    if(test)
     {
-        if(!strcmp(testList[i].name, argv[1]))
-        {
-            printf("Running test '%s'\n", argv[1]);
-            return testList[i].cb(argc, argv);
-        }
-        i++;
+        printf("Running test '%s'\n", argv[1]);
+        return test->cb(argc, argv);
     }
     fprintf(stderr, "Failed to find test '%s'\n", argv[1]);
     return -1;
-}
\ No newline at end of file
+}
@@ -6,14 +6,37 @@
 #include <string.h>
 #include <evo_api.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define TEST(func) \
     int func(int argc, char** argv)
 
+/* Starts timing a run. */
 void StartTime();
+/* Returns the seconds of wall time since StartTime. */
 double EndTime();
+/* Keeps the stats of a finished run, for evo-bench. */
+void RecordStats(evo_Config* config);
+/* Has the config write a trace, publish its progress, and log at the level the runner was asked to. */
+void UseRunOptions(evo_Config* config);
+/* Where the runner was asked to write a trace, or NULL. */
+extern const char* traceFile;
+/* The name of the progress page the runner was asked to publish to, or NULL. */
+extern const char* progressName;
+/* How much the runner was asked to log. */
+extern evo_LogLevel logLevel;
 
 TEST(self_avoiding_walk);
 TEST(prisoner);
+TEST(fsm);
+TEST(onemax);
+TEST(tsp);
+TEST(engine);
+TEST(micro);
+TEST(problems);
+TEST(lanes);
 
 typedef struct 
 {
@@ -21,4 +44,31 @@ typedef struct
     int (*cb)(int, char**);
 } TestData;
 
+/* Every test, ended by one with a NULL name. */
+extern const TestData testList[];
+/* Returns the test with the given name, or NULL if there isn't one. */
+const TestData* FindTest(const char* name);
+
+/* What the last run measured, set by EndTime and RecordStats. */
+typedef struct
+{
+    /* Seconds of wall time between StartTime and EndTime. */
+    double wallTime;
+    /* Seconds of CPU time used by the units. */
+    double cpuTime;
+    evo_uint trials;
+    evo_uint failures;
+    /* Fitness evaluations done by the library's loop. */
+    double evaluations;
+    /* Per-phase times and hardware counters, when the library measures them. */
+    double phaseTime[EVO_TIMER_COUNT];
+    double phaseCounters[EVO_TIMER_COUNT][EVO_COUNTER_COUNT];
+    evo_uint perfUnits;
+} RunRecord;
+extern RunRecord lastRun;
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
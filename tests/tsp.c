@@ -0,0 +1,93 @@
+#include <evo_select_tournament.h>
+#include <evo_problem_tsp.h>
+#include "tests.h"
+
+/*#define THREADS 16*/
+
+static int THREADS = 0;
+#define TRIALS 48
+#define MAX_ITERATIONS 1000
+#define POPULATION 500
+/* The seed the cities are numbered from, so every run gets the same instance. */
+#define INSTANCE_SEED 12345
+
+/* Number of cities. Can be overridden on the command line. */
+static evo_uint CITY_COUNT = 64;
+/* Random 2-opt moves tried on each child after breeding, only kept if they shorten the tour. */
+#define LOCAL_SEARCH_MOVES 16
+
+/* Which permutation crossover to use, named in the order of evo_TspCrossover. */
+static evo_TspCrossover CROSSOVER = EVO_TSP_PMX;
+static const char* crossoverNames[] = { "pmx", "ox", "cx" };
+
+TEST(tsp)
+{
+    double t;
+    evo_uint i;
+    evo_Stats* stats;
+    evo_Config* config;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "%s needs a thread count as an argument.\n", argv[1]);
+        fprintf(stderr, "Optionally followed by a crossover (pmx, ox, cx), and the number of cities.\n");
+        return -1;
+    }
+    THREADS = atoi(argv[2]);
+    if(argc > 3)
+    {
+        for(i = 0; i < sizeof(crossoverNames) / sizeof(crossoverNames[0]); i++)
+        {
+            if(!strcmp(argv[3], crossoverNames[i]))
+            {
+                break;
+            }
+        }
+        if(i == sizeof(crossoverNames) / sizeof(crossoverNames[0]))
+        {
+            fprintf(stderr, "Unknown crossover '%s'.\n", argv[3]);
+            return -1;
+        }
+        CROSSOVER = (evo_TspCrossover) i;
+    }
+    if(argc > 4)
+    {
+        CITY_COUNT = atoi(argv[4]);
+    }
+    if(CITY_COUNT < 4)
+    {
+        fprintf(stderr, "There need to be at least 4 cities.\n");
+        return -1;
+    }
+
+    config = evo_Config_New();
+    evo_Config_SetUnitCount(config, THREADS);
+    UseRunOptions(config);
+    evo_Config_SetRandomStreamCount(config, 48);
+    evo_Config_SetTrials(config, TRIALS);
+    evo_Config_SetMaxIterations(config, MAX_ITERATIONS);
+    evo_Config_SetPopulationSize(config, POPULATION);
+
+    evo_UseTsp(config, POPULATION, CITY_COUNT, LOCAL_SEARCH_MOVES, CROSSOVER, INSTANCE_SEED);
+    evo_UseTournamentSelection(config, POPULATION, 4);
+
+    StartTime();
+    evo_Config_Execute(config);
+    if(!evo_Config_IsUsed(config))
+    {
+        fprintf(stderr, "Could not use the given config.\n");
+        return 0;
+    }
+
+    t = EndTime();
+
+    stats = evo_Config_GetStats(config);
+    RecordStats(config);
+    printf("Failures %u/%u\n", stats->failures, stats->trials);
+    printf("Best fitness %lf\n", stats->bestFitness);
+    printf("%d threads took %lf seconds to find tours of %u cities (%s crossover).\n",
+        THREADS, t, CITY_COUNT, crossoverNames[CROSSOVER]);
+
+    evo_Config_Free(config);
+    return 0;
+}
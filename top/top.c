@@ -0,0 +1,233 @@
+/* nanosleep and isatty are POSIX, and not declared in strict C89 without this. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "evo_api.h"
+#include "evo_time.h"
+#include "evo_progress.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/*
+    evo-top: watches the progress page of a run (see evo_Config_SetProgressName), and shows
+    each unit's trials, the iteration its current trial is on, its best fitness, its evaluations
+    per second since the last refresh, and an estimate of how long it has left.
+
+    It only ever reads the page, which the units update without waiting on it,
+    so it doesn't slow the run down. It waits for the page to appear, and stops once the run is over.
+
+    A unit's estimate assumes the rest of its trials go as fast as the ones so far, counting
+    the trial it's on as done in proportion to its iterations. So it's pessimistic while trials
+    are ending early, until some have. The run's estimate is the slowest unit's.
+    Times are read from the same monotonic clock as the run's, which every process shares.
+*/
+
+#define MAX_UNITS 1024
+
+static void Usage(const char* program)
+{
+    fprintf(stderr, "Usage:\n    %s [OPTIONS] NAME\n", program);
+    fprintf(stderr, "\n    Watches the run publishing its progress as NAME (tests --progress NAME).\n");
+    fprintf(stderr, "\n    Options:\n");
+    fprintf(stderr, "        -i SECONDS Time between refreshes. (default 1)\n");
+    fprintf(stderr, "\n");
+}
+
+static void SleepSeconds(double seconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD) (seconds * 1000));
+#else
+    struct timespec t;
+    t.tv_sec = (time_t) seconds;
+    t.tv_nsec = (long) ((seconds - (double) t.tv_sec) * 1e9);
+    nanosleep(&t, NULL);
+#endif
+}
+
+/* Clears the terminal, so each refresh replaces the last. When the output isn't a terminal, they're just appended. */
+static void ClearScreen(void)
+{
+#ifndef _WIN32
+    if(isatty(1))
+    {
+        printf("\033[H\033[J");
+        return;
+    }
+#endif
+    printf("\n");
+}
+
+/* Writes seconds as h:mm:ss, or a dash when there's no estimate. */
+static void FormatSeconds(char* text, double seconds)
+{
+    unsigned long s;
+
+    if(seconds < 0)
+    {
+        strcpy(text, "-");
+        return;
+    }
+    s = (unsigned long) (seconds + 0.5);
+    sprintf(text, "%lu:%02lu:%02lu", s / 3600, s / 60 % 60, s % 60);
+}
+
+/* Seconds left for a unit that's spent elapsed seconds so far, or -1 if there's nothing to go on yet. */
+static double Remaining(const evo_ProgressHeader* header, const evo_ProgressUnit* unit, double elapsed)
+{
+    double done;
+
+    if(unit->done || unit->trials >= header->trialsPerUnit)
+    {
+        return 0;
+    }
+    done = (unit->trials + (double) unit->iteration / header->maxIterations) / header->trialsPerUnit;
+    if(done <= 0)
+    {
+        return -1;
+    }
+    return elapsed * (1 - done) / done;
+}
+
+static void Show(const char* name, const evo_ProgressHeader* header, const evo_ProgressUnit* units,
+    const double* rates, double elapsed, evo_bool finished)
+{
+    evo_uint i, trials;
+    double rate, remaining, runRemaining, bestFitness;
+    char elapsedText[32], remainingText[32], trialsText[32];
+
+    ClearScreen();
+    FormatSeconds(elapsedText, elapsed);
+    printf("evo-top: %s, %u units x %u trials, population %u, %u iterations at most",
+        name, header->unitCount, header->trialsPerUnit, header->populationSize, header->maxIterations);
+    if(header->laneCount)
+    {
+        printf(", %u lanes", header->laneCount);
+    }
+    printf("\n%s elapsed%s\n\n", elapsedText, finished ? ", finished" : "");
+    printf("%-6s %-20s %-10s %-14s %-12s %s\n", "unit", "trials", "iteration", "best fitness", "evals/s", "left");
+
+    trials = 0;
+    rate = 0;
+    bestFitness = 0;
+    runRemaining = 0;
+    for(i = 0; i < header->unitCount; i++)
+    {
+        remaining = Remaining(header, &units[i], elapsed);
+        FormatSeconds(remainingText, remaining);
+        sprintf(trialsText, "%u/%u", units[i].trials, header->trialsPerUnit);
+        printf("%-6u %-14s %4.0f%% %-10u %-14g %-12.4g %s\n", i, trialsText,
+            100.0 * units[i].trials / header->trialsPerUnit, units[i].iteration, units[i].bestFitness,
+            rates[i], units[i].done ? "done" : remainingText);
+        trials += units[i].trials;
+        rate += rates[i];
+        if(units[i].bestFitness > bestFitness)
+        {
+            bestFitness = units[i].bestFitness;
+        }
+        if(runRemaining >= 0 && (remaining < 0 || remaining > runRemaining))
+        {
+            runRemaining = remaining;
+        }
+    }
+    FormatSeconds(remainingText, runRemaining);
+    sprintf(trialsText, "%u/%u", trials, header->trialsPerUnit * header->unitCount);
+    printf("%-6s %-14s %4.0f%% %-10s %-14g %-12.4g %s\n", "all", trialsText,
+        100.0 * trials / (header->trialsPerUnit * header->unitCount), "", bestFitness, rate,
+        finished ? "done" : remainingText);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    evo_uint i;
+    int a;
+    double interval = 1;
+    const char* name;
+    evo_Progress* progress;
+    const evo_ProgressHeader* header;
+    evo_ProgressUnit* units;
+    double* lastEvaluations;
+    double* rates;
+    double now, lastTime;
+    evo_bool finished;
+
+    for(a = 1; a < argc && argv[a][0] == '-'; a++)
+    {
+        if(strcmp(argv[a], "-i") || a + 1 >= argc)
+        {
+            Usage(argv[0]);
+            return -1;
+        }
+        interval = atof(argv[++a]);
+        if(interval <= 0)
+        {
+            Usage(argv[0]);
+            return -1;
+        }
+    }
+    if(a + 1 != argc)
+    {
+        Usage(argv[0]);
+        return -1;
+    }
+    name = argv[a];
+
+    progress = evo_Progress_Open(name);
+    if(!progress)
+    {
+        printf("Waiting for %s...\n", name);
+        fflush(stdout);
+        while(!(progress = evo_Progress_Open(name)))
+        {
+            SleepSeconds(interval);
+        }
+    }
+    header = evo_Progress_GetHeader(progress);
+    if(!header->unitCount || header->unitCount > MAX_UNITS || !header->trialsPerUnit || !header->maxIterations)
+    {
+        fprintf(stderr, "evo-top: %s doesn't look like a run's progress page.\n", name);
+        evo_Progress_Close(progress);
+        return -1;
+    }
+
+    units = calloc(header->unitCount, sizeof(evo_ProgressUnit));
+    lastEvaluations = calloc(header->unitCount, sizeof(double));
+    rates = calloc(header->unitCount, sizeof(double));
+    /* The first rates are over the whole run so far. */
+    lastTime = header->startTime;
+    for(;;)
+    {
+        /* Read before the slots, so the last refresh has every unit's final numbers. */
+        finished = header->finished;
+        now = evo_WallTime();
+        for(i = 0; i < header->unitCount; i++)
+        {
+            /* A slot that's mid-update for too long keeps its last copy. */
+            evo_Progress_Read(progress, i, &units[i]);
+            rates[i] = (now > lastTime) ? (units[i].evaluations - lastEvaluations[i]) / (now - lastTime) : 0;
+            lastEvaluations[i] = units[i].evaluations;
+        }
+        lastTime = now;
+        Show(name, header, units, rates, now - header->startTime, finished);
+        if(finished)
+        {
+            break;
+        }
+        SleepSeconds(interval);
+    }
+
+    free(units);
+    free(lastEvaluations);
+    free(rates);
+    evo_Progress_Close(progress);
+    return 0;
+}